@@ -0,0 +1,59 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) in vec4 color;
+layout(location = 3) in uint textureSlot;
+
+uniform mat4 u_ViewProjection;
+
+out vec2 v_TexCoord;
+out vec4 v_Color;
+flat out uint v_TextureSlot;
+
+void main(){
+	v_TexCoord = texCoord;
+	v_Color = color;
+	v_TextureSlot = textureSlot;
+	gl_Position = u_ViewProjection * vec4(position, 0.0, 1.0);
+}
+
+#shader fragment
+#version 330 core
+
+in vec2 v_TexCoord;
+in vec4 v_Color;
+flat in uint v_TextureSlot;
+
+layout(location = 0) out vec4 color;
+
+// Slot 0 is a white texture for untextured quads
+uniform sampler2D u_Textures[16];
+
+// Indexing a sampler array with a value that isn't dynamically uniform is
+// undefined behaviour, so every slot gets its own constant index
+vec4 sampleSlot(uint slot, vec2 uv) {
+	switch (slot) {
+	case 0u: return texture(u_Textures[0], uv);
+	case 1u: return texture(u_Textures[1], uv);
+	case 2u: return texture(u_Textures[2], uv);
+	case 3u: return texture(u_Textures[3], uv);
+	case 4u: return texture(u_Textures[4], uv);
+	case 5u: return texture(u_Textures[5], uv);
+	case 6u: return texture(u_Textures[6], uv);
+	case 7u: return texture(u_Textures[7], uv);
+	case 8u: return texture(u_Textures[8], uv);
+	case 9u: return texture(u_Textures[9], uv);
+	case 10u: return texture(u_Textures[10], uv);
+	case 11u: return texture(u_Textures[11], uv);
+	case 12u: return texture(u_Textures[12], uv);
+	case 13u: return texture(u_Textures[13], uv);
+	case 14u: return texture(u_Textures[14], uv);
+	default: return texture(u_Textures[15], uv);
+	}
+}
+
+void main(){
+	color = v_Color * sampleSlot(v_TextureSlot, v_TexCoord);
+}
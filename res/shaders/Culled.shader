@@ -0,0 +1,54 @@
+#shader vertex
+#version 430 core
+#extension GL_ARB_shader_draw_parameters : enable
+
+// Draws the objects that survived the FrustumCuller, each one reads its
+// transform from the object buffer the culler tested
+
+layout(location = 0) in vec3 position;
+// The object's index, same as gl_BaseInstance
+layout(location = 1) in uint objectID;
+
+struct Object {
+	vec3 center;
+	float radius;
+	vec3 halfExtents;
+	uint indexCount;
+	uint firstIndex;
+	int baseVertex;
+	uint padding0;
+	uint padding1;
+};
+
+layout(std430, binding = 0) readonly buffer Objects {
+	Object objects[];
+};
+
+uniform mat4 u_ViewProjection;
+
+out vec3 v_Color;
+
+void main(){
+#ifdef GL_ARB_shader_draw_parameters
+	uint index = uint(gl_BaseInstanceARB);
+#else
+	uint index = objectID;
+#endif
+	Object object = objects[index];
+	// Cheap color from the index
+	uvec3 bytes = (uvec3(index * 0x9e3779b9u) >> uvec3(8u, 16u, 24u)) & 0xffu;
+	v_Color = 0.3 + 0.7 * vec3(bytes) / 255.0;
+	vec3 world = object.center + position * object.halfExtents;
+	gl_Position = u_ViewProjection * vec4(world, 1.0);
+}
+
+#shader fragment
+#version 430 core
+
+in vec3 v_Color;
+
+layout(location = 0) out vec4 color;
+
+void main(){
+	color = vec4(v_Color, 1.0);
+}
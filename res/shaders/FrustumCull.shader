@@ -0,0 +1,64 @@
+#shader compute
+#version 430 core
+
+// Appends a draw command for every object that's inside the frustum, see
+// FrustumCuller
+
+layout(local_size_x = 64) in;
+
+struct Object {
+	vec3 center;
+	float radius;
+	vec3 halfExtents;
+	uint indexCount;
+	uint firstIndex;
+	int baseVertex;
+	uint padding0;
+	uint padding1;
+};
+
+struct DrawCommand {
+	uint count;
+	uint instanceCount;
+	uint firstIndex;
+	int baseVertex;
+	uint baseInstance;
+};
+
+layout(std430, binding = 0) readonly buffer Objects {
+	Object objects[];
+};
+
+layout(std430, binding = 1) writeonly buffer Commands {
+	DrawCommand commands[];
+};
+
+layout(binding = 0, offset = 0) uniform atomic_uint visibleCount;
+
+// Left, right, bottom, top, near, far, pointing inwards
+uniform vec4 u_Planes[6];
+uniform uint u_ObjectCount;
+
+bool isVisible(Object object) {
+	for (int i = 0; i < 6; i++) {
+		float distance = dot(u_Planes[i].xyz, object.center) + u_Planes[i].w;
+		if (distance < -object.radius)
+			return false;
+		// How far the box reaches towards the plane
+		if (distance < -dot(abs(u_Planes[i].xyz), object.halfExtents))
+			return false;
+	}
+	return true;
+}
+
+void main(){
+	uint index = gl_GlobalInvocationID.x;
+	if (index >= u_ObjectCount)
+		return;
+	Object object = objects[index];
+	if (!isVisible(object))
+		return;
+	uint slot = atomicCounterIncrement(visibleCount);
+	commands[slot] = DrawCommand(object.indexCount, 1u, object.firstIndex,
+								 object.baseVertex, index);
+}
@@ -0,0 +1,39 @@
+#shader vertex
+#version 330 core
+
+// With INSTANCED defined the per-quad data comes from an instance buffer,
+// otherwise from uniforms set before every draw
+
+layout(location = 0) in vec2 position;
+#ifdef INSTANCED
+layout(location = 1) in vec2 offset;
+layout(location = 2) in float scale;
+layout(location = 3) in vec4 color;
+#else
+uniform vec2 u_Offset;
+uniform float u_Scale;
+uniform vec4 u_Color;
+#endif
+
+out vec4 v_Color;
+
+void main(){
+#ifdef INSTANCED
+	v_Color = color;
+	gl_Position = vec4(position * scale + offset, 0.0, 1.0);
+#else
+	v_Color = u_Color;
+	gl_Position = vec4(position * u_Scale + u_Offset, 0.0, 1.0);
+#endif
+}
+
+#shader fragment
+#version 330 core
+
+in vec4 v_Color;
+
+layout(location = 0) out vec4 color;
+
+void main(){
+	color = v_Color;
+}
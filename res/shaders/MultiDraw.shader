@@ -0,0 +1,45 @@
+#shader vertex
+#version 430 core
+#extension GL_ARB_shader_draw_parameters : enable
+
+layout(location = 0) in vec2 position;
+// The index of the draw, same as gl_BaseInstance (see DrawCommandBuffer)
+layout(location = 1) in uint drawID;
+
+struct DrawData {
+	// xy offset, z scale, w rotation
+	vec4 transform;
+	vec4 color;
+};
+
+layout(std430, binding = 0) readonly buffer Draws {
+	DrawData draws[];
+};
+
+uniform float u_Time;
+
+out vec4 v_Color;
+
+void main(){
+#ifdef GL_ARB_shader_draw_parameters
+	DrawData draw = draws[gl_BaseInstanceARB];
+#else
+	DrawData draw = draws[drawID];
+#endif
+	float angle = draw.transform.w + u_Time;
+	mat2 rotation = mat2(cos(angle), sin(angle), -sin(angle), cos(angle));
+	vec2 p = rotation * position * draw.transform.z + draw.transform.xy;
+	v_Color = draw.color;
+	gl_Position = vec4(p, 0.0, 1.0);
+}
+
+#shader fragment
+#version 430 core
+
+in vec4 v_Color;
+
+layout(location = 0) out vec4 color;
+
+void main(){
+	color = v_Color;
+}
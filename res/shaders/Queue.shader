@@ -0,0 +1,34 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec2 position;
+
+// xy offset, z scale, w depth
+uniform vec4 u_Transform;
+
+out vec2 v_TexCoord;
+
+void main(){
+	v_TexCoord = position * 0.5 + 0.5;
+	gl_Position = vec4(position * u_Transform.z + u_Transform.xy,
+					   u_Transform.w * 2.0 - 1.0, 1.0);
+}
+
+#shader fragment
+#version 330 core
+
+// Set with ApplyDefines to build a few programs that look different
+#ifndef VARIANT
+#define VARIANT 0
+#endif
+
+in vec2 v_TexCoord;
+
+uniform sampler2D u_Texture;
+
+layout(location = 0) out vec4 color;
+
+void main(){
+	vec3 tint = fract(float(VARIANT) * vec3(0.37, 0.61, 0.83)) * 0.5 + 0.5;
+	color = texture(u_Texture, v_TexCoord) * vec4(tint, 1.0);
+}
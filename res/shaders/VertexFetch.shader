@@ -0,0 +1,27 @@
+#shader vertex
+#version 410 core
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+layout(location = 2) in vec2 uv;
+layout(location = 3) in vec4 color;
+
+out vec4 v_Color;
+
+void main(){
+	// Use every attribute so none of them gets optimized out
+	float light = max(dot(normalize(normal), vec3(0.0, 0.0, 1.0)), 0.0);
+	v_Color = color * light + vec4(uv, 0.0, 0.0);
+	gl_Position = vec4(position, 1.0);
+	gl_PointSize = 1.0;
+}
+
+#shader fragment
+#version 410 core
+
+in vec4 v_Color;
+layout(location = 0) out vec4 color;
+
+void main(){
+	color = v_Color;
+}
@@ -0,0 +1,151 @@
+#include "batchrenderer.h"
+
+#include "renderer.h"
+#include "shadercompiler.h"
+#include "shadersource.h"
+
+#include <algorithm>
+#include <numeric>
+#include <optional>
+
+using namespace gl;
+
+namespace {
+
+// Two triangles per quad, the same pattern for every quad
+std::vector<std::uint32_t> QuadIndices(unsigned int maxQuads) {
+	std::vector<std::uint32_t> indices(static_cast<size_t>(maxQuads) * 6);
+	for (std::uint32_t quad = 0; quad < maxQuads; quad++) {
+		std::uint32_t vertex = quad * 4;
+		std::uint32_t *out = &indices[quad * 6];
+		// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+		out[0] = vertex;
+		out[1] = vertex + 1;
+		out[2] = vertex + 2;
+		out[3] = vertex + 2;
+		out[4] = vertex + 3;
+		out[5] = vertex;
+		// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+	}
+	return indices;
+}
+
+unsigned int LoadBatchShader(const std::string &path) {
+	ShaderLibrary library;
+	std::optional<ShaderSource> source = library.parse(path);
+	if (!source)
+		return 0;
+	return CreateProgram(source->str(ShaderStage::VERTEX),
+						 source->str(ShaderStage::FRAGMENT));
+}
+
+std::uint8_t ToUnorm8(float value) {
+	return static_cast<std::uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f +
+									 0.5f);
+}
+
+} // namespace
+
+BatchRenderer::BatchRenderer(unsigned int maxQuads,
+							 const std::string &shaderPath)
+	: m_maxQuads(maxQuads), m_shader(LoadBatchShader(shaderPath)),
+	  m_vertexBuffer(nullptr,
+					 static_cast<unsigned int>(maxQuads * 4 * sizeof(Vertex))),
+	  m_indexBuffer(QuadIndices(maxQuads)) {
+	m_vertexArray.addBuffer<Layout>(m_vertexBuffer);
+	m_vertexArray.setIndexBuffer(m_indexBuffer);
+	m_vertices.reserve(static_cast<size_t>(maxQuads) * 4);
+
+	// Sampling it gives the quad's color unchanged
+	const std::uint32_t white = 0xffffffff;
+	GLCall(glGenTextures(1, &m_whiteTexture));
+	GLState::get().bindTexture(0, GL_TEXTURE_2D, m_whiteTexture);
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(GL_RGBA8), 1, 1,
+						0, GL_RGBA, GL_UNSIGNED_BYTE, &white));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+						   static_cast<GLint>(GL_NEAREST)));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
+						   static_cast<GLint>(GL_NEAREST)));
+	m_textures[0] = m_whiteTexture;
+
+	std::array<int, kTextureSlots> units{};
+	std::iota(units.begin(), units.end(), 0);
+	m_shader.bind();
+	m_shader.setUniform("u_Textures", units.data(), units.size());
+}
+
+BatchRenderer::~BatchRenderer() {
+	GLState::get().onTextureDeleted(m_whiteTexture);
+	GLCall(glDeleteTextures(1, &m_whiteTexture));
+}
+
+void BatchRenderer::begin(const std::array<float, 16> &viewProjection) {
+	m_shader.bind();
+	m_shader.setUniform("u_ViewProjection", viewProjection);
+	m_vertices.clear();
+	m_textureCount = 1;
+}
+
+std::uint32_t BatchRenderer::getTextureSlot(unsigned int texture) {
+	if (texture == 0)
+		return 0;
+	// There are only a handful of slots, a linear search is the fastest
+	for (std::uint32_t slot = 1; slot < m_textureCount; slot++) {
+		if (m_textures[slot] == texture)
+			return slot;
+	}
+	if (m_textureCount == kTextureSlots) {
+		m_stats.textureFlushes++;
+		flush();
+	}
+	m_textures[m_textureCount] = texture;
+	return m_textureCount++;
+}
+
+void BatchRenderer::drawQuad(const std::array<float, 2> &position,
+							 const std::array<float, 2> &size,
+							 const std::array<float, 4> &color,
+							 unsigned int texture) {
+	if (m_vertices.size() == static_cast<size_t>(m_maxQuads) * 4)
+		flush();
+	std::uint32_t slot = getTextureSlot(texture);
+
+	std::array<std::uint8_t, 4> packed{ToUnorm8(color[0]), ToUnorm8(color[1]),
+									   ToUnorm8(color[2]), ToUnorm8(color[3])};
+	float x0 = position[0];
+	float y0 = position[1];
+	float x1 = x0 + size[0];
+	float y1 = y0 + size[1];
+	m_vertices.push_back({{x0, y0}, {0.0f, 0.0f}, packed, slot});
+	m_vertices.push_back({{x1, y0}, {1.0f, 0.0f}, packed, slot});
+	m_vertices.push_back({{x1, y1}, {1.0f, 1.0f}, packed, slot});
+	m_vertices.push_back({{x0, y1}, {0.0f, 1.0f}, packed, slot});
+	m_stats.quads++;
+}
+
+void BatchRenderer::end() {
+	flush();
+}
+
+void BatchRenderer::flush() {
+	if (!m_vertices.empty()) {
+		m_vertexBuffer.setData(
+			m_vertices.data(),
+			static_cast<unsigned int>(m_vertices.size() * sizeof(Vertex)));
+
+		GLState &state = GLState::get();
+		for (unsigned int slot = 0; slot < m_textureCount; slot++)
+			state.bindTexture(slot, GL_TEXTURE_2D, m_textures[slot]);
+
+		m_shader.bind();
+		m_vertexArray.bind();
+		state.setPrimitiveRestart(false, 0);
+		auto count = static_cast<GLsizei>(m_vertices.size() / 4 * 6);
+		GLCall(glDrawElements(GL_TRIANGLES, count, m_indexBuffer.GetType(),
+							  nullptr));
+		m_stats.drawCalls++;
+	}
+
+	m_vertices.clear();
+	m_textureCount = 1;
+}
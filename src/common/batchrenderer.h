@@ -0,0 +1,94 @@
+#pragma once
+#include "indexbuffer.h"
+#include "shader.h"
+#include "vertexarray.h"
+#include "vertexbuffer.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Draws lots of 2D quads with as few draw calls as possible. Quads are
+// collected into a CPU side vertex array and drawn in batches of up to
+// maxQuads with one glDrawElements each, using a shared index buffer that's
+// filled once. Up to kTextureSlots textures can be mixed in a batch, a quad
+// using a texture that isn't in the batch only starts a new batch once all
+// the slots are taken.
+//
+// Usage:
+//   BatchRenderer batch;
+//   while (...) {
+//       batch.begin(viewProjection);
+//       batch.drawQuad({x, y}, {w, h}, {r, g, b, a}, texture);
+//       ...
+//       batch.end();
+//   }
+class BatchRenderer {
+  public:
+	// The minimum GL_MAX_TEXTURE_IMAGE_UNITS
+	static constexpr unsigned int kTextureSlots = 16;
+
+	struct Vertex {
+		std::array<float, 2> position;
+		std::array<float, 2> texCoord;
+		std::array<std::uint8_t, 4> color;
+		std::uint32_t textureSlot;
+	};
+	using Layout = VertexLayout<Attr<float, 2>, Attr<float, 2>,
+								Attr<std::uint8_t, 4, true>,
+								Attr<std::uint32_t, 1>>;
+	static_assert(Layout::matches<Vertex>());
+
+	struct Stats {
+		unsigned long quads = 0;
+		unsigned long drawCalls = 0;
+		// Batches that were drawn early because every texture slot was taken
+		unsigned long textureFlushes = 0;
+	};
+
+  private:
+	unsigned int m_maxQuads;
+	Shader m_shader;
+	VertexArray m_vertexArray;
+	VertexBuffer m_vertexBuffer;
+	IndexBuffer m_indexBuffer;
+	unsigned int m_whiteTexture = 0;
+
+	std::vector<Vertex> m_vertices;
+	// Slot 0 is always the white texture
+	std::array<unsigned int, kTextureSlots> m_textures{};
+	unsigned int m_textureCount = 1;
+	Stats m_stats;
+
+	void flush();
+	std::uint32_t getTextureSlot(unsigned int texture);
+
+  public:
+	// The shader has to follow res/shaders/Batch.shader
+	explicit BatchRenderer(unsigned int maxQuads = 65536,
+						   const std::string &shaderPath =
+							   "res/shaders/Batch.shader");
+	BatchRenderer(const BatchRenderer &other) = delete;
+	BatchRenderer operator=(const BatchRenderer &other) = delete;
+	~BatchRenderer();
+
+	// viewProjection is column major
+	void begin(const std::array<float, 16> &viewProjection);
+	// texture is a GL_TEXTURE_2D, 0 draws the quad in a flat color
+	void drawQuad(const std::array<float, 2> &position,
+				  const std::array<float, 2> &size,
+				  const std::array<float, 4> &color, unsigned int texture = 0);
+	// Draws whatever is left
+	void end();
+
+	[[nodiscard]] inline bool isValid() const {
+		return m_shader.GetRendererID() != 0;
+	}
+	[[nodiscard]] inline const Stats &getStats() const {
+		return m_stats;
+	}
+	inline void resetStats() {
+		m_stats = {};
+	}
+};
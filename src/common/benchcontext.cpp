@@ -0,0 +1,46 @@
+#include "benchcontext.h"
+
+#include "renderer.h"
+
+#include <glbinding/glbinding.h>
+#include <iostream>
+
+using namespace gl;
+
+BenchContext::BenchContext(int argc, char **argv, const FrameBenchmark &bench,
+						   std::string_view title, int major, int minor,
+						   int width, int height)
+	: m_options(GLFWObjects::LaunchOptions::parse(argc, argv)) {
+	GLDebugMode debugMode = GLDebugModeFromArgs(argc, argv);
+
+	GLFWObjects::GLFW &glfw = GLFWObjects::GLFW::getInstance();
+	if (!glfw.init(m_options.backend))
+		return;
+
+	glfw.setWindowHint(GLFWObjects::GLFW::WindowHint::CONTEXT_VERSION_MAJOR,
+					   major);
+	glfw.setWindowHint(GLFWObjects::GLFW::WindowHint::CONTEXT_VERSION_MINOR,
+					   minor);
+	glfw.setWindowHint(GLFWObjects::GLFW::WindowHint::OPENGL_PROFILE,
+					   GLFWObjects::GLFW::OpenGL_Profile::OPENGL_CORE_PROFILE);
+	glfw.setWindowHint(GLFWObjects::GLFW::WindowHint::OPENGL_DEBUG_CONTEXT,
+					   debugMode != GLDebugMode::OFF);
+
+	GLFWObjects::Window &window = m_window.emplace(width, height, title);
+	if (!window.isValid()) {
+		m_window.reset();
+		return;
+	}
+	window.setFrameLimit(bench.isEnabled() ? 0 : m_options.frameLimit);
+	glfw.makeContextCurrent(window);
+	glfwSwapInterval(bench.isEnabled() ? 0 : 1);
+
+	glbinding::initialize(glfwGetProcAddress);
+	std::cerr << glGetString(GL_VERSION) << std::endl;
+	GLDebugInit(debugMode);
+
+	if (window.isHeadless()) {
+		m_offscreen.emplace(width, height);
+		m_offscreen->bind();
+	}
+}
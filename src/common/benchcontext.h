@@ -0,0 +1,45 @@
+#pragma once
+#include "benchmark.h"
+#include "framebuffer.h"
+#include "pr_glfw.h"
+
+#include <optional>
+#include <string_view>
+
+// The startup every Bench-* executable shares: parses the launch options and
+// --gl-debug, creates a core profile window (or headless context) of the given
+// version, makes it current, loads the GL functions, prints the GL version to
+// stderr, sets up the debug output and binds an offscreen Framebuffer when
+// running headless. Vsync is off while benchmarking, callers that never want
+// it can call glfwSwapInterval(0) afterwards.
+//
+// Usage:
+//   FrameBenchmark bench(argc, argv);
+//   BenchContext context(argc, argv, bench, "Bench-Foo", 4, 3);
+//   if (!context.isValid())
+//       return -1;
+//   GLFWObjects::Window &window = context.getWindow();
+class BenchContext {
+  private:
+	GLFWObjects::LaunchOptions m_options;
+	std::optional<GLFWObjects::Window> m_window;
+	// Declared after the window so it's deleted while the context is alive
+	std::optional<Framebuffer> m_offscreen;
+
+  public:
+	BenchContext(int argc, char **argv, const FrameBenchmark &bench,
+				 std::string_view title, int major = 3, int minor = 3,
+				 int width = 640, int height = 480);
+	BenchContext(const BenchContext &other) = delete;
+	BenchContext operator=(const BenchContext &other) = delete;
+
+	[[nodiscard]] inline bool isValid() const {
+		return m_window.has_value();
+	};
+	[[nodiscard]] inline GLFWObjects::Window &getWindow() {
+		return *m_window;
+	};
+	[[nodiscard]] inline const GLFWObjects::LaunchOptions &getOptions() const {
+		return m_options;
+	};
+};
@@ -0,0 +1,96 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <numeric>
+#include <string_view>
+
+unsigned long GetArgValue(int argc, char **argv, std::string_view prefix,
+						  unsigned long fallback) {
+	std::string_view value = GetArgString(argc, argv, prefix, {});
+	if (value.empty())
+		return fallback;
+	return std::strtoul(std::string(value).c_str(), nullptr, 10);
+}
+
+std::string_view GetArgString(int argc, char **argv, std::string_view prefix,
+							  std::string_view fallback) {
+	for (int i = 1; i < argc; i++) {
+		std::string_view arg(argv[i]); // NOLINT
+		if (arg.rfind(prefix, 0) == 0)
+			return arg.substr(prefix.size());
+	}
+	return fallback;
+}
+
+bool HasArg(int argc, char **argv, std::string_view name) {
+	for (int i = 1; i < argc; i++) {
+		if (std::string_view(argv[i]) == name) // NOLINT
+			return true;
+	}
+	return false;
+}
+
+FrameBenchmark::FrameBenchmark(int argc, char **argv) {
+	if (argc > 0) {
+		// Use the executable name to tell the results apart
+		std::string_view path(argv[0]); // NOLINT
+		auto slash = path.find_last_of("/\\");
+		m_name = path.substr(slash == std::string_view::npos ? 0 : slash + 1);
+	}
+
+	m_enabled = HasArg(argc, argv, "--bench");
+	m_warmupFrames = static_cast<unsigned int>(
+		GetArgValue(argc, argv, "--warmup=", m_warmupFrames));
+	m_measuredFrames = static_cast<unsigned int>(
+		GetArgValue(argc, argv, "--measure=", m_measuredFrames));
+
+	if (m_enabled)
+		m_frameTimes.reserve(m_measuredFrames);
+	m_lastFrameEnd = Clock::now();
+}
+
+void FrameBenchmark::endFrame() {
+	if (!m_enabled)
+		return;
+
+	Clock::time_point now = Clock::now();
+	if (m_frameCount >= m_warmupFrames && !isDone()) {
+		std::chrono::duration<double, std::milli> frameTime =
+			now - m_lastFrameEnd;
+		m_frameTimes.push_back(frameTime.count());
+	}
+	m_frameCount++;
+	m_lastFrameEnd = now;
+}
+
+void FrameBenchmark::report(std::ostream &out) const {
+	if (!m_enabled || m_frameTimes.empty())
+		return;
+
+	std::vector<double> sorted(m_frameTimes);
+	std::sort(sorted.begin(), sorted.end());
+
+	// Nearest rank percentile
+	auto percentile = [&sorted](double p) {
+		auto rank = static_cast<size_t>(
+			std::ceil(p / 100.0 * static_cast<double>(sorted.size())));
+		return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+	};
+
+	double total = std::accumulate(sorted.begin(), sorted.end(), 0.0);
+	double mean = total / static_cast<double>(sorted.size());
+
+	out << "{\"name\": \"" << m_name << "\", "
+		<< "\"warmup_frames\": " << m_warmupFrames << ", "
+		<< "\"measured_frames\": " << sorted.size() << ", "
+		<< "\"cpu_frame_time_ms\": {"
+		<< "\"min\": " << sorted.front() << ", "
+		<< "\"median\": " << percentile(50.0) << ", "
+		<< "\"p95\": " << percentile(95.0) << ", "
+		<< "\"p99\": " << percentile(99.0) << ", "
+		<< "\"max\": " << sorted.back() << ", "
+		<< "\"mean\": " << mean << "}, "
+		<< "\"fps\": " << 1000.0 / mean << "}" << std::endl;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Returns the value of a "--name=value" command line argument, or fallback
+// if it isn't there. prefix includes the "=".
+unsigned long GetArgValue(int argc, char **argv, std::string_view prefix,
+						  unsigned long fallback);
+std::string_view GetArgString(int argc, char **argv, std::string_view prefix,
+							  std::string_view fallback);
+// Whether a flag like "--name" was passed
+bool HasArg(int argc, char **argv, std::string_view name);
+
+// Measures the CPU time between consecutive frames of a render loop.
+// Enabled with --bench, the first --warmup=N frames (default 100) are thrown
+// away and the next --measure=M frames (default 1000) are recorded, after that
+// isDone() returns true so the render loop can exit and report the results.
+//
+// Usage:
+//   FrameBenchmark bench(argc, argv);
+//   glfwSwapInterval(bench.isEnabled() ? 0 : 1);
+//   while (!glfwWindowShouldClose(window) && !bench.isDone()) {
+//       ...
+//       glfwSwapBuffers(window);
+//       bench.endFrame();
+//   }
+//   bench.report(std::cout);
+class FrameBenchmark {
+  private:
+	using Clock = std::chrono::steady_clock;
+
+	std::string m_name;
+	bool m_enabled = false;
+	unsigned int m_warmupFrames = 100;
+	unsigned int m_measuredFrames = 1000;
+	unsigned int m_frameCount = 0;
+	Clock::time_point m_lastFrameEnd;
+	// Frame times in milliseconds
+	std::vector<double> m_frameTimes;
+
+  public:
+	FrameBenchmark(int argc, char **argv);
+
+	// Call right after swapping the buffers
+	void endFrame();
+
+	[[nodiscard]] inline bool isEnabled() const {
+		return m_enabled;
+	};
+	[[nodiscard]] inline bool isDone() const {
+		return m_enabled && m_frameTimes.size() >= m_measuredFrames;
+	};
+
+	// Writes the results as a single JSON object, does nothing if the
+	// benchmark isn't enabled
+	void report(std::ostream &out) const;
+};
@@ -0,0 +1,132 @@
+#include "bufferarena.h"
+
+#include "deletionqueue.h"
+#include "renderer.h"
+
+#include <limits>
+#include <vector>
+
+using namespace gl;
+
+namespace {
+
+// How many units fit in capacity, checked before the member initializers
+// divide by it
+std::uint32_t UnitCount(std::size_t capacity, std::size_t unitSize) {
+	ASSERT(unitSize > 0);
+	ASSERT(capacity / unitSize <= std::numeric_limits<std::uint32_t>::max());
+	return static_cast<std::uint32_t>(capacity / unitSize);
+}
+
+} // namespace
+
+BufferArena::BufferArena(std::size_t capacity, std::size_t unitSize)
+	: m_unitSize(unitSize), m_ranges(UnitCount(capacity, unitSize)) {
+	auto size = static_cast<GLsizeiptr>(m_ranges.GetCapacity() * unitSize);
+
+	GLint major = 0;
+	GLint minor = 0;
+	GLCall(glGetIntegerv(GL_MAJOR_VERSION, &major));
+	GLCall(glGetIntegerv(GL_MINOR_VERSION, &minor));
+	bool immutable = major > 4 || (major == 4 && minor >= 4) ||
+					 GLHasExtension("GL_ARB_buffer_storage");
+
+	GLCall(glGenBuffers(1, &m_rendererID));
+	// Not GL_ELEMENT_ARRAY_BUFFER, that belongs to the bound VAO
+	GLState::get().bindBuffer(GL_COPY_WRITE_BUFFER, m_rendererID);
+	if (immutable) {
+		GLCall(glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr,
+							   GL_DYNAMIC_STORAGE_BIT));
+	} else {
+		GLCall(glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr,
+							GL_STATIC_DRAW));
+	}
+}
+
+BufferArena::~BufferArena() {
+	DeletionQueue::get().enqueueBuffer(m_rendererID);
+}
+
+BufferArena::Handle BufferArena::allocate(std::size_t size) {
+	std::size_t units = (size + m_unitSize - 1) / m_unitSize;
+	if (units == 0 || units > m_ranges.GetCapacity())
+		return kInvalid;
+	return m_ranges.allocate(static_cast<std::uint32_t>(units));
+}
+
+void BufferArena::free(Handle handle) {
+	m_ranges.free(handle);
+}
+
+void BufferArena::upload(Handle handle, const void *data, std::size_t size,
+						 std::size_t offset) {
+	ASSERT(offset + size <= GetSize(handle));
+	auto glOffset = static_cast<GLintptr>(GetOffset(handle) + offset);
+	auto glSize = static_cast<GLsizeiptr>(size);
+	GLState &state = GLState::get();
+	if (state.hasDirectStateAccess()) {
+		GLCall(glNamedBufferSubData(m_rendererID, glOffset, glSize, data));
+		return;
+	}
+	state.bindBuffer(GL_COPY_WRITE_BUFFER, m_rendererID);
+	GLCall(glBufferSubData(GL_COPY_WRITE_BUFFER, glOffset, glSize, data));
+}
+
+std::size_t BufferArena::defragment() {
+	std::vector<RangeAllocator::Move> moves = m_ranges.defragment();
+	m_defragmentations++;
+	if (moves.empty())
+		return 0;
+
+	// Everything from the first allocation that moved on moves, into one
+	// contiguous run. Copying a buffer onto an overlapping range of itself
+	// isn't allowed, so the run goes through a scratch buffer and comes back
+	// in a single copy.
+	std::size_t begin = moves.front().to * m_unitSize;
+	const RangeAllocator::Move &last = moves.back();
+	std::size_t end = (last.to + last.size) * m_unitSize;
+
+	GLState &state = GLState::get();
+	unsigned int scratch = 0;
+	GLCall(glGenBuffers(1, &scratch));
+	state.bindBuffer(GL_COPY_WRITE_BUFFER, scratch);
+	GLCall(glBufferData(GL_COPY_WRITE_BUFFER,
+						static_cast<GLsizeiptr>(end - begin), nullptr,
+						GL_STREAM_COPY));
+	state.bindBuffer(GL_COPY_READ_BUFFER, m_rendererID);
+	for (const RangeAllocator::Move &move : moves) {
+		GLCall(glCopyBufferSubData(
+			GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+			static_cast<GLintptr>(move.from * m_unitSize),
+			static_cast<GLintptr>(move.to * m_unitSize - begin),
+			static_cast<GLsizeiptr>(move.size * m_unitSize)));
+	}
+	state.bindBuffer(GL_COPY_READ_BUFFER, scratch);
+	state.bindBuffer(GL_COPY_WRITE_BUFFER, m_rendererID);
+	GLCall(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0,
+							   static_cast<GLintptr>(begin),
+							   static_cast<GLsizeiptr>(end - begin)));
+	// Deleting it right behind the copies can make the driver wait for them
+	DeletionQueue::get().enqueueBuffer(scratch);
+
+	m_bytesMoved += end - begin;
+	return end - begin;
+}
+
+void BufferArena::bind(GLenum target) const {
+	GLState::get().bindBuffer(target, m_rendererID);
+}
+
+BufferArena::Stats BufferArena::getStats() const {
+	RangeAllocator::Stats ranges = m_ranges.getStats();
+	Stats stats;
+	stats.capacity = ranges.capacity * m_unitSize;
+	stats.used = ranges.used * m_unitSize;
+	stats.largestFree = ranges.largestFree * m_unitSize;
+	stats.allocations = ranges.allocations;
+	stats.freeRanges = ranges.freeRanges;
+	stats.fragmentation = ranges.fragmentation;
+	stats.defragmentations = m_defragmentations;
+	stats.bytesMoved = m_bytesMoved;
+	return stats;
+}
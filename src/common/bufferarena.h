@@ -0,0 +1,92 @@
+#pragma once
+#include <glbinding/gl/gl.h>
+
+#include "rangeallocator.h"
+
+#include <cstddef>
+
+// One big GL buffer that many meshes share, so drawing them doesn't need a
+// buffer object, or a VAO, each. Ranges are handed out by a RangeAllocator
+// (TLSF) in units of unitSize bytes, so every range starts at a multiple of
+// it: with the vertex stride as the unit a range's first element is the
+// base vertex of its mesh, with the index size it's the first index.
+// VertexBuffer and IndexBuffer have constructors that place their data into
+// an arena instead of creating a buffer.
+//
+// The storage is immutable (glBufferStorage) with GL 4.4 or
+// ARB_buffer_storage, so its size never changes. Every VAO pointing at the
+// arena keeps working through defragment(), which moves the data inside the
+// same buffer.
+//
+// The arena has to outlive the buffers allocated from it.
+class BufferArena {
+  public:
+	using Handle = RangeAllocator::Handle;
+	static constexpr Handle kInvalid = RangeAllocator::kInvalid;
+
+	struct Stats {
+		// In bytes
+		std::size_t capacity = 0;
+		std::size_t used = 0;
+		std::size_t largestFree = 0;
+		unsigned int allocations = 0;
+		unsigned int freeRanges = 0;
+		// 1 - largestFree / free: 0 when all the free space is in one piece
+		double fragmentation = 0.0;
+		unsigned long defragmentations = 0;
+		std::size_t bytesMoved = 0;
+	};
+
+  private:
+	unsigned int m_rendererID = 0;
+	std::size_t m_unitSize;
+	RangeAllocator m_ranges;
+	unsigned long m_defragmentations = 0;
+	std::size_t m_bytesMoved = 0;
+
+  public:
+	// capacity is rounded down to a multiple of unitSize
+	BufferArena(std::size_t capacity, std::size_t unitSize);
+	// Buffers allocated from it keep a pointer to it
+	BufferArena(const BufferArena &other) = delete;
+	BufferArena(BufferArena &&other) = delete;
+	BufferArena operator=(const BufferArena &other) = delete;
+	BufferArena &operator=(BufferArena &&other) = delete;
+	~BufferArena();
+
+	// size bytes rounded up to a multiple of the unit size, kInvalid if
+	// there isn't a free range that big
+	[[nodiscard]] Handle allocate(std::size_t size);
+	void free(Handle handle);
+	// Writes size bytes at offset into the allocation
+	void upload(Handle handle, const void *data, std::size_t size,
+				std::size_t offset = 0);
+
+	// Packs the allocations towards the start of the buffer, copying the
+	// data on the GPU through a temporary buffer, so all the free space is
+	// in one piece. Offsets, base
+	// vertices and first indices change, anything that stored them (e.g. a
+	// DrawCommandBuffer) has to be filled again. Returns the bytes moved.
+	std::size_t defragment();
+
+	void bind(gl::GLenum target) const;
+
+	// In bytes from the start of the buffer
+	[[nodiscard]] inline std::size_t GetOffset(Handle handle) const {
+		return m_ranges.GetOffset(handle) * m_unitSize;
+	};
+	[[nodiscard]] inline std::size_t GetSize(Handle handle) const {
+		return m_ranges.GetSize(handle) * m_unitSize;
+	};
+	// The offset in units, i.e. the base vertex or first index
+	[[nodiscard]] inline unsigned int GetFirstElement(Handle handle) const {
+		return m_ranges.GetOffset(handle);
+	};
+	[[nodiscard]] inline unsigned int GetRendererID() const {
+		return m_rendererID;
+	};
+	[[nodiscard]] inline std::size_t GetUnitSize() const {
+		return m_unitSize;
+	};
+	[[nodiscard]] Stats getStats() const;
+};
@@ -0,0 +1,168 @@
+#include "commandlist.h"
+
+#include "indexbuffer.h"
+#include "renderer.h"
+
+#include <array>
+#include <new>
+
+using namespace gl;
+
+enum class CommandType : std::uint8_t {
+	BIND_PROGRAM,
+	BIND_VERTEX_ARRAY,
+	BIND_TEXTURE,
+	SET_UNIFORM_4F,
+	DRAW_INDEXED
+};
+
+// Every command starts with one, the type tells which struct follows
+struct CommandList::CommandHeader {
+	CommandType type;
+	CommandHeader *next;
+};
+
+namespace {
+
+struct BindProgramCommand {
+	static constexpr CommandType kType = CommandType::BIND_PROGRAM;
+	CommandList::CommandHeader header;
+	Shader *shader;
+};
+
+struct BindVertexArrayCommand {
+	static constexpr CommandType kType = CommandType::BIND_VERTEX_ARRAY;
+	CommandList::CommandHeader header;
+	unsigned int vertexArray;
+};
+
+struct BindTextureCommand {
+	static constexpr CommandType kType = CommandType::BIND_TEXTURE;
+	CommandList::CommandHeader header;
+	unsigned int unit;
+	unsigned int texture;
+};
+
+struct SetUniform4fCommand {
+	static constexpr CommandType kType = CommandType::SET_UNIFORM_4F;
+	CommandList::CommandHeader header;
+	Shader *shader;
+	UniformName name{""};
+	std::array<float, 4> values;
+};
+
+struct DrawIndexedCommand {
+	static constexpr CommandType kType = CommandType::DRAW_INDEXED;
+	CommandList::CommandHeader header;
+	GLenum type;
+	std::uint32_t count;
+	std::uint32_t firstIndex;
+	std::int32_t baseVertex;
+	bool primitiveRestart;
+};
+
+// The header is the first member of every command
+template <typename Command>
+const Command &As(const CommandList::CommandHeader *header) {
+	return *reinterpret_cast<const Command *>(header); // NOLINT
+}
+
+} // namespace
+
+CommandList::CommandList(std::size_t blockSize) : m_allocator(blockSize) {}
+
+template <typename Command> Command *CommandList::push() {
+	void *memory = m_allocator.allocate(sizeof(Command), alignof(Command));
+	auto *command = new (memory) Command{};
+	command->header = {Command::kType, nullptr};
+	if (m_last)
+		m_last->next = &command->header;
+	else
+		m_first = &command->header;
+	m_last = &command->header;
+	m_count++;
+	return command;
+}
+
+void CommandList::bindProgram(Shader &shader) {
+	push<BindProgramCommand>()->shader = &shader;
+	m_shader = &shader;
+}
+
+void CommandList::bindVertexArray(unsigned int vertexArray) {
+	push<BindVertexArrayCommand>()->vertexArray = vertexArray;
+}
+
+void CommandList::bindTexture(unsigned int unit, unsigned int texture) {
+	auto *command = push<BindTextureCommand>();
+	command->unit = unit;
+	command->texture = texture;
+}
+
+void CommandList::setUniform(UniformName name, float x, float y, float z,
+							 float w) {
+	ASSERT(m_shader != nullptr);
+	auto *command = push<SetUniform4fCommand>();
+	command->shader = m_shader;
+	command->name = name;
+	command->values = {x, y, z, w};
+}
+
+void CommandList::drawIndexed(GLenum type, std::uint32_t count,
+							  std::uint32_t firstIndex,
+							  std::int32_t baseVertex, bool primitiveRestart) {
+	auto *command = push<DrawIndexedCommand>();
+	command->type = type;
+	command->count = count;
+	command->firstIndex = firstIndex;
+	command->baseVertex = baseVertex;
+	command->primitiveRestart = primitiveRestart;
+}
+
+void CommandList::execute() const {
+	GLState &state = GLState::get();
+	for (const CommandHeader *header = m_first; header;
+		 header = header->next) {
+		switch (header->type) {
+		case CommandType::BIND_PROGRAM:
+			As<BindProgramCommand>(header).shader->bind();
+			break;
+		case CommandType::BIND_VERTEX_ARRAY:
+			state.bindVertexArray(
+				As<BindVertexArrayCommand>(header).vertexArray);
+			break;
+		case CommandType::BIND_TEXTURE: {
+			const auto &command = As<BindTextureCommand>(header);
+			state.bindTexture(command.unit, GL_TEXTURE_2D, command.texture);
+			break;
+		}
+		case CommandType::SET_UNIFORM_4F: {
+			const auto &command = As<SetUniform4fCommand>(header);
+			command.shader->setUniform(command.name, command.values[0],
+									   command.values[1], command.values[2],
+									   command.values[3]);
+			break;
+		}
+		case CommandType::DRAW_INDEXED: {
+			const auto &command = As<DrawIndexedCommand>(header);
+			state.setPrimitiveRestart(command.primitiveRestart,
+									  GetIndexTypeRestartIndex(command.type));
+			// The offset into the index buffer is passed as a pointer
+			const void *offset = reinterpret_cast<const void *>( // NOLINT
+				command.firstIndex * GetIndexTypeSize(command.type));
+			GLCall(glDrawElementsBaseVertex(
+				GL_TRIANGLES, static_cast<GLsizei>(command.count),
+				command.type, offset, command.baseVertex));
+			break;
+		}
+		}
+	}
+}
+
+void CommandList::reset() {
+	m_allocator.reset();
+	m_first = nullptr;
+	m_last = nullptr;
+	m_count = 0;
+	m_shader = nullptr;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <glbinding/gl/gl.h>
+
+#include "linearallocator.h"
+#include "shader.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// A list of rendering commands (binds, uniforms, draws) recorded without
+// touching GL, so any thread can fill one, and executed later on the thread
+// that owns the context. The commands are small structs placed in the list's
+// own LinearAllocator and chained together, so recording never locks and,
+// once the allocator has grown to a frame's worth, never allocates.
+//
+// Lists recorded in parallel are executed one after the other in a fixed
+// order, e.g. the order of the parts of the scene they cover, which keeps the
+// result the same however the threads were scheduled.
+//
+// Usage:
+//   std::vector<CommandList> lists(threadCount);
+//   // on worker thread i
+//   lists[i].reset();
+//   lists[i].bindProgram(shader);
+//   lists[i].drawIndexed(ib.GetType(), ib.GetCount());
+//   // on the GL thread, after joining the workers
+//   for (const CommandList &list : lists)
+//       list.execute();
+class CommandList {
+  public:
+	struct CommandHeader;
+
+  private:
+	LinearAllocator m_allocator;
+	CommandHeader *m_first = nullptr;
+	CommandHeader *m_last = nullptr;
+	std::size_t m_count = 0;
+	// Uniforms are set on the last bound program
+	Shader *m_shader = nullptr;
+
+	template <typename Command> Command *push();
+
+  public:
+	explicit CommandList(std::size_t blockSize = 64 << 10);
+	CommandList(const CommandList &other) = delete;
+	CommandList(CommandList &&other) = default;
+	CommandList &operator=(const CommandList &other) = delete;
+	CommandList &operator=(CommandList &&other) = default;
+	~CommandList() = default;
+
+	void bindProgram(Shader &shader);
+	void bindVertexArray(unsigned int vertexArray);
+	void bindTexture(unsigned int unit, unsigned int texture);
+	// Needs a program bound earlier in the list
+	void setUniform(UniformName name, float x, float y, float z, float w);
+	// Draws count indices of type as triangles, from the bound VAO's index
+	// buffer. primitiveRestart is IndexBuffer::HasPrimitiveRestart().
+	void drawIndexed(gl::GLenum type, std::uint32_t count,
+					 std::uint32_t firstIndex = 0, std::int32_t baseVertex = 0,
+					 bool primitiveRestart = false);
+
+	// Issues the commands in the order they were recorded, only on the thread
+	// the context is current on
+	void execute() const;
+	// Drops all the commands, keeping the memory for the next frame
+	void reset();
+
+	[[nodiscard]] inline std::size_t GetCount() const { return m_count; };
+	[[nodiscard]] inline std::size_t GetBytesUsed() const {
+		return m_allocator.GetBytesUsed();
+	};
+};
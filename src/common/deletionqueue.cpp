@@ -0,0 +1,104 @@
+#include "deletionqueue.h"
+
+#include "renderer.h"
+
+#include <algorithm>
+
+using namespace gl;
+
+DeletionQueue &DeletionQueue::get() {
+	static DeletionQueue instance;
+	return instance;
+}
+
+void DeletionQueue::enqueueBuffer(GLuint buffer) {
+	if (buffer == 0)
+		return;
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_pending.push_back(buffer);
+	m_queued++;
+}
+
+void DeletionQueue::release(Batch &batch) {
+	GLState &state = GLState::get();
+	for (GLuint buffer : batch.buffers)
+		state.onBufferDeleted(buffer);
+	GLCall(glDeleteBuffers(static_cast<GLsizei>(batch.buffers.size()),
+						   batch.buffers.data()));
+	if (batch.fence != nullptr) {
+		GLCall(glDeleteSync(batch.fence));
+	}
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_deleted += batch.buffers.size();
+	m_batchCount++;
+}
+
+void DeletionQueue::endFrame() {
+	const void *context = &GLState::get();
+	Batch batch{context, nullptr, {}};
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		batch.buffers.swap(m_pending);
+	}
+	if (!batch.buffers.empty()) {
+		batch.fence =
+			GLCallV(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, GL_NONE_BIT));
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_batches.push_back(std::move(batch));
+	}
+
+	// A context's fences signal in order, so stop at the first one that
+	// hasn't. Other contexts' batches are left alone.
+	while (true) {
+		Batch done;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto it = std::find_if(
+				m_batches.begin(), m_batches.end(),
+				[context](const Batch &b) { return b.context == context; });
+			if (it == m_batches.end())
+				break;
+			GLenum result =
+				GLCallV(glClientWaitSync(it->fence, GL_NONE_BIT, 0));
+			if (result == GL_TIMEOUT_EXPIRED)
+				break;
+			ASSERT(result != GL_WAIT_FAILED);
+			done = std::move(*it);
+			m_batches.erase(it);
+		}
+		release(done);
+	}
+}
+
+void DeletionQueue::flush() {
+	const void *context = &GLState::get();
+	std::vector<Batch> batches;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (auto it = m_batches.begin(); it != m_batches.end();) {
+			if (it->context == context) {
+				batches.push_back(std::move(*it));
+				it = m_batches.erase(it);
+			} else {
+				++it;
+			}
+		}
+		if (!m_pending.empty()) {
+			batches.push_back({context, nullptr, {}});
+			batches.back().buffers.swap(m_pending);
+		}
+	}
+	// GL itself holds on to buffers the GPU still uses
+	for (Batch &batch : batches)
+		release(batch);
+}
+
+std::size_t DeletionQueue::GetPendingCount() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_queued - m_deleted;
+}
+
+DeletionQueue::Stats DeletionQueue::getStats() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return {m_queued, m_deleted, m_batchCount};
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <glbinding/gl/gl.h>
+
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// Buffers whose wrappers were destroyed, but that frames still in flight may
+// read. Deleting a buffer the GPU is using can make the driver wait for it
+// or do the cleanup on the spot, and GL calls have to come from the thread
+// the context is current on. So the wrappers hand the names to
+// enqueueBuffer() instead, which any thread may call. endFrame(), called by
+// Window::swapBuffers(), puts a fence behind the frame the names were queued
+// in, and once that fence has signaled they're deleted as a batch with a
+// single glDeleteBuffers.
+//
+// There's one queue for the whole process, and every member is thread safe.
+// endFrame() and flush() work on the context current on the calling thread.
+// All our contexts share their objects with the main window, so any of them
+// may delete a name, but a fence is only waited on by the context that put
+// it there, so each batch remembers it. The window flushes the queue before
+// its context goes away.
+class DeletionQueue {
+  public:
+	struct Stats {
+		unsigned long queued = 0;
+		unsigned long deleted = 0;
+		unsigned long batches = 0;
+	};
+
+  private:
+	struct Batch {
+		// The GLState of the thread that fenced the batch
+		const void *context = nullptr;
+		gl::GLsync fence = nullptr;
+		std::vector<gl::GLuint> buffers;
+	};
+
+	// Guards everything below
+	std::mutex m_mutex;
+	std::vector<gl::GLuint> m_pending;
+	unsigned long m_queued = 0;
+	unsigned long m_deleted = 0;
+	unsigned long m_batchCount = 0;
+	// Waiting for their fences, oldest first
+	std::deque<Batch> m_batches;
+
+	DeletionQueue() = default;
+	void release(Batch &batch);
+
+  public:
+	static DeletionQueue &get();
+
+	void enqueueBuffer(gl::GLuint buffer);
+
+	// Fences what was queued this frame and deletes the batches whose fences
+	// have signaled, without waiting for the others
+	void endFrame();
+	// Deletes the current context's batches and everything not fenced yet
+	// right away, e.g. before destroying the context
+	void flush();
+
+	// Names queued and not deleted yet
+	[[nodiscard]] std::size_t GetPendingCount();
+	[[nodiscard]] Stats getStats();
+
+	DeletionQueue(const DeletionQueue &other) = delete;
+	DeletionQueue(DeletionQueue &&other) = delete;
+	DeletionQueue &operator=(const DeletionQueue &other) = delete;
+	DeletionQueue &operator=(DeletionQueue &&other) = delete;
+};
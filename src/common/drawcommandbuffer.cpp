@@ -0,0 +1,127 @@
+#include "drawcommandbuffer.h"
+
+#include "deletionqueue.h"
+#include "glbinding/gl/gl.h"
+#include "indexbuffer.h"
+#include "renderer.h"
+#include "vertexarray.h"
+
+#include <numeric>
+
+using namespace gl;
+
+namespace {
+
+VertexBuffer CreateDrawIDs(std::size_t capacity) {
+	std::vector<std::uint32_t> ids(capacity);
+	std::iota(ids.begin(), ids.end(), 0U);
+	return {ids.data(),
+			static_cast<unsigned int>(ids.size() * sizeof(std::uint32_t))};
+}
+
+} // namespace
+
+DrawCommandBuffer::DrawCommandBuffer(std::size_t capacity)
+	: m_rendererID(0), m_capacity(capacity),
+	  m_drawIDs(CreateDrawIDs(capacity)) {
+	m_commands.reserve(capacity);
+	GLCall(glGenBuffers(1, &m_rendererID));
+	bind();
+	GLCall(glBufferData(
+		GL_DRAW_INDIRECT_BUFFER,
+		static_cast<GLsizeiptr>(capacity * sizeof(DrawElementsIndirectCommand)),
+		nullptr, GL_DYNAMIC_DRAW));
+}
+
+DrawCommandBuffer::DrawCommandBuffer(DrawCommandBuffer &&other)
+	: m_rendererID(other.m_rendererID), m_capacity(other.m_capacity),
+	  m_commands(std::move(other.m_commands)), m_dirty(other.m_dirty),
+	  m_drawIDs(std::move(other.m_drawIDs)) {
+	other.moved = true;
+}
+
+DrawCommandBuffer &DrawCommandBuffer::operator=(DrawCommandBuffer &&other) {
+	if (this == &other) {
+		return *this;
+	}
+
+	// Free existing resources being held by this object
+	release();
+
+	this->m_rendererID = other.m_rendererID;
+	this->m_capacity = other.m_capacity;
+	this->m_commands = std::move(other.m_commands);
+	this->m_dirty = other.m_dirty;
+	this->m_drawIDs = std::move(other.m_drawIDs);
+	this->moved = false;
+	other.moved = true;
+
+	return *this;
+}
+
+DrawCommandBuffer::~DrawCommandBuffer() {
+	release();
+}
+
+void DrawCommandBuffer::release() {
+	if (!moved) {
+		DeletionQueue::get().enqueueBuffer(m_rendererID);
+	}
+}
+
+bool DrawCommandBuffer::isSupported() {
+	GLint major = 0;
+	GLint minor = 0;
+	GLCall(glGetIntegerv(GL_MAJOR_VERSION, &major));
+	GLCall(glGetIntegerv(GL_MINOR_VERSION, &minor));
+	return major > 4 || (major == 4 && minor >= 3) ||
+		   GLHasExtension("GL_ARB_multi_draw_indirect");
+}
+
+unsigned int DrawCommandBuffer::add(unsigned int count,
+									unsigned int firstIndex, int baseVertex) {
+	// The draw ID attribute only has capacity values
+	ASSERT(m_commands.size() < m_capacity);
+	auto drawID = static_cast<unsigned int>(m_commands.size());
+	m_commands.push_back({count, 1, firstIndex, baseVertex, drawID});
+	m_dirty = true;
+	return drawID;
+}
+
+void DrawCommandBuffer::clear() {
+	m_commands.clear();
+	m_dirty = true;
+}
+
+void DrawCommandBuffer::addDrawIDAttribute(VertexArray &va) const {
+	va.addInstanceBuffer<DrawIDLayout>(m_drawIDs);
+}
+
+void DrawCommandBuffer::bind() const {
+	GLState::get().bindBuffer(GL_DRAW_INDIRECT_BUFFER, m_rendererID);
+}
+
+void DrawCommandBuffer::unbind() const {
+	GLState::get().bindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void DrawCommandBuffer::submit(const VertexArray &va, const IndexBuffer &ib) {
+	if (m_commands.empty())
+		return;
+	va.bind();
+	bind();
+	GLState::get().setPrimitiveRestart(ib.HasPrimitiveRestart(),
+									   ib.GetRestartIndex());
+	if (m_dirty) {
+		GLCall(glBufferSubData(
+			GL_DRAW_INDIRECT_BUFFER, 0,
+			static_cast<GLsizeiptr>(m_commands.size() *
+									sizeof(DrawElementsIndirectCommand)),
+			m_commands.data()));
+		m_dirty = false;
+	}
+	// The commands are read from the bound indirect buffer, at offset 0
+	GLCall(glMultiDrawElementsIndirect(GL_TRIANGLES, ib.GetType(), nullptr,
+									   static_cast<GLsizei>(m_commands.size()),
+									   0));
+}
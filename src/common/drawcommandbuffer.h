@@ -0,0 +1,101 @@
+#pragma once
+#include <glbinding/gl/gl.h>
+
+#include "vertexbuffer.h"
+#include "vertexlayout.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class IndexBuffer;
+class VertexArray;
+
+// The record glMultiDrawElementsIndirect reads for every draw
+struct DrawElementsIndirectCommand {
+	std::uint32_t count;
+	std::uint32_t instanceCount;
+	std::uint32_t firstIndex;
+	std::int32_t baseVertex;
+	std::uint32_t baseInstance;
+};
+static_assert(sizeof(DrawElementsIndirectCommand) == 20);
+
+// Records draws of ranges of one shared index buffer into a
+// GL_DRAW_INDIRECT_BUFFER and submits all of them with a single
+// glMultiDrawElementsIndirect, so the CPU cost of a frame doesn't grow with
+// the number of meshes in it.
+//
+// Every draw gets its index in the buffer as its base instance. Shaders use
+// that to fetch their per-draw data from a StorageBuffer, through
+// gl_BaseInstance (or gl_DrawID) with ARB_shader_draw_parameters and through
+// the draw ID attribute set up by addDrawIDAttribute() otherwise.
+//
+// Needs GL 4.3 or ARB_multi_draw_indirect.
+//
+// Usage:
+//   DrawCommandBuffer commands(1024);
+//   commands.addDrawIDAttribute(va);
+//   for (const Mesh &mesh : meshes)
+//       commands.add(mesh.indexCount, mesh.firstIndex, mesh.baseVertex);
+//   ...
+//   commands.submit(va, ib);
+class DrawCommandBuffer {
+  public:
+	// The draw ID attribute, one 32-bit unsigned integer per instance
+	using DrawIDLayout = VertexLayout<Attr<std::uint32_t, 1>>;
+
+  private:
+	unsigned int m_rendererID;
+	std::size_t m_capacity;
+	std::vector<DrawElementsIndirectCommand> m_commands;
+	// The commands in the buffer don't match m_commands
+	bool m_dirty = false;
+	// 0, 1, 2... read with the base instance as the index
+	VertexBuffer m_drawIDs;
+	bool moved = false;
+
+	void release();
+
+  public:
+	// capacity is the largest number of draws that can be recorded
+	explicit DrawCommandBuffer(std::size_t capacity);
+	DrawCommandBuffer(const DrawCommandBuffer &other) = delete;
+	DrawCommandBuffer(DrawCommandBuffer &&other);
+	DrawCommandBuffer operator=(const DrawCommandBuffer &other) = delete;
+	DrawCommandBuffer &operator=(DrawCommandBuffer &&other);
+	~DrawCommandBuffer();
+
+	// Needs a current context
+	static bool isSupported();
+
+	// Records a draw of count indices starting at firstIndex, with
+	// baseVertex added to each of them, and returns its draw ID
+	unsigned int add(unsigned int count, unsigned int firstIndex = 0,
+					 int baseVertex = 0);
+	void clear();
+
+	// Sets up the draw ID attribute at va's next attribute location
+	void addDrawIDAttribute(VertexArray &va) const;
+
+	void bind() const;
+	void unbind() const;
+
+	// Uploads the commands if they changed since the last submit and draws
+	// them as triangles. ib has to be va's index buffer.
+	void submit(const VertexArray &va, const IndexBuffer &ib);
+
+	[[nodiscard]] inline unsigned int GetRendererID() const {
+		return m_rendererID;
+	};
+	[[nodiscard]] inline std::size_t GetCount() const {
+		return m_commands.size();
+	};
+	[[nodiscard]] inline std::size_t GetCapacity() const {
+		return m_capacity;
+	};
+	[[nodiscard]] inline const std::vector<DrawElementsIndirectCommand> &
+	GetCommands() const {
+		return m_commands;
+	};
+};
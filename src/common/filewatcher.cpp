@@ -0,0 +1,129 @@
+#include "filewatcher.h"
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+std::string DirectoryOf(const std::string &path) {
+	std::string directory =
+		std::filesystem::path(path).parent_path().generic_string();
+	return directory.empty() ? "." : directory;
+}
+
+std::filesystem::file_time_type LastWriteTime(const std::string &path) {
+	std::error_code error;
+	auto time = std::filesystem::last_write_time(path, error);
+	return error ? std::filesystem::file_time_type::min() : time;
+}
+
+} // namespace
+
+#ifdef __linux__
+FileWatcher::FileWatcher() : m_fd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {
+	if (m_fd < 0)
+		std::cerr << "[FileWatcher] inotify_init1 failed" << std::endl;
+}
+
+FileWatcher::~FileWatcher() {
+	if (m_fd >= 0)
+		close(m_fd);
+}
+
+void FileWatcher::addFile(const std::string &path) {
+	if (!m_files.emplace(path, LastWriteTime(path)).second || m_fd < 0)
+		return;
+
+	std::string directory = DirectoryOf(path);
+	for (const auto &[wd, watched] : m_directories) {
+		if (watched == directory)
+			return;
+	}
+
+	// Saving in place shows up as IN_CLOSE_WRITE, saving through a temporary
+	// file as IN_MOVED_TO or IN_CREATE
+	int wd = inotify_add_watch(m_fd, directory.c_str(),
+							   IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+	if (wd < 0) {
+		std::cerr << "[FileWatcher] Can't watch " << directory << std::endl;
+		return;
+	}
+	m_directories.emplace(wd, directory);
+}
+
+std::vector<std::string>
+FileWatcher::waitForChanges(std::chrono::milliseconds timeout) {
+	std::vector<std::string> changed;
+	if (m_fd < 0) {
+		std::this_thread::sleep_for(timeout);
+		return changed;
+	}
+
+	pollfd descriptor{m_fd, POLLIN, 0};
+	int waitMs = static_cast<int>(timeout.count());
+	// A single save is often a burst of events, keep draining for a moment so
+	// they get reported together
+	constexpr int kSettleMs = 50;
+
+	while (poll(&descriptor, 1, waitMs) > 0) {
+		alignas(inotify_event) char buffer[4096]; // NOLINT
+		ssize_t length = 0;
+		while ((length = read(m_fd, buffer, sizeof(buffer))) > 0) {
+			for (ssize_t offset = 0; offset < length;) {
+				// NOLINTNEXTLINE
+				const auto *event = reinterpret_cast<const inotify_event *>(
+					buffer + offset);
+				offset += static_cast<ssize_t>(sizeof(inotify_event) +
+											   event->len);
+
+				auto directory = m_directories.find(event->wd);
+				if (event->len == 0 || directory == m_directories.end())
+					continue;
+				std::string path = (std::filesystem::path(directory->second) /
+									event->name) // NOLINT
+									   .lexically_normal()
+									   .generic_string();
+				if (m_files.count(path) != 0 &&
+					std::find(changed.begin(), changed.end(), path) ==
+						changed.end())
+					changed.push_back(path);
+			}
+		}
+		// Only unrelated files changed
+		if (changed.empty())
+			break;
+		waitMs = kSettleMs;
+	}
+	return changed;
+}
+#else
+FileWatcher::FileWatcher() = default;
+
+FileWatcher::~FileWatcher() = default;
+
+void FileWatcher::addFile(const std::string &path) {
+	m_files.emplace(path, LastWriteTime(path));
+}
+
+std::vector<std::string>
+FileWatcher::waitForChanges(std::chrono::milliseconds timeout) {
+	std::this_thread::sleep_for(timeout);
+
+	std::vector<std::string> changed;
+	for (auto &[path, lastWrite] : m_files) {
+		auto time = LastWriteTime(path);
+		if (time != lastWrite) {
+			lastWrite = time;
+			changed.push_back(path);
+		}
+	}
+	return changed;
+}
+#endif
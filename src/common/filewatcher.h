@@ -0,0 +1,36 @@
+#pragma once
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Reports changes to a set of files. On Linux this is built on inotify, which
+// watches the parent directories rather than the files themselves, since most
+// editors save by writing a new file and renaming it over the old one. Other
+// platforms fall back to comparing modification times.
+//
+// Not thread safe, it's meant to be owned by a single worker thread.
+class FileWatcher {
+  private:
+	// Path -> last write time, the time is only used by the fallback
+	std::unordered_map<std::string, std::filesystem::file_time_type> m_files;
+#ifdef __linux__
+	int m_fd = -1;
+	// Watch descriptor -> directory
+	std::unordered_map<int, std::string> m_directories;
+#endif
+
+  public:
+	FileWatcher();
+	FileWatcher(const FileWatcher &other) = delete;
+	FileWatcher &operator=(const FileWatcher &other) = delete;
+	~FileWatcher();
+
+	// Paths are compared as they are given, so they should be normalized
+	void addFile(const std::string &path);
+
+	// Waits up to timeout for any of the files to change and returns the ones
+	// that did, or nothing on timeout
+	std::vector<std::string> waitForChanges(std::chrono::milliseconds timeout);
+};
@@ -0,0 +1,36 @@
+#include "framearena.h"
+
+#include <algorithm>
+
+FrameArena::FrameArena(std::size_t frameCount, std::size_t blockSize) {
+	frameCount = std::max<std::size_t>(frameCount, 1);
+	m_frames.reserve(frameCount);
+	for (std::size_t i = 0; i < frameCount; i++)
+		m_frames.emplace_back(blockSize);
+}
+
+void *FrameArena::do_allocate(std::size_t bytes, std::size_t alignment) {
+	return m_frames[m_current].allocate(bytes, alignment);
+}
+
+void FrameArena::do_deallocate(void * /*pointer*/, std::size_t /*bytes*/,
+							   std::size_t /*alignment*/) {
+	// Freed all at once by nextFrame()
+}
+
+bool FrameArena::do_is_equal(
+	const std::pmr::memory_resource &other) const noexcept {
+	return this == &other;
+}
+
+void FrameArena::nextFrame() {
+	m_current = (m_current + 1) % m_frames.size();
+	m_frames[m_current].reset();
+}
+
+std::size_t FrameArena::GetCapacity() const {
+	std::size_t capacity = 0;
+	for (const LinearAllocator &frame : m_frames)
+		capacity += frame.GetCapacity();
+	return capacity;
+}
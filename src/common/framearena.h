@@ -0,0 +1,69 @@
+#pragma once
+
+#include "linearallocator.h"
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Memory for data that only lives for a frame: draw packets, uniform blocks,
+// culling lists. Allocating bumps a pointer and nothing is freed on its own.
+// Instead nextFrame() switches to the next of frameCount LinearAllocators
+// and resets it, so with the default of two whatever a frame allocated stays
+// valid while the next one is being built. Window::swapBuffers() calls
+// nextFrame() once the arena is attached with setFrameArena().
+//
+// It's a std::pmr::memory_resource, so standard containers can use it:
+//   std::pmr::vector<DrawPacket> packets(&arena);
+// deallocate() does nothing, a container that grows leaves its old storage
+// behind until the reset. Reserving up front avoids that.
+//
+// Not thread safe: give each thread its own.
+class FrameArena : public std::pmr::memory_resource {
+  private:
+	std::vector<LinearAllocator> m_frames;
+	std::size_t m_current = 0;
+
+  protected:
+	void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+	void do_deallocate(void *pointer, std::size_t bytes,
+					   std::size_t alignment) override;
+	[[nodiscard]] bool
+	do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+  public:
+	explicit FrameArena(std::size_t frameCount = 2,
+						std::size_t blockSize = 1 << 20);
+	// Containers keep pointers to it
+	FrameArena(const FrameArena &other) = delete;
+	FrameArena(FrameArena &&other) = delete;
+	FrameArena &operator=(const FrameArena &other) = delete;
+	FrameArena &operator=(FrameArena &&other) = delete;
+	~FrameArena() override = default;
+
+	// Constructs a T that lives until this frame's memory is reused. Its
+	// destructor is never run.
+	template <typename T, typename... Args> T *create(Args &&...args) {
+		static_assert(std::is_trivially_destructible_v<T>,
+					  "Frame memory is reused without running destructors");
+		return new (allocate(sizeof(T), alignof(T)))
+			T(std::forward<Args>(args)...);
+	}
+
+	// Moves on to the next frame's memory, freeing what was allocated
+	// frameCount frames ago
+	void nextFrame();
+
+	// Bytes allocated in the current frame
+	[[nodiscard]] inline std::size_t GetBytesUsed() const {
+		return m_frames[m_current].GetBytesUsed();
+	};
+	// Bytes reserved for all the frames
+	[[nodiscard]] std::size_t GetCapacity() const;
+	[[nodiscard]] inline std::size_t GetFrameCount() const {
+		return m_frames.size();
+	};
+};
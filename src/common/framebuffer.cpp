@@ -0,0 +1,88 @@
+#include "framebuffer.h"
+
+#include "glbinding/gl/gl.h"
+#include "renderer.h"
+
+using namespace gl;
+
+Framebuffer::Framebuffer(int width, int height)
+	: m_rendererID(0), m_colorAttachment(0), m_depthAttachment(0),
+	  m_width(width), m_height(height) {
+	// A renderbuffer is enough since nothing ever samples the result,
+	// glReadPixels works on it just fine
+	GLCall(glGenRenderbuffers(1, &m_colorAttachment));
+	GLCall(glBindRenderbuffer(GL_RENDERBUFFER, m_colorAttachment));
+	GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_width, m_height));
+	// Same as the default framebuffer GLFW asks for
+	GLCall(glGenRenderbuffers(1, &m_depthAttachment));
+	GLCall(glBindRenderbuffer(GL_RENDERBUFFER, m_depthAttachment));
+	GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_width,
+								 m_height));
+	GLCall(glBindRenderbuffer(GL_RENDERBUFFER, 0));
+
+	GLCall(glGenFramebuffers(1, &m_rendererID));
+	GLState::get().bindFramebuffer(m_rendererID);
+	GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+									 GL_RENDERBUFFER, m_colorAttachment));
+	GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER,
+									 GL_DEPTH_STENCIL_ATTACHMENT,
+									 GL_RENDERBUFFER, m_depthAttachment));
+	ASSERT(isComplete());
+}
+
+Framebuffer::Framebuffer(Framebuffer &&other) {
+	this->m_rendererID = other.m_rendererID;
+	this->m_colorAttachment = other.m_colorAttachment;
+	this->m_depthAttachment = other.m_depthAttachment;
+	this->m_width = other.m_width;
+	this->m_height = other.m_height;
+	other.moved = true;
+}
+
+Framebuffer &Framebuffer::operator=(Framebuffer &&other) {
+	if (this == &other) {
+		return *this;
+	}
+
+	// Free existing resources being held by this object
+	if (!moved) {
+		GLState::get().onFramebufferDeleted(m_rendererID);
+		GLCall(glDeleteFramebuffers(1, &m_rendererID));
+		GLCall(glDeleteRenderbuffers(1, &m_colorAttachment));
+		GLCall(glDeleteRenderbuffers(1, &m_depthAttachment));
+	}
+
+	this->m_rendererID = other.m_rendererID;
+	this->m_colorAttachment = other.m_colorAttachment;
+	this->m_depthAttachment = other.m_depthAttachment;
+	this->m_width = other.m_width;
+	this->m_height = other.m_height;
+	this->moved = false;
+	other.moved = true;
+
+	return *this;
+}
+
+Framebuffer::~Framebuffer() {
+	if (!moved) {
+		GLState::get().onFramebufferDeleted(m_rendererID);
+		GLCall(glDeleteFramebuffers(1, &m_rendererID));
+		GLCall(glDeleteRenderbuffers(1, &m_colorAttachment));
+		GLCall(glDeleteRenderbuffers(1, &m_depthAttachment));
+	}
+}
+
+void Framebuffer::bind() const {
+	GLState::get().bindFramebuffer(m_rendererID);
+	GLCall(glViewport(0, 0, m_width, m_height));
+}
+
+void Framebuffer::unbind() const {
+	GLState::get().bindFramebuffer(0);
+}
+
+bool Framebuffer::isComplete() const {
+	GLState::get().bindFramebuffer(m_rendererID);
+	GLenum status = GLCallV(glCheckFramebufferStatus(GL_FRAMEBUFFER));
+	return status == GL_FRAMEBUFFER_COMPLETE;
+}
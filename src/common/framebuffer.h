@@ -0,0 +1,33 @@
+#pragma once
+
+// An offscreen render target with an RGBA8 color and a depth/stencil
+// attachment. The headless backends have no default framebuffer to draw into,
+// so everything gets rendered into one of these instead.
+class Framebuffer {
+  private:
+	unsigned int m_rendererID;
+	unsigned int m_colorAttachment;
+	unsigned int m_depthAttachment;
+	int m_width;
+	int m_height;
+	bool moved = false;
+
+  public:
+	Framebuffer(int width, int height);
+	Framebuffer(const Framebuffer &other) = delete;
+	Framebuffer(Framebuffer &&other);
+	Framebuffer operator=(const Framebuffer &other) = delete;
+	Framebuffer &operator=(Framebuffer &&other);
+	~Framebuffer();
+
+	void bind() const;
+	void unbind() const;
+	[[nodiscard]] bool isComplete() const;
+
+	[[nodiscard]] inline int GetWidth() const {
+		return m_width;
+	};
+	[[nodiscard]] inline int GetHeight() const {
+		return m_height;
+	};
+};
@@ -0,0 +1,291 @@
+#include "frustumculler.h"
+
+#include "drawcommandbuffer.h"
+#include "indexbuffer.h"
+#include "jobsystem.h"
+#include "renderer.h"
+#include "shadercompiler.h"
+#include "shadersource.h"
+#include "vertexarray.h"
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+
+using namespace gl;
+
+namespace {
+
+// Objects per job in cullOnCPU()
+constexpr std::size_t kCullGrain = 1024;
+
+unsigned int LoadCullShader(const std::string &path) {
+	ShaderLibrary library;
+	std::optional<ShaderSource> source = library.parse(path);
+	if (!source)
+		return 0;
+	return CreateComputeProgram(source->str(ShaderStage::COMPUTE));
+}
+
+GLsizeiptr CommandBufferSize(std::size_t objectCount) {
+	return static_cast<GLsizeiptr>(objectCount *
+								   sizeof(DrawElementsIndirectCommand));
+}
+
+// Fills the bound buffer with zeros, on the GPU
+void ClearBuffer(GLenum target) {
+	GLCall(glClearBufferData(target, GL_R32UI, GL_RED_INTEGER,
+							 GL_UNSIGNED_INT, nullptr));
+}
+
+} // namespace
+
+FrustumPlanes
+ExtractFrustumPlanes(const std::array<float, 16> &viewProjection) {
+	// Gribb and Hartmann: every plane is the last row of the matrix plus or
+	// minus one of the others
+	auto row = [&](std::size_t i) {
+		return std::array<float, 4>{viewProjection[i], viewProjection[4 + i],
+									viewProjection[8 + i],
+									viewProjection[12 + i]};
+	};
+	std::array<float, 4> w = row(3);
+	FrustumPlanes planes{};
+	for (std::size_t axis = 0; axis < 3; axis++) {
+		std::array<float, 4> r = row(axis);
+		for (std::size_t i = 0; i < 4; i++) {
+			planes[axis * 2][i] = w[i] + r[i];
+			planes[axis * 2 + 1][i] = w[i] - r[i];
+		}
+	}
+	for (std::array<float, 4> &plane : planes) {
+		float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] +
+								 plane[2] * plane[2]);
+		for (float &value : plane)
+			value /= length;
+	}
+	return planes;
+}
+
+bool IsVisible(const FrustumPlanes &planes, const CullObject &object) {
+	for (const std::array<float, 4> &plane : planes) {
+		float distance = plane[0] * object.center[0] +
+						 plane[1] * object.center[1] +
+						 plane[2] * object.center[2] + plane[3];
+		if (distance < -object.radius)
+			return false;
+		// How far the box reaches towards the plane
+		float extent = std::abs(plane[0]) * object.halfExtents[0] +
+					   std::abs(plane[1]) * object.halfExtents[1] +
+					   std::abs(plane[2]) * object.halfExtents[2];
+		if (distance < -extent)
+			return false;
+	}
+	return true;
+}
+
+FrustumCuller::FrustumCuller(std::vector<CullObject> objects,
+							 const std::string &shaderPath)
+	: m_shader(LoadCullShader(shaderPath)),
+	  m_objects(objects.data(), objects.size() * sizeof(CullObject)),
+	  m_cpuObjects(std::move(objects)), m_commandBuffer(0),
+	  m_counterBuffer(0) {
+	GLint major = 0;
+	GLint minor = 0;
+	GLCall(glGetIntegerv(GL_MAJOR_VERSION, &major));
+	GLCall(glGetIntegerv(GL_MINOR_VERSION, &minor));
+	m_indirectCount = major > 4 || (major == 4 && minor >= 6) ||
+					  GLHasExtension("GL_ARB_indirect_parameters");
+
+	GLState &state = GLState::get();
+	GLCall(glGenBuffers(1, &m_commandBuffer));
+	state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+	GLCall(glBufferData(GL_DRAW_INDIRECT_BUFFER,
+						CommandBufferSize(m_cpuObjects.size()), nullptr,
+						GL_DYNAMIC_DRAW));
+
+	GLuint zero = 0;
+	GLCall(glGenBuffers(1, &m_counterBuffer));
+	state.bindBuffer(GL_ATOMIC_COUNTER_BUFFER, m_counterBuffer);
+	GLCall(glBufferData(GL_ATOMIC_COUNTER_BUFFER, sizeof(zero), &zero,
+						GL_DYNAMIC_DRAW));
+}
+
+FrustumCuller::FrustumCuller(FrustumCuller &&other)
+	: m_shader(std::move(other.m_shader)),
+	  m_objects(std::move(other.m_objects)),
+	  m_cpuObjects(std::move(other.m_cpuObjects)),
+	  m_commandBuffer(other.m_commandBuffer),
+	  m_counterBuffer(other.m_counterBuffer),
+	  m_indirectCount(other.m_indirectCount),
+	  m_countOnCPU(other.m_countOnCPU), m_cpuVisible(other.m_cpuVisible),
+	  m_cpuCommands(std::move(other.m_cpuCommands)),
+	  m_rangeVisible(std::move(other.m_rangeVisible)) {
+	other.moved = true;
+}
+
+FrustumCuller &FrustumCuller::operator=(FrustumCuller &&other) {
+	if (this == &other) {
+		return *this;
+	}
+
+	// Free existing resources being held by this object
+	release();
+
+	this->m_shader = std::move(other.m_shader);
+	this->m_objects = std::move(other.m_objects);
+	this->m_cpuObjects = std::move(other.m_cpuObjects);
+	this->m_commandBuffer = other.m_commandBuffer;
+	this->m_counterBuffer = other.m_counterBuffer;
+	this->m_indirectCount = other.m_indirectCount;
+	this->m_countOnCPU = other.m_countOnCPU;
+	this->m_cpuVisible = other.m_cpuVisible;
+	this->m_cpuCommands = std::move(other.m_cpuCommands);
+	this->m_rangeVisible = std::move(other.m_rangeVisible);
+	this->moved = false;
+	other.moved = true;
+
+	return *this;
+}
+
+FrustumCuller::~FrustumCuller() {
+	release();
+}
+
+void FrustumCuller::release() {
+	if (!moved) {
+		GLState &state = GLState::get();
+		state.onBufferDeleted(m_commandBuffer);
+		state.onBufferDeleted(m_counterBuffer);
+		GLCall(glDeleteBuffers(1, &m_commandBuffer));
+		GLCall(glDeleteBuffers(1, &m_counterBuffer));
+	}
+}
+
+bool FrustumCuller::isSupported() {
+	GLint major = 0;
+	GLint minor = 0;
+	GLCall(glGetIntegerv(GL_MAJOR_VERSION, &major));
+	GLCall(glGetIntegerv(GL_MINOR_VERSION, &minor));
+	return major > 4 || (major == 4 && minor >= 3) ||
+		   (GLHasExtension("GL_ARB_compute_shader") &&
+			GLHasExtension("GL_ARB_shader_storage_buffer_object") &&
+			GLHasExtension("GL_ARB_multi_draw_indirect"));
+}
+
+bool FrustumCuller::isValid() const {
+	return m_shader.GetRendererID() != 0;
+}
+
+void FrustumCuller::cull(const std::array<float, 16> &viewProjection) {
+	GLState &state = GLState::get();
+	state.bindBuffer(GL_ATOMIC_COUNTER_BUFFER, m_counterBuffer);
+	ClearBuffer(GL_ATOMIC_COUNTER_BUFFER);
+	if (!m_indirectCount) {
+		// Every command gets drawn, the ones that aren't written have to be
+		// empty
+		state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+		ClearBuffer(GL_DRAW_INDIRECT_BUFFER);
+	}
+
+	FrustumPlanes planes = ExtractFrustumPlanes(viewProjection);
+	auto objectCount = static_cast<unsigned int>(m_cpuObjects.size());
+	m_shader.bind();
+	m_shader.setUniform("u_Planes", planes.data(), planes.size());
+	m_shader.setUniform("u_ObjectCount", objectCount);
+	m_objects.bindBase(kObjectBinding);
+	state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, kCommandBinding,
+						 m_commandBuffer);
+	state.bindBufferBase(GL_ATOMIC_COUNTER_BUFFER, kCounterBinding,
+						 m_counterBuffer);
+	GLCall(glDispatchCompute((objectCount + kGroupSize - 1) / kGroupSize, 1,
+							 1));
+	// The commands and the count are read by the draw, and the count by
+	// readVisibleCount()'s glGetBufferSubData
+	GLCall(glMemoryBarrier(
+		GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT |
+		GL_ATOMIC_COUNTER_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT));
+	m_countOnCPU = false;
+}
+
+void FrustumCuller::cullOnCPU(const std::array<float, 16> &viewProjection,
+							  JobSystem *jobs) {
+	FrustumPlanes planes = ExtractFrustumPlanes(viewProjection);
+	std::size_t objectCount = m_cpuObjects.size();
+	m_cpuCommands.resize(objectCount);
+	m_rangeVisible.resize((objectCount + kCullGrain - 1) / kCullGrain);
+
+	// Every range writes the commands of its visible objects from its own
+	// first object on, so ranges can run in any order on any thread
+	auto cullRange = [&](std::size_t begin, std::size_t end) {
+		std::uint32_t visible = 0;
+		for (std::size_t i = begin; i < end; i++) {
+			const CullObject &object = m_cpuObjects[i];
+			if (IsVisible(planes, object)) {
+				m_cpuCommands[begin + visible++] = {
+					object.indexCount, 1, object.firstIndex,
+					object.baseVertex, static_cast<std::uint32_t>(i)};
+			}
+		}
+		m_rangeVisible[begin / kCullGrain] = visible;
+	};
+	if (jobs) {
+		jobs->parallelFor(objectCount, kCullGrain, cullRange);
+	} else {
+		for (std::size_t begin = 0; begin < objectCount; begin += kCullGrain)
+			cullRange(begin, std::min(begin + kCullGrain, objectCount));
+	}
+
+	// Close the gaps between the ranges
+	std::size_t commandCount = 0;
+	for (std::size_t range = 0; range < m_rangeVisible.size(); range++) {
+		auto first = m_cpuCommands.begin() +
+					 static_cast<std::ptrdiff_t>(range * kCullGrain);
+		std::copy(first, first + m_rangeVisible[range],
+				  m_cpuCommands.begin() +
+					  static_cast<std::ptrdiff_t>(commandCount));
+		commandCount += m_rangeVisible[range];
+	}
+
+	GLState::get().bindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+	GLCall(glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0,
+						   CommandBufferSize(commandCount),
+						   m_cpuCommands.data()));
+	m_cpuVisible = static_cast<std::uint32_t>(commandCount);
+	m_countOnCPU = true;
+}
+
+void FrustumCuller::draw(const VertexArray &va, const IndexBuffer &ib) {
+	GLState &state = GLState::get();
+	va.bind();
+	m_objects.bindBase(kObjectBinding);
+	state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+	if (m_countOnCPU) {
+		if (m_cpuVisible > 0) {
+			GLCall(glMultiDrawElementsIndirect(
+				GL_TRIANGLES, ib.GetType(), nullptr,
+				static_cast<GLsizei>(m_cpuVisible), 0));
+		}
+	} else if (m_indirectCount) {
+		// GL_PARAMETER_BUFFER isn't cached, the draw count is read from
+		// offset 0 of it
+		state.bindBuffer(GL_PARAMETER_BUFFER_ARB, m_counterBuffer);
+		GLCall(glMultiDrawElementsIndirectCountARB(
+			GL_TRIANGLES, ib.GetType(), nullptr, 0,
+			static_cast<GLsizei>(m_cpuObjects.size()), 0));
+	} else {
+		GLCall(glMultiDrawElementsIndirect(
+			GL_TRIANGLES, ib.GetType(), nullptr,
+			static_cast<GLsizei>(m_cpuObjects.size()), 0));
+	}
+}
+
+std::uint32_t FrustumCuller::readVisibleCount() const {
+	if (m_countOnCPU)
+		return m_cpuVisible;
+	std::uint32_t count = 0;
+	GLState::get().bindBuffer(GL_ATOMIC_COUNTER_BUFFER, m_counterBuffer);
+	GLCall(glGetBufferSubData(GL_ATOMIC_COUNTER_BUFFER, 0, sizeof(count),
+							  &count));
+	return count;
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <glbinding/gl/gl.h>
+
+#include "drawcommandbuffer.h"
+#include "shader.h"
+#include "storagebuffer.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class IndexBuffer;
+class JobSystem;
+class VertexArray;
+
+// An object to be culled, laid out like the std430 struct the culling shader
+// reads. The mesh is drawn with indexCount indices from firstIndex, with
+// baseVertex added to them.
+struct CullObject {
+	std::array<float, 3> center;
+	float radius;
+	// Of the axis aligned box around center, tested after the sphere
+	std::array<float, 3> halfExtents;
+	std::uint32_t indexCount;
+	std::uint32_t firstIndex;
+	std::int32_t baseVertex;
+	std::array<std::uint32_t, 2> padding;
+};
+static_assert(sizeof(CullObject) == 48);
+
+// ax + by + cz + d >= 0 inside, normalized so the distance is in world units.
+// Left, right, bottom, top, near and far.
+using FrustumPlanes = std::array<std::array<float, 4>, 6>;
+
+// Extracts the planes from a column major view projection matrix
+FrustumPlanes ExtractFrustumPlanes(const std::array<float, 16> &viewProjection);
+
+// Whether any part of the object's sphere and box is inside the frustum
+bool IsVisible(const FrustumPlanes &planes, const CullObject &object);
+
+// Decides on the GPU which objects get drawn. A compute shader
+// (res/shaders/FrustumCull.shader) tests every object in a storage buffer
+// against the frustum and appends a DrawElementsIndirectCommand for each one
+// that's visible, using an atomic counter to find its slot. draw() then
+// submits them with one multi-draw indirect call without the CPU ever seeing
+// the result.
+//
+// Every command has the index of its object as the base instance, so vertex
+// shaders can read the object from the same storage buffer, which stays
+// bound to binding point kObjectBinding.
+//
+// The number of draws is read from the counter with ARB_indirect_parameters.
+// Without it all the commands get drawn, with the slots past the visible
+// ones cleared to empty draws.
+//
+// Needs GL 4.3 or the compute shader, storage buffer and multi-draw indirect
+// extensions. cullOnCPU() does the same work on the CPU for comparison.
+class FrustumCuller {
+  public:
+	static constexpr unsigned int kObjectBinding = 0;
+	static constexpr unsigned int kCommandBinding = 1;
+	static constexpr unsigned int kCounterBinding = 0;
+	static constexpr unsigned int kGroupSize = 64;
+
+  private:
+	Shader m_shader;
+	StorageBuffer m_objects;
+	std::vector<CullObject> m_cpuObjects;
+	// One command per object, used as a storage buffer by the compute shader
+	unsigned int m_commandBuffer;
+	// A single GLuint, the number of commands written
+	unsigned int m_counterBuffer;
+	bool m_indirectCount;
+	// Set by cullOnCPU(), the GPU count isn't known on the CPU
+	bool m_countOnCPU = false;
+	std::uint32_t m_cpuVisible = 0;
+	// Scratch for cullOnCPU(), kept so culling doesn't allocate every frame
+	std::vector<DrawElementsIndirectCommand> m_cpuCommands;
+	std::vector<std::uint32_t> m_rangeVisible;
+	bool moved = false;
+
+	void release();
+
+  public:
+	explicit FrustumCuller(
+		std::vector<CullObject> objects,
+		const std::string &shaderPath = "res/shaders/FrustumCull.shader");
+	FrustumCuller(const FrustumCuller &other) = delete;
+	FrustumCuller(FrustumCuller &&other);
+	FrustumCuller operator=(const FrustumCuller &other) = delete;
+	FrustumCuller &operator=(FrustumCuller &&other);
+	~FrustumCuller();
+
+	// Needs a current context
+	static bool isSupported();
+	// False if the shader failed to build
+	[[nodiscard]] bool isValid() const;
+
+	// Dispatches the culling shader, the commands are ready for the next draw()
+	void cull(const std::array<float, 16> &viewProjection);
+	// Tests the objects on the CPU and uploads the commands of the visible
+	// ones. With jobs the tests are spread over its workers, the commands
+	// come out in the same order either way.
+	void cullOnCPU(const std::array<float, 16> &viewProjection,
+				   JobSystem *jobs = nullptr);
+
+	// Draws the objects that passed the last cull. ib has to be va's index
+	// buffer. Leaves the object buffer bound to kObjectBinding.
+	void draw(const VertexArray &va, const IndexBuffer &ib);
+
+	// Objects that passed the last cull. After cull() this waits for the GPU.
+	[[nodiscard]] std::uint32_t readVisibleCount() const;
+
+	[[nodiscard]] inline std::size_t GetObjectCount() const {
+		return m_cpuObjects.size();
+	};
+	[[nodiscard]] inline bool HasIndirectCount() const {
+		return m_indirectCount;
+	};
+};
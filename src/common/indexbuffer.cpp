@@ -1,26 +1,180 @@
 #include "indexbuffer.h"
 
+#include "deletionqueue.h"
 #include "glbinding/gl/gl.h"
 #include "renderer.h"
 
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <vector>
+
 using namespace gl;
 
-IndexBuffer::IndexBuffer(const unsigned int *data, unsigned int count)
-	: m_rendererID(0), m_count(count) {
-	ASSERT(sizeof(unsigned int) == sizeof(GLuint));
+namespace {
+
+template <typename T> const T *As(const void *data) {
+	return static_cast<const T *>(data);
+}
+
+// The largest index that isn't a restart marker
+template <typename T>
+std::uint32_t MaxIndex(const T *indices, std::size_t count,
+					   bool primitiveRestart) {
+	constexpr T kRestart = std::numeric_limits<T>::max();
+	T maxIndex = 0;
+	for (std::size_t i = 0; i < count; i++) {
+		T index = indices[i]; // NOLINT
+		if (!(primitiveRestart && index == kRestart))
+			maxIndex = std::max(maxIndex, index);
+	}
+	return maxIndex;
+}
+
+template <typename From, typename To>
+std::vector<To> Narrow(const From *indices, std::size_t count,
+					   bool primitiveRestart) {
+	constexpr From kFromRestart = std::numeric_limits<From>::max();
+	constexpr To kToRestart = std::numeric_limits<To>::max();
+	std::vector<To> narrowed(count);
+	for (std::size_t i = 0; i < count; i++) {
+		From index = indices[i]; // NOLINT
+		narrowed[i] = primitiveRestart && index == kFromRestart
+						  ? kToRestart
+						  : static_cast<To>(index);
+	}
+	return narrowed;
+}
+
+template <typename To>
+std::vector<To> Narrow(const void *data, std::size_t count,
+					   std::size_t indexSize, bool primitiveRestart) {
+	switch (indexSize) {
+	case 1:
+		return Narrow<std::uint8_t, To>(As<std::uint8_t>(data), count,
+										primitiveRestart);
+	case 2:
+		return Narrow<std::uint16_t, To>(As<std::uint16_t>(data), count,
+										 primitiveRestart);
+	default:
+		return Narrow<std::uint32_t, To>(As<std::uint32_t>(data), count,
+										 primitiveRestart);
+	}
+}
+
+} // namespace
+
+void IndexBuffer::create(const void *data, std::size_t count,
+						 std::size_t indexSize, unsigned int vertexCount) {
+	ASSERT(count <=
+		   static_cast<std::size_t>(std::numeric_limits<GLsizei>::max()));
+	m_count = static_cast<unsigned int>(count);
+
+	std::uint32_t maxIndex = 0;
+	switch (indexSize) {
+	case 1:
+		maxIndex = MaxIndex(As<std::uint8_t>(data), count, m_primitiveRestart);
+		break;
+	case 2:
+		maxIndex =
+			MaxIndex(As<std::uint16_t>(data), count, m_primitiveRestart);
+		break;
+	default:
+		maxIndex =
+			MaxIndex(As<std::uint32_t>(data), count, m_primitiveRestart);
+		break;
+	}
+	if (vertexCount != 0 && maxIndex >= vertexCount) {
+		std::cerr << "[IndexBuffer] Index " << maxIndex
+				  << " is out of range for " << vertexCount << " vertices"
+				  << std::endl;
+		ASSERT(false);
+	}
+
+	// The restart marker takes up the largest value of the type
+	std::uint32_t limit = m_primitiveRestart ? 1 : 0;
+	std::size_t typeSize = 4;
+	if (m_arena)
+		typeSize = m_arena->GetUnitSize();
+	else if (maxIndex + limit <= std::numeric_limits<std::uint8_t>::max())
+		typeSize = 1;
+	else if (maxIndex + limit <= std::numeric_limits<std::uint16_t>::max())
+		typeSize = 2;
+
+	std::vector<std::uint8_t> bytes;
+	std::vector<std::uint16_t> shorts;
+	std::vector<std::uint32_t> ints;
+	const void *upload = data;
+	switch (typeSize) {
+	case 1:
+		ASSERT(maxIndex + limit <= std::numeric_limits<std::uint8_t>::max());
+		m_type = GL_UNSIGNED_BYTE;
+		if (indexSize != 1) {
+			bytes = Narrow<std::uint8_t>(data, count, indexSize,
+										 m_primitiveRestart);
+			upload = bytes.data();
+		}
+		break;
+	case 2:
+		ASSERT(maxIndex + limit <= std::numeric_limits<std::uint16_t>::max());
+		m_type = GL_UNSIGNED_SHORT;
+		if (indexSize != 2) {
+			shorts = Narrow<std::uint16_t>(data, count, indexSize,
+										   m_primitiveRestart);
+			upload = shorts.data();
+		}
+		break;
+	default:
+		// Arenas are the only reason to widen
+		ASSERT(typeSize == 4);
+		m_type = GL_UNSIGNED_INT;
+		if (indexSize != 4) {
+			ints = Narrow<std::uint32_t>(data, count, indexSize,
+										 m_primitiveRestart);
+			upload = ints.data();
+		}
+		break;
+	}
+	std::size_t size = count * GetIndexSize();
+
+	if (m_arena) {
+		m_allocation = m_arena->allocate(size);
+		// Out of room
+		ASSERT(m_allocation != BufferArena::kInvalid);
+		m_arena->upload(m_allocation, upload, size);
+		return;
+	}
+
+	if (GLState::get().hasDirectStateAccess()) {
+		// Nothing changes the indices, so the storage can be immutable. It
+		// can't be empty though.
+		GLCall(glCreateBuffers(1, &m_rendererID));
+		if (size > 0) {
+			GLCall(glNamedBufferStorage(m_rendererID,
+										static_cast<GLsizeiptr>(size), upload,
+										GL_NONE_BIT));
+		}
+		return;
+	}
+
 	// This function generates a buffer and stores
 	// its id in the second argument
 	GLCall(glGenBuffers(1, &m_rendererID));
-	// Select the buffer
-	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_rendererID));
+	// Select the buffer. The element array binding belongs to the bound VAO,
+	// which shouldn't change just because an index buffer got created.
+	GLState::get().bindBuffer(GL_COPY_WRITE_BUFFER, m_rendererID);
 	// Set the buffer data in vram
-	GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_count * sizeof(unsigned int),
-						data, GL_STATIC_DRAW));
+	GLCall(glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(size),
+						upload, GL_STATIC_DRAW));
 }
 
 IndexBuffer::IndexBuffer(IndexBuffer &&other) {
 	this->m_rendererID = other.m_rendererID;
 	this->m_count = other.m_count;
+	this->m_type = other.m_type;
+	this->m_primitiveRestart = other.m_primitiveRestart;
+	this->m_arena = other.m_arena;
+	this->m_allocation = other.m_allocation;
 	other.moved = true;
 }
 
@@ -30,24 +184,39 @@ IndexBuffer &IndexBuffer::operator=(IndexBuffer &&other) {
 	}
 
 	// Free existing resources being held by this object
-	GLCall(glDeleteBuffers(1, &m_rendererID));
+	release();
 
 	this->m_rendererID = other.m_rendererID;
 	this->m_count = other.m_count;
+	this->m_type = other.m_type;
+	this->m_primitiveRestart = other.m_primitiveRestart;
+	this->m_arena = other.m_arena;
+	this->m_allocation = other.m_allocation;
+	this->moved = false;
 	other.moved = true;
 
 	return *this;
 }
 
 IndexBuffer::~IndexBuffer() {
-	if (!moved)
-		GLCall(glDeleteBuffers(1, &m_rendererID));
+	release();
+}
+
+void IndexBuffer::release() {
+	if (moved)
+		return;
+	if (m_arena) {
+		if (m_allocation != BufferArena::kInvalid)
+			m_arena->free(m_allocation);
+		return;
+	}
+	DeletionQueue::get().enqueueBuffer(m_rendererID);
 }
 
 void IndexBuffer::bind() const {
-	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_rendererID));
+	GLState::get().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_rendererID);
 }
 
 void IndexBuffer::unbind() const {
-	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+	GLState::get().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
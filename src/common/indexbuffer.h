@@ -1,15 +1,108 @@
 #pragma once
+#include <glbinding/gl/gl.h>
 
+#include "bufferarena.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+// Size in bytes of one GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+// index
+constexpr std::size_t GetIndexTypeSize(gl::GLenum type) {
+	switch (type) {
+	case gl::GLenum::GL_UNSIGNED_BYTE:
+		return 1;
+	case gl::GLenum::GL_UNSIGNED_SHORT:
+		return 2;
+	default:
+		return 4;
+	}
+}
+
+// The largest value of the index type, which marks a primitive restart
+constexpr unsigned int GetIndexTypeRestartIndex(gl::GLenum type) {
+	switch (type) {
+	case gl::GLenum::GL_UNSIGNED_BYTE:
+		return 0xff;
+	case gl::GLenum::GL_UNSIGNED_SHORT:
+		return 0xffff;
+	default:
+		return 0xffffffff;
+	}
+}
+
+// Indices are stored in the narrowest type that fits the largest one, so
+// meshes with fewer than 256 or 65536 vertices use a half or a quarter of
+// the memory and fetch bandwidth. Draw calls have to use GetType() instead of
+// assuming GL_UNSIGNED_INT.
+//
+// With primitiveRestart the largest value of the source type (0xffff for
+// 16-bit indices, 0xffffffff for 32-bit ones...) marks a restart. It's
+// stored as the largest value of the chosen type, which is what
+// GLState::setPrimitiveRestart() expects. If vertexCount is given every
+// other index is checked to be smaller.
+//
+// In a BufferArena the type is always the one whose size is the arena's
+// unit size, so every index buffer in the arena can be drawn the same way,
+// and the indices start at GetFirstIndex().
 class IndexBuffer {
   private:
 	// The id of the vbo, we're calling it renderer id to keep it generic with
 	// other graphics APIs
 	unsigned int m_rendererID;
 	unsigned int m_count;
+	gl::GLenum m_type;
+	bool m_primitiveRestart;
+	BufferArena *m_arena = nullptr;
+	BufferArena::Handle m_allocation = BufferArena::kInvalid;
 	bool moved = false;
 
+	void create(const void *data, std::size_t count, std::size_t indexSize,
+				unsigned int vertexCount);
+	void release();
+
   public:
-	IndexBuffer(const unsigned int *data, unsigned int count);
+	template <typename T>
+	IndexBuffer(const T *data, std::size_t count, unsigned int vertexCount = 0,
+				bool primitiveRestart = false)
+		: m_rendererID(0), m_count(0), m_type(gl::GLenum::GL_UNSIGNED_INT),
+		  m_primitiveRestart(primitiveRestart) {
+		static_assert(std::is_integral_v<T> && std::is_unsigned_v<T> &&
+						  (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4),
+					  "Indices have to be 8, 16 or 32-bit unsigned integers");
+		create(data, count, sizeof(T), vertexCount);
+	}
+
+	// Allocates the indices in arena, whose unit size has to be 1, 2 or 4
+	// and big enough for the largest index
+	template <typename T>
+	IndexBuffer(BufferArena &arena, const T *data, std::size_t count,
+				unsigned int vertexCount = 0, bool primitiveRestart = false)
+		: m_rendererID(arena.GetRendererID()), m_count(0),
+		  m_type(gl::GLenum::GL_UNSIGNED_INT),
+		  m_primitiveRestart(primitiveRestart), m_arena(&arena) {
+		static_assert(std::is_integral_v<T> && std::is_unsigned_v<T> &&
+						  (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4),
+					  "Indices have to be 8, 16 or 32-bit unsigned integers");
+		create(data, count, sizeof(T), vertexCount);
+	}
+
+	// Anything contiguous with data() and size(), e.g. a std::array or a
+	// std::vector of std::uint16_t or std::uint32_t
+	template <typename Range,
+			  typename = decltype(std::data(std::declval<const Range &>()))>
+	explicit IndexBuffer(const Range &indices, unsigned int vertexCount = 0,
+						 bool primitiveRestart = false)
+		: IndexBuffer(std::data(indices), std::size(indices), vertexCount,
+					  primitiveRestart) {}
+	template <typename Range,
+			  typename = decltype(std::data(std::declval<const Range &>()))>
+	IndexBuffer(BufferArena &arena, const Range &indices,
+				unsigned int vertexCount = 0, bool primitiveRestart = false)
+		: IndexBuffer(arena, std::data(indices), std::size(indices),
+					  vertexCount, primitiveRestart) {}
 
 	IndexBuffer(const IndexBuffer &other) = delete;
 	IndexBuffer(IndexBuffer &&other);
@@ -22,7 +115,32 @@ class IndexBuffer {
 	void bind() const;
 	void unbind() const;
 
+	[[nodiscard]] inline unsigned int GetRendererID() const {
+		return m_rendererID;
+	};
 	[[nodiscard]] inline unsigned int GetCount() const {
 		return m_count;
 	};
-};
\ No newline at end of file
+	// GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	[[nodiscard]] inline gl::GLenum GetType() const {
+		return m_type;
+	};
+	[[nodiscard]] inline std::size_t GetIndexSize() const {
+		return GetIndexTypeSize(m_type);
+	};
+	[[nodiscard]] inline bool HasPrimitiveRestart() const {
+		return m_primitiveRestart;
+	};
+	// The largest value of GetType()
+	[[nodiscard]] inline unsigned int GetRestartIndex() const {
+		return GetIndexTypeRestartIndex(m_type);
+	};
+	// Where the indices start in the buffer, 0 unless it's in an arena
+	[[nodiscard]] inline unsigned int GetFirstIndex() const {
+		return m_arena ? m_arena->GetFirstElement(m_allocation) : 0;
+	};
+	// GetFirstIndex() in bytes, what glDrawElements takes as its pointer
+	[[nodiscard]] inline std::size_t GetOffset() const {
+		return m_arena ? m_arena->GetOffset(m_allocation) : 0;
+	};
+};
@@ -0,0 +1,207 @@
+#include "jobsystem.h"
+
+#include "pr_assert.h"
+
+#include <chrono>
+
+namespace {
+
+// Which JobSystem the thread belongs to, and its index in it
+thread_local const JobSystem *t_system = nullptr;
+thread_local unsigned int t_worker = 0;
+
+// Spins before an idle worker goes to sleep
+constexpr unsigned int kIdleSpins = 64;
+
+} // namespace
+
+JobSystem::Deque::Deque()
+	: m_buffer(std::make_unique<std::atomic<Job *>[]>(kMaxJobs)) {}
+
+bool JobSystem::Deque::push(Job *job) {
+	std::int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+	std::int64_t top = m_top.load(std::memory_order_acquire);
+	if (bottom - top >= static_cast<std::int64_t>(kMaxJobs))
+		return false;
+	m_buffer[static_cast<std::size_t>(bottom) % kMaxJobs].store(
+		job, std::memory_order_relaxed);
+	// Publishes the job to thieves, they read bottom with acquire
+	m_bottom.store(bottom + 1, std::memory_order_release);
+	return true;
+}
+
+JobSystem::Job *JobSystem::Deque::pop() {
+	std::int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+	m_bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	std::int64_t top = m_top.load(std::memory_order_relaxed);
+	if (top > bottom) {
+		// Empty
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+	Job *job = m_buffer[static_cast<std::size_t>(bottom) % kMaxJobs].load(
+		std::memory_order_relaxed);
+	if (top == bottom) {
+		// The last job, race the thieves for it
+		if (!m_top.compare_exchange_strong(top, top + 1,
+										   std::memory_order_seq_cst,
+										   std::memory_order_relaxed))
+			job = nullptr;
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+JobSystem::Job *JobSystem::Deque::steal() {
+	std::int64_t top = m_top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	std::int64_t bottom = m_bottom.load(std::memory_order_acquire);
+	if (top >= bottom)
+		return nullptr;
+	Job *job = m_buffer[static_cast<std::size_t>(top) % kMaxJobs].load(
+		std::memory_order_relaxed);
+	if (!m_top.compare_exchange_strong(top, top + 1,
+									   std::memory_order_seq_cst,
+									   std::memory_order_relaxed))
+		return nullptr;
+	return job;
+}
+
+JobSystem::JobSystem(unsigned int workerThreads) {
+	m_workers.reserve(workerThreads + 1);
+	for (unsigned int i = 0; i <= workerThreads; i++) {
+		auto worker = std::make_unique<Worker>();
+		worker->jobs = std::make_unique<Job[]>(kMaxJobs);
+		worker->random = 0x9e3779b9U * (i + 1);
+		m_workers.push_back(std::move(worker));
+	}
+
+	t_system = this;
+	t_worker = 0;
+	m_threads.reserve(workerThreads);
+	for (unsigned int i = 1; i <= workerThreads; i++)
+		m_threads.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_running.store(false);
+	}
+	m_wake.notify_all();
+	for (std::thread &thread : m_threads)
+		thread.join();
+	if (t_system == this)
+		t_system = nullptr;
+}
+
+JobSystem::Worker &JobSystem::currentWorker() {
+	// Threads that don't belong to this JobSystem can't start jobs
+	ASSERT(t_system == this);
+	return *m_workers[t_worker];
+}
+
+JobSystem::Job *JobSystem::allocate() {
+	Worker &worker = currentWorker();
+	Job *job = &worker.jobs[worker.nextJob % kMaxJobs];
+	// The slot's previous job is still queued or running, lend a hand
+	while (!job->free.load(std::memory_order_acquire)) {
+		if (!runOne(t_worker))
+			std::this_thread::yield();
+	}
+	worker.nextJob++;
+	job->free.store(false, std::memory_order_relaxed);
+	return job;
+}
+
+void JobSystem::submit(Job *job) {
+	if (!currentWorker().deque.push(job)) {
+		// Can't happen as long as the deque is as big as the job ring
+		job->function(*job);
+		job->counter->m_pending.fetch_sub(1, std::memory_order_release);
+		job->free.store(true, std::memory_order_release);
+		return;
+	}
+	m_queued.fetch_add(1, std::memory_order_release);
+	m_wake.notify_one();
+}
+
+bool JobSystem::runOne(unsigned int worker) {
+	Worker &self = *m_workers[worker];
+	Job *job = self.deque.pop();
+	bool stolen = false;
+	if (!job) {
+		// Start at a random victim so thieves don't all pile onto one
+		self.random ^= self.random << 13;
+		self.random ^= self.random >> 17;
+		self.random ^= self.random << 5;
+		auto count = static_cast<unsigned int>(m_workers.size());
+		for (unsigned int i = 0; i < count && !job; i++) {
+			unsigned int victim = (self.random + i) % count;
+			if (victim != worker)
+				job = m_workers[victim]->deque.steal();
+		}
+		stolen = job != nullptr;
+	}
+	if (!job)
+		return false;
+
+	m_queued.fetch_sub(1, std::memory_order_relaxed);
+	job->function(*job);
+	self.executed.fetch_add(1, std::memory_order_relaxed);
+	if (stolen)
+		self.stolen.fetch_add(1, std::memory_order_relaxed);
+	job->counter->m_pending.fetch_sub(1, std::memory_order_release);
+	job->free.store(true, std::memory_order_release);
+	return true;
+}
+
+void JobSystem::workerLoop(unsigned int worker) {
+	t_system = this;
+	t_worker = worker;
+	unsigned int idle = 0;
+	while (m_running.load(std::memory_order_relaxed)) {
+		if (runOne(worker)) {
+			idle = 0;
+			continue;
+		}
+		if (++idle < kIdleSpins) {
+			std::this_thread::yield();
+			continue;
+		}
+		// The timeout covers a notify that slips in between checking the
+		// predicate and going to sleep
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_wake.wait_for(lock, std::chrono::milliseconds(1), [this] {
+			return m_queued.load(std::memory_order_acquire) > 0 ||
+				   !m_running.load(std::memory_order_relaxed);
+		});
+		idle = 0;
+	}
+}
+
+void JobSystem::wait(const JobCounter &counter) {
+	ASSERT(t_system == this);
+	while (!counter.isDone()) {
+		if (!runOne(t_worker))
+			std::this_thread::yield();
+	}
+}
+
+JobSystem::Stats JobSystem::getStats() const {
+	Stats stats;
+	for (const std::unique_ptr<Worker> &worker : m_workers) {
+		stats.executed.push_back(
+			worker->executed.load(std::memory_order_relaxed));
+		stats.stolen.push_back(worker->stolen.load(std::memory_order_relaxed));
+	}
+	return stats;
+}
+
+void JobSystem::resetStats() {
+	for (const std::unique_ptr<Worker> &worker : m_workers) {
+		worker->executed.store(0, std::memory_order_relaxed);
+		worker->stolen.store(0, std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Counts the jobs that were started with it and haven't finished yet.
+// Waiting on it is how one piece of work depends on another: a job that
+// needs the results of others waits on their counter, and JobSystem::wait()
+// runs other jobs in the meantime instead of blocking the thread.
+class JobCounter {
+	friend class JobSystem;
+
+  private:
+	std::atomic<unsigned int> m_pending{0};
+
+  public:
+	[[nodiscard]] inline bool isDone() const {
+		return m_pending.load(std::memory_order_acquire) == 0;
+	}
+};
+
+// A fixed pool of worker threads that run small jobs. Every thread has its
+// own Chase-Lev deque: it pushes and pops jobs at the bottom without locks,
+// and idle threads steal from the top of the others'. The thread that
+// creates the JobSystem is worker 0. It doesn't run jobs on its own, only
+// while it waits on a counter (or in parallelFor), so it helps out instead of
+// sleeping.
+//
+// Jobs are a callable and its captures copied into a fixed size slot, so
+// starting one never allocates. The captures have to fit into kJobDataSize
+// bytes and be trivially destructible, capturing by reference is the usual
+// way. A thread can have up to kMaxJobs jobs in flight that it started, after
+// that starting another one runs jobs until a slot frees up.
+//
+// Only worker threads, i.e. the creating thread and jobs, may start jobs.
+//
+// Usage:
+//   JobSystem jobs;
+//   JobCounter counter;
+//   jobs.run(counter, [&] { parse(a); });
+//   jobs.run(counter, [&] { parse(b); });
+//   jobs.wait(counter);
+//   jobs.parallelFor(objects.size(), 256, [&](size_t begin, size_t end) {
+//       ...
+//   });
+class JobSystem {
+  public:
+	static constexpr std::size_t kJobDataSize = 48;
+	static constexpr std::size_t kMaxJobs = 4096;
+
+	struct Stats {
+		// Jobs run by each worker, the first one is the creating thread
+		std::vector<unsigned long> executed;
+		std::vector<unsigned long> stolen;
+	};
+
+  private:
+	struct Job {
+		void (*function)(Job &job);
+		JobCounter *counter;
+		// Cleared while the job is queued or running
+		std::atomic<bool> free{true};
+		alignas(std::max_align_t) std::byte data[kJobDataSize]; // NOLINT
+	};
+
+	// Chase and Lev's deque, with the memory orderings from Lê et al.,
+	// "Correct and Efficient Work-Stealing for Weak Memory Models". The
+	// buffer doesn't grow, push() fails when it's full.
+	class Deque {
+	  private:
+		std::unique_ptr<std::atomic<Job *>[]> m_buffer; // NOLINT
+		std::atomic<std::int64_t> m_top{0};
+		std::atomic<std::int64_t> m_bottom{0};
+
+	  public:
+		Deque();
+		// Owner only
+		bool push(Job *job);
+		Job *pop();
+		// Any thread
+		Job *steal();
+	};
+
+	struct Worker {
+		Deque deque;
+		// Ring of job slots, a slot is reused kMaxJobs jobs later if it's
+		// free by then
+		std::unique_ptr<Job[]> jobs; // NOLINT
+		std::size_t nextJob = 0;
+		std::atomic<unsigned long> executed{0};
+		std::atomic<unsigned long> stolen{0};
+		std::uint32_t random = 0;
+	};
+
+	std::vector<std::unique_ptr<Worker>> m_workers;
+	std::vector<std::thread> m_threads;
+	std::atomic<bool> m_running{true};
+	// Jobs pushed and not yet taken, sleeping workers wait for it to rise
+	std::atomic<unsigned int> m_queued{0};
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wake;
+
+	Worker &currentWorker();
+	Job *allocate();
+	void submit(Job *job);
+	// Runs one job from this thread's deque or stolen from another one,
+	// returns false if there wasn't any
+	bool runOne(unsigned int worker);
+	void workerLoop(unsigned int worker);
+
+  public:
+	// workerThreads defaults to one less than the number of cores, the
+	// creating thread makes up the rest
+	explicit JobSystem(unsigned int workerThreads = std::max(
+						   std::thread::hardware_concurrency(), 2U) -
+					   1);
+	JobSystem(const JobSystem &other) = delete;
+	JobSystem(JobSystem &&other) = delete;
+	JobSystem &operator=(const JobSystem &other) = delete;
+	JobSystem &operator=(JobSystem &&other) = delete;
+	~JobSystem();
+
+	template <typename F> void run(JobCounter &counter, F &&function) {
+		using Function = std::decay_t<F>;
+		static_assert(sizeof(Function) <= kJobDataSize,
+					  "The job's captures don't fit, capture by reference");
+		static_assert(std::is_trivially_destructible_v<Function>,
+					  "The job's captures have to be trivially destructible");
+		Job *job = allocate();
+		new (job->data) Function(std::forward<F>(function));
+		job->function = [](Job &self) {
+			auto *stored = reinterpret_cast<Function *>(self.data); // NOLINT
+			(*std::launder(stored))();
+		};
+		job->counter = &counter;
+		counter.m_pending.fetch_add(1, std::memory_order_relaxed);
+		submit(job);
+	}
+
+	// Runs other jobs until counter is done
+	void wait(const JobCounter &counter);
+
+	// Calls function(begin, end) for ranges of at most grainSize that
+	// together cover [0, count), spread over the workers, and waits for them
+	template <typename F>
+	void parallelFor(std::size_t count, std::size_t grainSize, F &&function) {
+		grainSize = std::max<std::size_t>(grainSize, 1);
+		JobCounter counter;
+		for (std::size_t begin = 0; begin < count; begin += grainSize) {
+			std::size_t end = std::min(begin + grainSize, count);
+			run(counter, [&function, begin, end] { function(begin, end); });
+		}
+		wait(counter);
+	}
+
+	[[nodiscard]] inline unsigned int GetWorkerCount() const {
+		return static_cast<unsigned int>(m_workers.size());
+	};
+	[[nodiscard]] Stats getStats() const;
+	void resetStats();
+};
@@ -0,0 +1,43 @@
+#include "linearallocator.h"
+
+#include <algorithm>
+
+LinearAllocator::LinearAllocator(std::size_t blockSize)
+	: m_blockSize(blockSize) {}
+
+void *LinearAllocator::allocate(std::size_t size, std::size_t alignment) {
+	while (true) {
+		if (m_block == m_blocks.size()) {
+			// Leave room to align the start of an oversized allocation
+			std::size_t blockSize = std::max(m_blockSize, size + alignment);
+			m_blocks.push_back(
+				{std::make_unique<std::byte[]>(blockSize), blockSize});
+		}
+
+		Block &block = m_blocks[m_block];
+		void *pointer = block.data.get() + m_offset; // NOLINT
+		std::size_t space = block.size - m_offset;
+		if (std::align(alignment, size, pointer, space)) {
+			std::size_t padding = block.size - m_offset - space;
+			m_offset += padding + size;
+			m_bytesUsed += padding + size;
+			return pointer;
+		}
+		// Doesn't fit, the rest of this block stays unused until reset()
+		m_block++;
+		m_offset = 0;
+	}
+}
+
+void LinearAllocator::reset() {
+	m_block = 0;
+	m_offset = 0;
+	m_bytesUsed = 0;
+}
+
+std::size_t LinearAllocator::GetCapacity() const {
+	std::size_t capacity = 0;
+	for (const Block &block : m_blocks)
+		capacity += block.size;
+	return capacity;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Hands out memory by bumping an offset into big blocks and frees all of it
+// at once with reset(). The blocks are kept, so once it has grown to what a
+// frame needs it doesn't allocate anymore. Destructors of the objects placed
+// in it are never run, it's meant for trivially destructible data.
+//
+// Not thread safe: give each thread its own.
+class LinearAllocator {
+  private:
+	struct Block {
+		std::unique_ptr<std::byte[]> data;
+		std::size_t size;
+	};
+
+	std::size_t m_blockSize;
+	std::vector<Block> m_blocks;
+	// The block being allocated from and the offset into it
+	std::size_t m_block = 0;
+	std::size_t m_offset = 0;
+	std::size_t m_bytesUsed = 0;
+
+  public:
+	explicit LinearAllocator(std::size_t blockSize = 64 << 10);
+	LinearAllocator(const LinearAllocator &other) = delete;
+	LinearAllocator(LinearAllocator &&other) = default;
+	LinearAllocator &operator=(const LinearAllocator &other) = delete;
+	LinearAllocator &operator=(LinearAllocator &&other) = default;
+	~LinearAllocator() = default;
+
+	// alignment has to be a power of two. Allocations bigger than the block
+	// size get a block of their own.
+	[[nodiscard]] void *allocate(std::size_t size,
+								 std::size_t alignment = alignof(
+									 std::max_align_t));
+	// Frees everything allocated so far, keeping the blocks
+	void reset();
+
+	[[nodiscard]] inline std::size_t GetBytesUsed() const {
+		return m_bytesUsed;
+	};
+	// Bytes in all the blocks
+	[[nodiscard]] std::size_t GetCapacity() const;
+};
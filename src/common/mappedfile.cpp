@@ -0,0 +1,151 @@
+#include "mappedfile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string &path, size_t mapThreshold) {
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+							  nullptr, OPEN_EXISTING,
+							  FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+	m_file = file;
+
+	LARGE_INTEGER size{};
+	if (!GetFileSizeEx(file, &size)) {
+		release();
+		return;
+	}
+	m_size = static_cast<size_t>(size.QuadPart);
+	m_valid = true;
+	// Empty files can't be mapped, but they're still valid files
+	if (m_size == 0)
+		return;
+
+	if (m_size < mapThreshold) {
+		m_buffer = std::make_unique<char[]>(m_size); // NOLINT
+		DWORD read = 0;
+		if (ReadFile(file, m_buffer.get(), static_cast<DWORD>(m_size), &read,
+					 nullptr) &&
+			read == m_size) {
+			m_data = m_buffer.get();
+			CloseHandle(file);
+			m_file = nullptr;
+		} else {
+			release();
+		}
+		return;
+	}
+
+	m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mapping != nullptr)
+		m_data = static_cast<const char *>(
+			MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	if (m_data == nullptr)
+		release();
+}
+
+void MappedFile::release() {
+	if (m_data != nullptr && m_buffer == nullptr)
+		UnmapViewOfFile(m_data);
+	if (m_mapping != nullptr)
+		CloseHandle(m_mapping);
+	if (m_file != nullptr)
+		CloseHandle(m_file);
+	m_data = nullptr;
+	m_mapping = nullptr;
+	m_file = nullptr;
+	m_buffer.reset();
+	m_size = 0;
+	m_valid = false;
+}
+#else
+MappedFile::MappedFile(const std::string &path, size_t mapThreshold) {
+	int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC); // NOLINT
+	if (fd < 0)
+		return;
+
+	struct stat info {};
+	if (fstat(fd, &info) == 0) {
+		m_size = static_cast<size_t>(info.st_size);
+		m_valid = true;
+		// Empty files can't be mapped, but they're still valid files
+		if (m_size != 0 && m_size < mapThreshold) {
+			m_buffer = std::make_unique<char[]>(m_size); // NOLINT
+			size_t total = 0;
+			while (total < m_size) {
+				ssize_t count =
+					read(fd, m_buffer.get() + total, m_size - total);
+				if (count <= 0)
+					break;
+				total += static_cast<size_t>(count);
+			}
+			if (total == m_size) {
+				m_data = m_buffer.get();
+			} else {
+				m_buffer.reset();
+				m_size = 0;
+				m_valid = false;
+			}
+		} else if (m_size != 0) {
+			void *data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data == MAP_FAILED) { // NOLINT
+				m_size = 0;
+				m_valid = false;
+			} else {
+				m_data = static_cast<const char *>(data);
+			}
+		}
+	}
+	// The mapping keeps the file alive on its own
+	close(fd);
+}
+
+void MappedFile::release() {
+	if (m_data != nullptr && m_buffer == nullptr)
+		munmap(const_cast<char *>(m_data), m_size); // NOLINT
+	m_buffer.reset();
+	m_data = nullptr;
+	m_size = 0;
+	m_valid = false;
+}
+#endif
+
+MappedFile::MappedFile(MappedFile &&other) noexcept {
+	*this = std::move(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+	if (this == &other) {
+		return *this;
+	}
+
+	// Free existing resources being held by this object
+	release();
+
+	m_data = std::exchange(other.m_data, nullptr);
+	m_size = std::exchange(other.m_size, 0);
+	m_valid = std::exchange(other.m_valid, false);
+	m_buffer = std::move(other.m_buffer);
+#ifdef _WIN32
+	m_file = std::exchange(other.m_file, nullptr);
+	m_mapping = std::exchange(other.m_mapping, nullptr);
+#endif
+
+	return *this;
+}
+
+MappedFile::~MappedFile() {
+	release();
+}
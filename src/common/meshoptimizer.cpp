@@ -0,0 +1,434 @@
+#include "meshoptimizer.h"
+
+#include "jobsystem.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace {
+
+constexpr std::uint32_t kUnused = ~0U;
+
+// A FIFO cache can be simulated with a time stamp per vertex: the clock
+// ticks on every miss, and a vertex is still cached if it was loaded less
+// than cacheSize ticks ago
+class FIFOCache {
+  private:
+	std::vector<std::size_t> m_loadTime;
+	std::size_t m_clock;
+	unsigned int m_size;
+
+  public:
+	FIFOCache(std::size_t vertexCount, unsigned int size)
+		: m_loadTime(vertexCount, 0), m_clock(size + 1), m_size(size) {}
+
+	// Evicts everything
+	void flush() {
+		m_clock += m_size + 1;
+	}
+
+	// Returns true on a miss
+	bool access(std::uint32_t vertex) {
+		if (m_clock - m_loadTime[vertex] <= m_size)
+			return false;
+		m_loadTime[vertex] = m_clock++;
+		return true;
+	}
+};
+
+struct Float3 {
+	float x = 0.0f;
+	float y = 0.0f;
+	float z = 0.0f;
+};
+
+Float3 operator+(Float3 a, Float3 b) {
+	return {a.x + b.x, a.y + b.y, a.z + b.z};
+}
+
+Float3 operator-(Float3 a, Float3 b) {
+	return {a.x - b.x, a.y - b.y, a.z - b.z};
+}
+
+Float3 operator*(Float3 a, float s) {
+	return {a.x * s, a.y * s, a.z * s};
+}
+
+float Dot(Float3 a, Float3 b) {
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+Float3 Cross(Float3 a, Float3 b) {
+	return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z,
+			a.x * b.y - a.y * b.x};
+}
+
+Float3 LoadPosition(const float *positions, std::size_t stride,
+					std::uint32_t vertex) {
+	const auto *bytes = reinterpret_cast<const unsigned char *>(positions);
+	std::array<float, 3> xyz{};
+	std::memcpy(xyz.data(), bytes + vertex * stride, sizeof(xyz)); // NOLINT
+	return {xyz[0], xyz[1], xyz[2]};
+}
+
+std::size_t CountUsedVertices(const std::uint32_t *indices,
+							  std::size_t indexCount,
+							  std::size_t vertexCount) {
+	std::vector<bool> used(vertexCount, false);
+	std::size_t count = 0;
+	for (std::size_t i = 0; i < indexCount; i++) {
+		std::uint32_t vertex = indices[i]; // NOLINT
+		if (!used[vertex]) {
+			used[vertex] = true;
+			count++;
+		}
+	}
+	return count;
+}
+
+// The triangles using each vertex, in compressed sparse row form
+struct Adjacency {
+	std::vector<std::uint32_t> offsets;
+	std::vector<std::uint32_t> triangles;
+
+	Adjacency(const std::uint32_t *indices, std::size_t indexCount,
+			  std::size_t vertexCount)
+		: offsets(vertexCount + 1, 0), triangles(indexCount) {
+		for (std::size_t i = 0; i < indexCount; i++)
+			offsets[indices[i] + 1]++; // NOLINT
+		std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+		std::vector<std::uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (std::size_t i = 0; i < indexCount; i++)
+			triangles[fill[indices[i]]++] = // NOLINT
+				static_cast<std::uint32_t>(i / 3);
+	}
+};
+
+} // namespace
+
+VertexCacheStats AnalyzeVertexCache(const std::uint32_t *indices,
+									std::size_t indexCount,
+									std::size_t vertexCount,
+									unsigned int cacheSize) {
+	VertexCacheStats stats;
+	if (indexCount == 0)
+		return stats;
+
+	FIFOCache cache(vertexCount, cacheSize);
+	for (std::size_t i = 0; i < indexCount; i++) {
+		if (cache.access(indices[i])) // NOLINT
+			stats.transformedVertices++;
+	}
+
+	auto transformed = static_cast<double>(stats.transformedVertices);
+	stats.acmr = transformed / static_cast<double>(indexCount / 3);
+	stats.atvr = transformed / static_cast<double>(CountUsedVertices(
+								   indices, indexCount, vertexCount));
+	return stats;
+}
+
+VertexFetchStats AnalyzeVertexFetch(const std::uint32_t *indices,
+									std::size_t indexCount,
+									std::size_t vertexCount,
+									std::size_t vertexSize) {
+	constexpr std::size_t kLineSize = 64;
+	constexpr std::size_t kLineCount = 64;
+
+	VertexFetchStats stats;
+	if (indexCount == 0)
+		return stats;
+
+	// Least recently used goes first
+	std::vector<std::size_t> lines;
+	lines.reserve(kLineCount);
+	for (std::size_t i = 0; i < indexCount; i++) {
+		std::size_t start = indices[i] * vertexSize; // NOLINT
+		std::size_t end = start + vertexSize;
+		for (std::size_t line = start / kLineSize; line * kLineSize < end;
+			 line++) {
+			auto it = std::find(lines.begin(), lines.end(), line);
+			if (it != lines.end()) {
+				lines.erase(it);
+			} else {
+				stats.bytesFetched += kLineSize;
+				if (lines.size() == kLineCount)
+					lines.erase(lines.begin());
+			}
+			lines.push_back(line);
+		}
+	}
+
+	std::size_t usedBytes =
+		CountUsedVertices(indices, indexCount, vertexCount) * vertexSize;
+	stats.overfetch = static_cast<double>(stats.bytesFetched) /
+					  static_cast<double>(usedBytes);
+	return stats;
+}
+
+void OptimizeVertexCache(std::uint32_t *indices, std::size_t indexCount,
+						 std::size_t vertexCount, unsigned int cacheSize) {
+	std::size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	Adjacency adjacency(indices, indexCount, vertexCount);
+	// Triangles each vertex is still waiting on
+	std::vector<std::uint32_t> liveTriangles(vertexCount);
+	for (std::size_t v = 0; v < vertexCount; v++)
+		liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+
+	std::vector<std::size_t> cacheTime(vertexCount, 0);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<std::uint32_t> deadEnds;
+	std::vector<std::uint32_t> candidates;
+	std::vector<std::uint32_t> output;
+	output.reserve(indexCount);
+
+	std::size_t time = cacheSize + 1;
+	std::uint32_t cursor = 0;
+	std::uint32_t fanning = 0;
+	while (fanning != kUnused) {
+		candidates.clear();
+
+		// Emit every triangle around the fanning vertex
+		for (std::uint32_t a = adjacency.offsets[fanning];
+			 a < adjacency.offsets[fanning + 1]; a++) {
+			std::uint32_t triangle = adjacency.triangles[a];
+			if (emitted[triangle])
+				continue;
+			emitted[triangle] = true;
+			for (std::size_t corner = 0; corner < 3; corner++) {
+				std::uint32_t vertex = indices[triangle * 3 + corner]; // NOLINT
+				output.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				liveTriangles[vertex]--;
+				if (time - cacheTime[vertex] > cacheSize)
+					cacheTime[vertex] = time++;
+			}
+		}
+
+		// Continue with the candidate that'll still be in the cache after
+		// its remaining triangles are emitted, preferring the oldest one
+		fanning = kUnused;
+		std::size_t bestPriority = 0;
+		for (std::uint32_t vertex : candidates) {
+			if (liveTriangles[vertex] == 0)
+				continue;
+			std::size_t age = time - cacheTime[vertex];
+			if (age + 2 * liveTriangles[vertex] > cacheSize)
+				continue;
+			if (age > bestPriority) {
+				bestPriority = age;
+				fanning = vertex;
+			}
+		}
+
+		// Nothing around here anymore, go back to a recently used vertex,
+		// or failing that the next one with triangles left
+		while (fanning == kUnused && !deadEnds.empty()) {
+			std::uint32_t vertex = deadEnds.back();
+			deadEnds.pop_back();
+			if (liveTriangles[vertex] > 0)
+				fanning = vertex;
+		}
+		while (fanning == kUnused && cursor < vertexCount) {
+			if (liveTriangles[cursor] > 0)
+				fanning = cursor;
+			cursor++;
+		}
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+void OptimizeOverdraw(std::uint32_t *indices, std::size_t indexCount,
+					  const float *positions, std::size_t vertexCount,
+					  std::size_t stride, float threshold,
+					  unsigned int cacheSize) {
+	std::size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	std::vector<unsigned int> misses(triangleCount, 0);
+	FIFOCache cache(vertexCount, cacheSize);
+	for (std::size_t t = 0; t < triangleCount; t++) {
+		for (std::size_t corner = 0; corner < 3; corner++) {
+			std::uint32_t vertex = indices[t * 3 + corner]; // NOLINT
+			misses[t] += cache.access(vertex) ? 1 : 0;
+		}
+	}
+
+	// A triangle that misses on all three vertices starts over with a cold
+	// cache, so moving it around costs nothing
+	std::vector<std::size_t> hardBoundaries;
+	for (std::size_t t = 0; t < triangleCount; t++) {
+		if (t == 0 || misses[t] == 3)
+			hardBoundaries.push_back(t);
+	}
+	hardBoundaries.push_back(triangleCount);
+
+	// Within those, a split is fine once the part before it has an ACMR
+	// close to the whole cluster's, both counted from a cold cache. Then the
+	// misses caused by the split are paid for.
+	auto coldMisses = [&](std::size_t t) {
+		unsigned int count = 0;
+		for (std::size_t corner = 0; corner < 3; corner++) {
+			std::uint32_t vertex = indices[t * 3 + corner]; // NOLINT
+			count += cache.access(vertex) ? 1 : 0;
+		}
+		return count;
+	};
+	std::vector<std::size_t> clusters;
+	for (std::size_t h = 0; h + 1 < hardBoundaries.size(); h++) {
+		std::size_t start = hardBoundaries[h];
+		std::size_t end = hardBoundaries[h + 1];
+		unsigned int clusterMisses = 0;
+		cache.flush();
+		for (std::size_t t = start; t < end; t++)
+			clusterMisses += coldMisses(t);
+		float limit = threshold * static_cast<float>(clusterMisses) /
+					  static_cast<float>(end - start);
+
+		clusters.push_back(start);
+		std::size_t partStart = start;
+		unsigned int partMisses = 0;
+		cache.flush();
+		for (std::size_t t = start; t < end; t++) {
+			partMisses += coldMisses(t);
+			if (t + 1 < end &&
+				static_cast<float>(partMisses) <=
+					limit * static_cast<float>(t + 1 - partStart)) {
+				clusters.push_back(t + 1);
+				partStart = t + 1;
+				partMisses = 0;
+				cache.flush();
+			}
+		}
+	}
+	clusters.push_back(triangleCount);
+
+	// Area weighted centroids and normals
+	std::size_t clusterCount = clusters.size() - 1;
+	std::vector<Float3> centroids(clusterCount);
+	std::vector<Float3> normals(clusterCount);
+	std::vector<float> areas(clusterCount, 0.0f);
+	Float3 meshCentroid;
+	float meshArea = 0.0f;
+	for (std::size_t c = 0; c < clusterCount; c++) {
+		for (std::size_t t = clusters[c]; t < clusters[c + 1]; t++) {
+			// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+			Float3 a = LoadPosition(positions, stride, indices[t * 3]);
+			Float3 b = LoadPosition(positions, stride, indices[t * 3 + 1]);
+			Float3 d = LoadPosition(positions, stride, indices[t * 3 + 2]);
+			// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+			Float3 normal = Cross(b - a, d - a);
+			float area = std::sqrt(Dot(normal, normal));
+			centroids[c] = centroids[c] + (a + b + d) * (area / 3.0f);
+			normals[c] = normals[c] + normal;
+			areas[c] += area;
+		}
+		meshCentroid = meshCentroid + centroids[c];
+		meshArea += areas[c];
+		if (areas[c] > 0.0f)
+			centroids[c] = centroids[c] * (1.0f / areas[c]);
+	}
+	if (meshArea > 0.0f)
+		meshCentroid = meshCentroid * (1.0f / meshArea);
+
+	// Clusters facing away from the center are the likely occluders
+	std::vector<float> keys(clusterCount);
+	for (std::size_t c = 0; c < clusterCount; c++) {
+		float length = std::sqrt(Dot(normals[c], normals[c]));
+		keys[c] = length > 0.0f ? Dot(centroids[c] - meshCentroid, normals[c]) /
+									  length
+								: 0.0f;
+	}
+	std::vector<std::size_t> order(clusterCount);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(),
+					 [&keys](std::size_t a, std::size_t b) {
+						 return keys[a] > keys[b];
+					 });
+
+	std::vector<std::uint32_t> output;
+	output.reserve(indexCount);
+	for (std::size_t c : order) {
+		output.insert(output.end(), indices + clusters[c] * 3,	   // NOLINT
+					  indices + clusters[c + 1] * 3); // NOLINT
+	}
+	std::copy(output.begin(), output.end(), indices);
+}
+
+std::size_t OptimizeVertexFetch(void *vertices, std::size_t vertexCount,
+								std::size_t vertexSize,
+								std::uint32_t *indices,
+								std::size_t indexCount) {
+	std::vector<std::uint32_t> remap(vertexCount, kUnused);
+	std::uint32_t next = 0;
+	for (std::size_t i = 0; i < indexCount; i++) {
+		std::uint32_t &vertex = indices[i]; // NOLINT
+		if (remap[vertex] == kUnused)
+			remap[vertex] = next++;
+		vertex = remap[vertex];
+	}
+
+	auto *bytes = static_cast<unsigned char *>(vertices);
+	std::vector<unsigned char> reordered(next * vertexSize);
+	for (std::size_t v = 0; v < vertexCount; v++) {
+		if (remap[v] != kUnused) {
+			std::memcpy(reordered.data() + remap[v] * vertexSize,
+						bytes + v * vertexSize, vertexSize); // NOLINT
+		}
+	}
+	std::memcpy(vertices, reordered.data(), reordered.size());
+	return next;
+}
+
+MeshOptimizerStats OptimizeMesh(void *vertices, std::size_t &vertexCount,
+								std::size_t vertexSize,
+								std::size_t positionOffset,
+								std::uint32_t *indices,
+								std::size_t indexCount) {
+	using Clock = std::chrono::steady_clock;
+
+	MeshOptimizerStats stats;
+	stats.cacheBefore = AnalyzeVertexCache(indices, indexCount, vertexCount);
+	stats.fetchBefore =
+		AnalyzeVertexFetch(indices, indexCount, vertexCount, vertexSize);
+
+	Clock::time_point start = Clock::now();
+	const auto *positions = reinterpret_cast<const float *>( // NOLINT
+		static_cast<unsigned char *>(vertices) + positionOffset);
+	OptimizeVertexCache(indices, indexCount, vertexCount);
+	OptimizeOverdraw(indices, indexCount, positions, vertexCount, vertexSize);
+	vertexCount = OptimizeVertexFetch(vertices, vertexCount, vertexSize,
+									  indices, indexCount);
+	stats.optimizeMs =
+		std::chrono::duration<double, std::milli>(Clock::now() - start)
+			.count();
+
+	stats.cacheAfter = AnalyzeVertexCache(indices, indexCount, vertexCount);
+	stats.fetchAfter =
+		AnalyzeVertexFetch(indices, indexCount, vertexCount, vertexSize);
+	return stats;
+}
+
+std::vector<MeshOptimizerStats>
+OptimizeMeshes(std::vector<MeshToOptimize> &meshes, JobSystem &jobs) {
+	std::vector<MeshOptimizerStats> stats(meshes.size());
+	// A mesh is plenty of work for a job
+	jobs.parallelFor(meshes.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			MeshToOptimize &mesh = meshes[i];
+			stats[i] = OptimizeMesh(mesh.vertices, mesh.vertexCount,
+									mesh.vertexSize, mesh.positionOffset,
+									mesh.indices, mesh.indexCount);
+		}
+	});
+	return stats;
+}
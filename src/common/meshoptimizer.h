@@ -0,0 +1,115 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+// CPU passes that reorder a triangle list before it's uploaded. They're
+// meant to run in this order, each one keeps the work of the previous:
+//   1. OptimizeVertexCache: reorders triangles so vertices are reused while
+//      they're still in the post-transform cache (Tipsify)
+//   2. OptimizeOverdraw: reorders clusters of those triangles so the ones
+//      facing outwards are drawn first, which lets early-z reject more
+//   3. OptimizeVertexFetch: reorders the vertices in the order the indices
+//      first use them, so fetching them walks memory mostly linearly
+// OptimizeMesh() runs all three.
+//
+// Indices are 32-bit here, IndexBuffer narrows them on upload.
+
+struct VertexCacheStats {
+	// Transformed vertices per triangle, 0.5 is the best a regular grid can
+	// get and 3 is no reuse at all
+	double acmr = 0.0;
+	// Transformed vertices per vertex, 1 is perfect
+	double atvr = 0.0;
+	std::size_t transformedVertices = 0;
+};
+
+struct VertexFetchStats {
+	// Bytes read from memory in whole cache lines
+	std::size_t bytesFetched = 0;
+	// bytesFetched over the size of the vertices actually used, 1 is perfect
+	double overfetch = 0.0;
+};
+
+// Simulates a FIFO post-transform cache with cacheSize entries
+VertexCacheStats AnalyzeVertexCache(const std::uint32_t *indices,
+									std::size_t indexCount,
+									std::size_t vertexCount,
+									unsigned int cacheSize = 16);
+
+// Simulates a small LRU cache of 64 byte lines in front of the vertex data
+VertexFetchStats AnalyzeVertexFetch(const std::uint32_t *indices,
+									std::size_t indexCount,
+									std::size_t vertexCount,
+									std::size_t vertexSize);
+
+// Tipsify, from "Fast Triangle Reordering for Vertex Locality and Reduced
+// Overdraw" by Sander, Nehab and Barczak. Reorders the triangles in place,
+// linear in the number of triangles.
+void OptimizeVertexCache(std::uint32_t *indices, std::size_t indexCount,
+						 std::size_t vertexCount, unsigned int cacheSize = 16);
+
+// Splits the triangles into clusters where the cache gets flushed anyway, or
+// where splitting costs less than threshold times the cluster's ACMR, then
+// sorts the clusters so the ones facing away from the mesh center come
+// first. positions points at the first vertex's x, y, z floats, stride is
+// the vertex size in bytes. Run after OptimizeVertexCache.
+void OptimizeOverdraw(std::uint32_t *indices, std::size_t indexCount,
+					  const float *positions, std::size_t vertexCount,
+					  std::size_t stride, float threshold = 1.05f,
+					  unsigned int cacheSize = 16);
+
+// Moves the vertices into the order in which the indices first reference
+// them and remaps the indices to match. Vertices no index refers to are
+// dropped, the new vertex count is returned.
+std::size_t OptimizeVertexFetch(void *vertices, std::size_t vertexCount,
+								std::size_t vertexSize,
+								std::uint32_t *indices,
+								std::size_t indexCount);
+
+struct MeshOptimizerStats {
+	VertexCacheStats cacheBefore;
+	VertexCacheStats cacheAfter;
+	VertexFetchStats fetchBefore;
+	VertexFetchStats fetchAfter;
+	double optimizeMs = 0.0;
+};
+
+// Runs the whole pipeline on a mesh whose vertices have their position as
+// three floats positionOffset bytes in. vertexCount is updated with the
+// number of vertices that are left.
+MeshOptimizerStats OptimizeMesh(void *vertices, std::size_t &vertexCount,
+								std::size_t vertexSize,
+								std::size_t positionOffset,
+								std::uint32_t *indices,
+								std::size_t indexCount);
+
+template <typename Vertex>
+MeshOptimizerStats OptimizeMesh(std::vector<Vertex> &vertices,
+								std::vector<std::uint32_t> &indices,
+								std::size_t positionOffset = 0) {
+	std::size_t vertexCount = vertices.size();
+	MeshOptimizerStats stats =
+		OptimizeMesh(vertices.data(), vertexCount, sizeof(Vertex),
+					 positionOffset, indices.data(), indices.size());
+	vertices.erase(vertices.begin() + static_cast<std::ptrdiff_t>(vertexCount),
+				   vertices.end());
+	return stats;
+}
+
+// The arguments of one OptimizeMesh call
+struct MeshToOptimize {
+	void *vertices;
+	std::size_t vertexCount;
+	std::size_t vertexSize;
+	std::size_t positionOffset;
+	std::uint32_t *indices;
+	std::size_t indexCount;
+};
+
+// Runs OptimizeMesh on every mesh, one job each, and returns their stats in
+// the same order. The vertex counts are updated in meshes.
+std::vector<MeshOptimizerStats>
+OptimizeMeshes(std::vector<MeshToOptimize> &meshes, JobSystem &jobs);
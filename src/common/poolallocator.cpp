@@ -0,0 +1,80 @@
+#include "poolallocator.h"
+
+#include <algorithm>
+
+namespace {
+
+constexpr std::size_t kBlockAlignment = alignof(std::max_align_t);
+
+// Every block has to be able to hold the free list pointer, and stay aligned
+// when they're laid out back to back
+std::size_t BlockSize(std::size_t size) {
+	size = std::max(size, sizeof(void *));
+	return (size + kBlockAlignment - 1) / kBlockAlignment * kBlockAlignment;
+}
+
+} // namespace
+
+PoolAllocator::PoolAllocator(std::size_t blockSize,
+							 std::size_t blocksPerChunk,
+							 std::pmr::memory_resource *upstream)
+	: m_blockSize(BlockSize(blockSize)),
+	  m_blocksPerChunk(std::max<std::size_t>(blocksPerChunk, 1)),
+	  m_upstream(upstream) {}
+
+PoolAllocator::~PoolAllocator() {
+	for (void *chunk : m_chunks)
+		m_upstream->deallocate(chunk, m_blockSize * m_blocksPerChunk,
+							   kBlockAlignment);
+}
+
+void PoolAllocator::grow() {
+	auto *chunk = static_cast<std::byte *>(m_upstream->allocate(
+		m_blockSize * m_blocksPerChunk, kBlockAlignment));
+	m_chunks.push_back(chunk);
+	// Thread the new blocks onto the free list, the first one on top
+	for (std::size_t i = m_blocksPerChunk; i-- > 0;) {
+		void *block = chunk + i * m_blockSize; // NOLINT
+		*static_cast<void **>(block) = m_free;
+		m_free = block;
+	}
+}
+
+void *PoolAllocator::allocateBlock() {
+	if (!m_free)
+		grow();
+	void *block = m_free;
+	m_free = *static_cast<void **>(block);
+	m_blocksUsed++;
+	return block;
+}
+
+void PoolAllocator::deallocateBlock(void *block) {
+	*static_cast<void **>(block) = m_free;
+	m_free = block;
+	m_blocksUsed--;
+}
+
+bool PoolAllocator::fits(std::size_t bytes, std::size_t alignment) const {
+	return bytes <= m_blockSize && alignment <= kBlockAlignment;
+}
+
+void *PoolAllocator::do_allocate(std::size_t bytes, std::size_t alignment) {
+	if (!fits(bytes, alignment))
+		return m_upstream->allocate(bytes, alignment);
+	return allocateBlock();
+}
+
+void PoolAllocator::do_deallocate(void *pointer, std::size_t bytes,
+								  std::size_t alignment) {
+	if (!fits(bytes, alignment)) {
+		m_upstream->deallocate(pointer, bytes, alignment);
+		return;
+	}
+	deallocateBlock(pointer);
+}
+
+bool PoolAllocator::do_is_equal(
+	const std::pmr::memory_resource &other) const noexcept {
+	return this == &other;
+}
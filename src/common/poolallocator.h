@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Hands out blocks of one size and takes them back onto a free list, so
+// render objects that come and go every frame don't go through the global
+// heap once the pool has grown to the peak count. Blocks are carved out of
+// chunks of blocksPerChunk from upstream, which are only given back when the
+// pool is destroyed.
+//
+// As a std::pmr::memory_resource it serves every request that fits into a
+// block, bigger or more strictly aligned ones are passed on to upstream.
+//
+// Not thread safe.
+class PoolAllocator : public std::pmr::memory_resource {
+  private:
+	std::size_t m_blockSize;
+	std::size_t m_blocksPerChunk;
+	std::pmr::memory_resource *m_upstream;
+	std::vector<void *> m_chunks;
+	// Free blocks, each one holds a pointer to the next
+	void *m_free = nullptr;
+	std::size_t m_blocksUsed = 0;
+
+	void grow();
+	[[nodiscard]] bool fits(std::size_t bytes, std::size_t alignment) const;
+
+  protected:
+	void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+	void do_deallocate(void *pointer, std::size_t bytes,
+					   std::size_t alignment) override;
+	[[nodiscard]] bool
+	do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+  public:
+	explicit PoolAllocator(
+		std::size_t blockSize, std::size_t blocksPerChunk = 256,
+		std::pmr::memory_resource *upstream = std::pmr::get_default_resource());
+	PoolAllocator(const PoolAllocator &other) = delete;
+	PoolAllocator(PoolAllocator &&other) = delete;
+	PoolAllocator &operator=(const PoolAllocator &other) = delete;
+	PoolAllocator &operator=(PoolAllocator &&other) = delete;
+	~PoolAllocator() override;
+
+	// A block of GetBlockSize() bytes, aligned like std::max_align_t
+	[[nodiscard]] void *allocateBlock();
+	void deallocateBlock(void *block);
+
+	[[nodiscard]] inline std::size_t GetBlockSize() const {
+		return m_blockSize;
+	};
+	[[nodiscard]] inline std::size_t GetBlocksUsed() const {
+		return m_blocksUsed;
+	};
+	[[nodiscard]] inline std::size_t GetBlockCount() const {
+		return m_chunks.size() * m_blocksPerChunk;
+	};
+};
+
+// A PoolAllocator sized for T that constructs and destroys them
+template <typename T> class ObjectPool {
+	static_assert(alignof(T) <= alignof(std::max_align_t),
+				  "Pool blocks are only aligned like std::max_align_t");
+
+  private:
+	PoolAllocator m_pool;
+
+  public:
+	explicit ObjectPool(
+		std::size_t objectsPerChunk = 256,
+		std::pmr::memory_resource *upstream = std::pmr::get_default_resource())
+		: m_pool(sizeof(T), objectsPerChunk, upstream) {}
+
+	template <typename... Args> T *create(Args &&...args) {
+		void *block = m_pool.allocateBlock();
+		try {
+			return new (block) T(std::forward<Args>(args)...);
+		} catch (...) {
+			m_pool.deallocateBlock(block);
+			throw;
+		}
+	}
+
+	void destroy(T *object) {
+		if (!object)
+			return;
+		object->~T();
+		m_pool.deallocateBlock(object);
+	}
+
+	[[nodiscard]] inline PoolAllocator &GetAllocator() {
+		return m_pool;
+	};
+	[[nodiscard]] inline std::size_t GetCount() const {
+		return m_pool.GetBlocksUsed();
+	};
+};
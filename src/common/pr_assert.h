@@ -0,0 +1,8 @@
+#pragma once
+#include "debugbreak.h"
+
+// Stops in the debugger when x is false. Doesn't need GL, so code that has
+// nothing to do with rendering can use it without pulling in renderer.h.
+#define ASSERT(x)                                                              \
+	if (!(x))                                                                  \
+	debug_break()
@@ -1,34 +1,146 @@
 #include "pr_glfw.h"
+#include "benchmark.h"
+#include "deletionqueue.h"
+#include "framearena.h"
+#include <cstdlib>
 #include <type_traits>
 
 namespace GLFWObjects {
-Window::Window(int width, int height, std::string_view title) {
-	window = glfwCreateWindow(width, height, title.data(), nullptr, nullptr);
+
+static ContextBackend BackendFromName(std::string_view name,
+									  ContextBackend fallback) {
+	if (name == "egl")
+		return ContextBackend::HEADLESS_EGL;
+	if (name == "osmesa")
+		return ContextBackend::HEADLESS_OSMESA;
+	if (name == "windowed")
+		return ContextBackend::WINDOWED;
+	return fallback;
+}
+
+LaunchOptions LaunchOptions::parse(int argc, char **argv) {
+	LaunchOptions options;
+
+	if (const char *env = std::getenv("PR_GL_BACKEND"))
+		options.backend = BackendFromName(env, options.backend);
+
+	if (HasArg(argc, argv, "--headless"))
+		options.backend = ContextBackend::HEADLESS_EGL;
+	std::string_view backend = GetArgString(argc, argv, "--headless=", {});
+	if (!backend.empty())
+		options.backend =
+			BackendFromName(backend, ContextBackend::HEADLESS_EGL);
+	options.frameLimit =
+		GetArgValue(argc, argv, "--frames=", options.frameLimit);
+	options.tracePath = GetArgString(argc, argv, "--trace=", {});
+	options.hotReload = HasArg(argc, argv, "--hot-reload");
+
+	// Nobody is going to close a window that doesn't exist
+	if (options.backend != ContextBackend::WINDOWED && options.frameLimit == 0)
+		options.frameLimit = 1000;
+
+	return options;
+}
+
+Window::Window(int width, int height, std::string_view title,
+			   const Window *share)
+	: m_headless(GLFW::getInstance().getBackend() !=
+				 ContextBackend::WINDOWED) {
+	window = glfwCreateWindow(width, height, title.data(), nullptr,
+							  share ? share->window : nullptr);
+}
+
+Window::Window(Window &&other) noexcept
+	: window(other.window), m_headless(other.m_headless),
+	  m_frameLimit(other.m_frameLimit), m_frameCount(other.m_frameCount),
+	  m_frameArena(other.m_frameArena) {
+	other.window = nullptr;
+}
+
+Window::~Window() {
+	if (!window)
+		return;
+	// The wrappers destroyed before the window queued their buffers
+	if (glfwGetCurrentContext() == window)
+		DeletionQueue::get().flush();
+	glfwDestroyWindow(window);
+}
+
+Window Window::createSharedContext(const Window &share) {
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	Window context(1, 1, "Shared context", &share);
+	// Don't hide the windows created after this one
+	if (!context.m_headless)
+		glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+	return context;
 }
 
 bool Window::isValid() {
 	return window;
 }
 
+bool Window::isHeadless() const {
+	return m_headless;
+}
+
 bool Window::shouldClose() {
+	if (m_frameLimit != 0 && m_frameCount >= m_frameLimit)
+		return true;
 	return glfwWindowShouldClose(window);
 }
 
 void Window::swapBuffers() {
+	m_frameCount++;
 	glfwSwapBuffers(window);
+	if (glfwGetCurrentContext() == window)
+		DeletionQueue::get().endFrame();
+	if (m_frameArena)
+		m_frameArena->nextFrame();
+}
+
+void Window::setFrameArena(FrameArena *arena) {
+	m_frameArena = arena;
 }
 
 void Window::setFramebufferSizeCallback(GLFWframebuffersizefun callback) {
 	glfwSetFramebufferSizeCallback(window, callback);
 }
 
+void Window::setFrameLimit(unsigned long frameLimit) {
+	m_frameLimit = frameLimit;
+}
+
 GLFW &GLFW::getInstance() {
 	static GLFW instance;
 	return instance;
 }
 
-int GLFW::init() {
-	return glfwInit();
+int GLFW::init(ContextBackend backend) {
+	m_backend = backend;
+
+#if GLFW_VERSION_MAJOR > 3 ||                                                  \
+	(GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 4)
+	// Render nodes have no X11/Wayland server, so skip connecting to one
+	// altogether. The null platform still supports EGL and OSMesa contexts.
+	if (backend != ContextBackend::WINDOWED &&
+		glfwPlatformSupported(GLFW_PLATFORM_NULL))
+		glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
+
+	if (!glfwInit())
+		return GLFW_FALSE;
+
+	if (backend != ContextBackend::WINDOWED) {
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		// EGL gives us a surfaceless/pbuffer context on Mesa, OSMesa renders
+		// with llvmpipe straight into client memory
+		glfwWindowHint(GLFW_CONTEXT_CREATION_API,
+					   backend == ContextBackend::HEADLESS_EGL
+						   ? GLFW_EGL_CONTEXT_API
+						   : GLFW_OSMESA_CONTEXT_API);
+	}
+
+	return GLFW_TRUE;
 }
 
 void GLFW::makeContextCurrent(const Window &window) {
@@ -38,4 +150,5 @@ void GLFW::makeContextCurrent(const Window &window) {
 GLFW::~GLFW() {
 	glfwTerminate();
 }
-} // namespace GLFWObjects
\ No newline at end of file
+
+} // namespace GLFWObjects
@@ -1,25 +1,79 @@
+#pragma once
+// glbinding declares the GL API, and refuses to be included after the
+// system's gl.h that GLFW would otherwise pull in
+#ifndef GLFW_INCLUDE_NONE
+#define GLFW_INCLUDE_NONE
+#endif
 #include "GLFW/glfw3.h"
 #include <cassert>
 #include <string>
 
+class FrameArena;
+
 namespace GLFWObjects {
+
+// The kind of context that gets created. The headless backends don't need a
+// display server and never show a window, so the executable has to render into
+// an offscreen Framebuffer instead of the default one.
+enum class ContextBackend { WINDOWED, HEADLESS_EGL, HEADLESS_OSMESA };
+
+// Command line options shared by all the executables
+//   --headless[=egl|osmesa]  render offscreen (egl is the default)
+//   --frames=N               stop after N frames
+//   --trace=FILE             write a Chrome trace of the profiled zones
+//   --hot-reload             rebuild shaders when their files change
+// The PR_GL_BACKEND environment variable (windowed, egl or osmesa) is used
+// when --headless isn't passed.
+struct LaunchOptions {
+	ContextBackend backend = ContextBackend::WINDOWED;
+	// 0 means run until the window is closed
+	unsigned long frameLimit = 0;
+	// Empty means profiling is disabled
+	std::string tracePath;
+	bool hotReload = false;
+
+	static LaunchOptions parse(int argc, char **argv);
+};
+
 class Window {
 	friend class GLFW;
 
   public:
-	Window(int width, int height, std::string_view title);
+	Window(int width, int height, std::string_view title,
+		   const Window *share = nullptr);
+	Window(const Window &other) = delete;
+	Window(Window &&other) noexcept;
+	Window &operator=(const Window &other) = delete;
+	Window &operator=(Window &&other) = delete;
+	// Flushes the DeletionQueue if the context is current
+	~Window();
+
+	// A hidden window whose context shares objects (buffers, programs,
+	// textures...) with share's, so that a worker thread can create them
+	static Window createSharedContext(const Window &share);
+
 	bool isValid();
+	bool isHeadless() const;
 	bool shouldClose();
+	// Also moves the attached FrameArena on to the next frame and, if the
+	// context is current, deletes the DeletionQueue's finished buffers
 	void swapBuffers();
+	void setFrameArena(FrameArena *arena);
 	void setFramebufferSizeCallback(GLFWframebuffersizefun callback);
+	void setFrameLimit(unsigned long frameLimit);
 
   private:
 	GLFWwindow *window;
+	bool m_headless;
+	unsigned long m_frameLimit = 0;
+	unsigned long m_frameCount = 0;
+	FrameArena *m_frameArena = nullptr;
 };
 
 class GLFW {
   private:
 	GLFW() = default;
+	ContextBackend m_backend = ContextBackend::WINDOWED;
 
   public:
 	static GLFW &getInstance();
@@ -27,12 +81,16 @@ class GLFW {
 	enum class WindowHint {
 		CONTEXT_VERSION_MAJOR,
 		CONTEXT_VERSION_MINOR,
-		OPENGL_PROFILE
+		OPENGL_PROFILE,
+		OPENGL_DEBUG_CONTEXT
 	};
 
 	enum class OpenGL_Profile { OPENGL_CORE_PROFILE, OPENGL_COMPAT_PROFILE };
 
-	int init();
+	int init(ContextBackend backend = ContextBackend::WINDOWED);
+	[[nodiscard]] inline ContextBackend getBackend() const {
+		return m_backend;
+	}
 	template <typename T> void setWindowHint(WindowHint hint, T value) {
 		if constexpr (std::is_same_v<T, OpenGL_Profile>) {
 			assert(hint == WindowHint::OPENGL_PROFILE);
@@ -48,6 +106,10 @@ class GLFW {
 			} else {
 				glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, value);
 			}
+		} else if constexpr (std::is_same_v<T, bool>) {
+			assert(hint == WindowHint::OPENGL_DEBUG_CONTEXT);
+			glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT,
+						   value ? GLFW_TRUE : GLFW_FALSE);
 		} else {
 			static_assert(std::is_same_v<T, void>, "Bad call");
 		}
@@ -62,4 +124,4 @@ class GLFW {
 	~GLFW();
 };
 
-} // namespace GLFWObjects
\ No newline at end of file
+} // namespace GLFWObjects
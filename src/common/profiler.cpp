@@ -0,0 +1,158 @@
+#include "profiler.h"
+
+#include "glbinding/gl/gl.h"
+#include "renderer.h"
+
+#include <fstream>
+#include <iostream>
+
+using namespace gl;
+
+Profiler &Profiler::getInstance() {
+	static Profiler instance;
+	return instance;
+}
+
+void Profiler::enable(std::string tracePath) {
+	m_tracePath = std::move(tracePath);
+	m_enabled = true;
+
+	GLint64 gpuNow = 0;
+	GLCall(glGetInteger64v(GL_TIMESTAMP, &gpuNow));
+	m_gpuEpoch = gpuNow;
+	m_cpuEpoch = Clock::now();
+}
+
+unsigned int Profiler::acquireQuery() {
+	if (m_queryPool.empty()) {
+		// Grow in chunks, it's one driver call either way
+		constexpr int kChunk = 32;
+		std::vector<GLuint> queries(kChunk);
+		GLCall(glGenQueries(kChunk, queries.data()));
+		m_queryPool.insert(m_queryPool.end(), queries.begin(), queries.end());
+	}
+	unsigned int query = m_queryPool.back();
+	m_queryPool.pop_back();
+	return query;
+}
+
+unsigned int Profiler::beginGPUZone(const char *name) {
+	unsigned int startQuery = acquireQuery();
+	unsigned int endQuery = acquireQuery();
+	GLCall(glQueryCounter(startQuery, GL_TIMESTAMP));
+	m_pendingZones.push_back({name, startQuery, endQuery, m_frame});
+	return endQuery;
+}
+
+void Profiler::endGPUZone(unsigned int endQuery) {
+	GLCall(glQueryCounter(endQuery, GL_TIMESTAMP));
+}
+
+void Profiler::addCPUZone(const char *name, Clock::time_point start,
+						  Clock::time_point end) {
+	std::chrono::duration<double, std::micro> startUs = start - m_cpuEpoch;
+	std::chrono::duration<double, std::micro> durationUs = end - start;
+	m_events.push_back({name, false, startUs.count(), durationUs.count()});
+}
+
+bool Profiler::resolve(const PendingGPUZone &zone, bool wait) {
+	if (!wait) {
+		// The end query is always the last one to complete
+		GLuint available = 0;
+		GLCall(glGetQueryObjectuiv(zone.endQuery, GL_QUERY_RESULT_AVAILABLE,
+								   &available));
+		if (!available)
+			return false;
+	}
+
+	GLuint64 start = 0;
+	GLuint64 end = 0;
+	GLCall(glGetQueryObjectui64v(zone.startQuery, GL_QUERY_RESULT, &start));
+	GLCall(glGetQueryObjectui64v(zone.endQuery, GL_QUERY_RESULT, &end));
+
+	double startUs =
+		static_cast<double>(static_cast<GLint64>(start) - m_gpuEpoch) / 1000.0;
+	double durationUs = static_cast<double>(end - start) / 1000.0;
+	m_events.push_back({zone.name, true, startUs, durationUs});
+
+	m_queryPool.push_back(zone.startQuery);
+	m_queryPool.push_back(zone.endQuery);
+	return true;
+}
+
+void Profiler::endFrame() {
+	if (!m_enabled)
+		return;
+
+	m_frame++;
+	while (!m_pendingZones.empty() &&
+		   m_pendingZones.front().frame + kReadbackLatency <= m_frame) {
+		if (!resolve(m_pendingZones.front(), false))
+			break;
+		m_pendingZones.pop_front();
+	}
+}
+
+void Profiler::disable() {
+	if (!m_enabled)
+		return;
+
+	// Every query is back in the pool once its zone is resolved
+	while (!m_pendingZones.empty()) {
+		resolve(m_pendingZones.front(), true);
+		m_pendingZones.pop_front();
+	}
+	if (!m_queryPool.empty()) {
+		GLCall(glDeleteQueries(static_cast<GLsizei>(m_queryPool.size()),
+							   m_queryPool.data()));
+	}
+	m_queryPool.clear();
+	m_enabled = false;
+}
+
+bool Profiler::writeTrace() {
+	if (!m_enabled)
+		return false;
+	disable();
+
+	std::ofstream out(m_tracePath);
+	if (!out) {
+		std::cerr << "Failed to open the trace file " << m_tracePath
+				  << std::endl;
+		return false;
+	}
+
+	// The CPU and the GPU get their own rows in the viewer
+	out << "{\"traceEvents\": [\n";
+	for (size_t i = 0; i < m_events.size(); i++) {
+		const TraceEvent &event = m_events[i];
+		out << "{\"name\": \"" << event.name << "\", \"cat\": \""
+			<< (event.gpu ? "gpu" : "cpu")
+			<< "\", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+			<< (event.gpu ? 2 : 1) << ", \"ts\": " << event.startUs
+			<< ", \"dur\": " << event.durationUs << "}"
+			<< (i + 1 < m_events.size() ? ",\n" : "\n");
+	}
+	out << "],\n\"displayTimeUnit\": \"ms\"}\n";
+	return true;
+}
+
+ScopedCPUZone::ScopedCPUZone(const char *name)
+	: m_name(name), m_start(Profiler::Clock::now()) {}
+
+ScopedCPUZone::~ScopedCPUZone() {
+	Profiler &profiler = Profiler::getInstance();
+	if (profiler.isEnabled())
+		profiler.addCPUZone(m_name, m_start, Profiler::Clock::now());
+}
+
+ScopedGPUZone::ScopedGPUZone(const char *name) {
+	Profiler &profiler = Profiler::getInstance();
+	if (profiler.isEnabled())
+		m_endQuery = profiler.beginGPUZone(name);
+}
+
+ScopedGPUZone::~ScopedGPUZone() {
+	if (m_endQuery != 0)
+		Profiler::getInstance().endGPUZone(m_endQuery);
+}
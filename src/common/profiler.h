@@ -0,0 +1,128 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+// Collects CPU and GPU timings of named zones and writes them to a file in the
+// Chrome trace_event format (open it in chrome://tracing or ui.perfetto.dev).
+//
+// GPU zones are measured with a pair of GL_TIMESTAMP queries taken from a pool.
+// The results are only read back kReadbackLatency frames later, and only once
+// the driver reports them as available, so the CPU never stalls on the GPU.
+// Timestamps are used rather than GL_TIME_ELAPSED since those can be nested
+// and can be placed on the same timeline as the CPU zones.
+//
+// Zone names must outlive the profiler, string literals are the intended use.
+//
+// Usage:
+//   Profiler::getInstance().enable("trace.json");
+//   while (...) {
+//       PROFILE_ZONE("Frame");
+//       {
+//           PROFILE_GPU_ZONE("Draw");
+//           glDrawElements(...);
+//       }
+//       glfwSwapBuffers(window);
+//       Profiler::getInstance().endFrame();
+//   }
+//   Profiler::getInstance().writeTrace();
+class Profiler {
+  public:
+	using Clock = std::chrono::steady_clock;
+	static constexpr unsigned int kReadbackLatency = 3;
+
+  private:
+	Profiler() = default;
+
+	struct PendingGPUZone {
+		const char *name;
+		unsigned int startQuery;
+		unsigned int endQuery;
+		unsigned long frame;
+	};
+
+	struct TraceEvent {
+		const char *name;
+		bool gpu;
+		double startUs;
+		double durationUs;
+	};
+
+	bool m_enabled = false;
+	std::string m_tracePath;
+	unsigned long m_frame = 0;
+
+	// Matching points in time on both clocks, used to put the GPU timestamps
+	// on the CPU timeline
+	Clock::time_point m_cpuEpoch;
+	std::int64_t m_gpuEpoch = 0;
+
+	std::vector<unsigned int> m_queryPool;
+	std::deque<PendingGPUZone> m_pendingZones;
+	std::vector<TraceEvent> m_events;
+
+	unsigned int acquireQuery();
+	// Returns false if the results aren't available yet and wait is false
+	bool resolve(const PendingGPUZone &zone, bool wait);
+
+  public:
+	static Profiler &getInstance();
+
+	// Needs a current context. Until this is called all zones are no-ops.
+	void enable(std::string tracePath);
+	[[nodiscard]] inline bool isEnabled() const {
+		return m_enabled;
+	}
+
+	// Call once per frame, after swapping the buffers
+	void endFrame();
+	// Waits for the outstanding GPU zones, deletes the queries and turns the
+	// zones back into no-ops. Needs the context still current.
+	void disable();
+	// Disables the profiler and writes the trace file
+	bool writeTrace();
+
+	[[nodiscard]] unsigned int beginGPUZone(const char *name);
+	void endGPUZone(unsigned int endQuery);
+	void addCPUZone(const char *name, Clock::time_point start,
+					Clock::time_point end);
+
+	Profiler(const Profiler &other) = delete;
+	Profiler(const Profiler &&other) = delete;
+	Profiler &operator=(const Profiler &other) = delete;
+	Profiler &operator=(const Profiler &&other) = delete;
+
+	~Profiler() = default;
+};
+
+class ScopedCPUZone {
+  private:
+	const char *m_name;
+	Profiler::Clock::time_point m_start;
+
+  public:
+	explicit ScopedCPUZone(const char *name);
+	ScopedCPUZone(const ScopedCPUZone &other) = delete;
+	ScopedCPUZone &operator=(const ScopedCPUZone &other) = delete;
+	~ScopedCPUZone();
+};
+
+class ScopedGPUZone {
+  private:
+	unsigned int m_endQuery = 0;
+
+  public:
+	explicit ScopedGPUZone(const char *name);
+	ScopedGPUZone(const ScopedGPUZone &other) = delete;
+	ScopedGPUZone &operator=(const ScopedGPUZone &other) = delete;
+	~ScopedGPUZone();
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_ZONE(name)                                                     \
+	ScopedCPUZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_GPU_ZONE(name)                                                 \
+	ScopedGPUZone PROFILE_CONCAT(profileGPUZone, __LINE__)(name)
@@ -0,0 +1,157 @@
+#include "programbuilder.h"
+
+#include "renderer.h"
+#include "shadercompiler.h"
+
+#include <iostream>
+#include <string>
+#include <utility>
+
+using namespace gl;
+
+ProgramBuilder::ProgramBuilder() {
+	if (GLHasExtension("GL_KHR_parallel_shader_compile")) {
+		m_parallel = true;
+		// Let the driver pick as many threads as it likes
+		GLCall(glMaxShaderCompilerThreadsKHR(0xFFFFFFFF));
+	} else if (GLHasExtension("GL_ARB_parallel_shader_compile")) {
+		m_parallel = true;
+		GLCall(glMaxShaderCompilerThreadsARB(0xFFFFFFFF));
+	}
+}
+
+ProgramBuilder::~ProgramBuilder() {
+	// Builds nobody waited for, e.g. after an early return
+	for (auto &[id, build] : m_builds) {
+		for (GLuint shader : build.shaders) {
+			GLCall(glDeleteShader(shader));
+		}
+		if (build.program != 0) {
+			GLCall(glDeleteProgram(build.program));
+		}
+	}
+}
+
+ProgramBuilder::BuildID
+ProgramBuilder::submit(const std::vector<StageSource> &stages,
+					   bool binaryRetrievable) {
+	Build build;
+	build.program = GLCallV(glCreateProgram());
+	if (binaryRetrievable) {
+		// Has to be set before linking, GL_TRUE
+		GLCall(glProgramParameteri(build.program,
+								   GL_PROGRAM_BINARY_RETRIEVABLE_HINT, 1));
+	}
+
+	for (const auto &[type, pieces] : stages) {
+		GLuint shader = SubmitShader(type, pieces);
+		GLCall(glAttachShader(build.program, shader));
+		build.shaders.push_back(shader);
+	}
+
+	// Querying the compile status here would wait for the compiler, the link
+	// status tells us everything we need later on
+	GLCall(glLinkProgram(build.program));
+
+	BuildID id = m_nextID++;
+	m_builds.emplace(id, std::move(build));
+	return id;
+}
+
+ProgramBuilder::BuildID ProgramBuilder::submit(const ShaderSource &source,
+											   bool binaryRetrievable) {
+	std::vector<StageSource> stages;
+	for (size_t i = 0; i < kShaderStageCount; i++) {
+		auto stage = static_cast<ShaderStage>(i);
+		if (source.hasStage(stage))
+			stages.emplace_back(GetShaderStageType(stage),
+								source.pieces(stage));
+	}
+	return submit(stages, binaryRetrievable);
+}
+
+ProgramBuilder::Status ProgramBuilder::poll(BuildID id) {
+	Build &build = m_builds.at(id);
+	if (build.status != Status::PENDING)
+		return build.status;
+
+	if (m_parallel) {
+		GLint done = 0;
+		GLCall(glGetProgramiv(build.program, GL_COMPLETION_STATUS_KHR, &done));
+		if (done == 0)
+			return Status::PENDING;
+	}
+	return finish(build);
+}
+
+bool ProgramBuilder::ready(BuildID id) const {
+	const Build &build = m_builds.at(id);
+	if (build.status != Status::PENDING || !m_parallel)
+		return true;
+
+	GLint done = 0;
+	GLCall(glGetProgramiv(build.program, GL_COMPLETION_STATUS_KHR, &done));
+	return done != 0;
+}
+
+GLuint ProgramBuilder::wait(BuildID id) {
+	auto it = m_builds.find(id);
+	if (it == m_builds.end())
+		return 0;
+	if (it->second.status == Status::PENDING)
+		finish(it->second);
+	GLuint program = it->second.program;
+	// The caller owns the program now, nothing left to track
+	m_builds.erase(it);
+	return program;
+}
+
+GLuint ProgramBuilder::getProgram(BuildID id) const {
+	const Build &build = m_builds.at(id);
+	return build.status == Status::READY ? build.program : 0;
+}
+
+ProgramBuilder::Status ProgramBuilder::finish(Build &build) {
+	GLint linked = 0;
+	GLCall(glGetProgramiv(build.program, GL_LINK_STATUS, &linked));
+
+	if (linked == 0) {
+		// Something went wrong, now it's worth asking for the logs
+		for (GLuint shader : build.shaders) {
+			GLint compiled = 0;
+			GLCall(glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled));
+			if (compiled != 0)
+				continue;
+			GLint length = 0;
+			GLCall(glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length));
+			std::string message(static_cast<size_t>(length), '\0');
+			GLCall(glGetShaderInfoLog(shader, length, nullptr, message.data()));
+			std::cerr << "Failed to compile shader!" << std::endl
+					  << message << std::endl;
+		}
+
+		GLint length = 0;
+		GLCall(glGetProgramiv(build.program, GL_INFO_LOG_LENGTH, &length));
+		std::string message(static_cast<size_t>(length), '\0');
+		GLCall(glGetProgramInfoLog(build.program, length, nullptr,
+								   message.data()));
+		std::cerr << "Failed to link program!" << std::endl
+				  << message << std::endl;
+	}
+
+	// The linked program doesn't need them anymore
+	for (GLuint shader : build.shaders) {
+		GLCall(glDetachShader(build.program, shader));
+		GLCall(glDeleteShader(shader));
+	}
+	build.shaders.clear();
+
+	if (linked == 0) {
+		GLCall(glDeleteProgram(build.program));
+		build.program = 0;
+		build.status = Status::FAILED;
+	} else {
+		build.status = Status::READY;
+	}
+	return build.status;
+}
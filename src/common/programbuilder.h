@@ -0,0 +1,80 @@
+#pragma once
+#include "shadersource.h"
+
+#include <glbinding/gl/gl.h>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Builds programs without waiting on the driver's compiler. submit() hands
+// every stage to the driver and links right away without checking anything,
+// so the driver can compile many programs in parallel while the caller moves
+// on to other startup work. With KHR_parallel_shader_compile (or the ARB
+// version) poll() uses GL_COMPLETION_STATUS_KHR and never blocks. Without it
+// drivers still compile in the background until the status is queried, and
+// poll() has to block. ready() never blocks, it just reports a build as done
+// when there's no way to tell.
+//
+// The info logs are only queried when a build fails. Programs that were never
+// handed over by wait() are deleted with the builder, which needs the context
+// still current then.
+//
+// Usage:
+//   ProgramBuilder builder;
+//   auto a = builder.submit(sourceA);
+//   auto b = builder.submit(sourceB);
+//   ... create buffers, load textures ...
+//   GLuint programA = builder.wait(a);
+class ProgramBuilder {
+  public:
+	enum class Status { PENDING, READY, FAILED };
+	using BuildID = size_t;
+	using StageSource = std::pair<gl::GLenum, std::vector<std::string_view>>;
+
+  private:
+	struct Build {
+		gl::GLuint program = 0;
+		std::vector<gl::GLuint> shaders;
+		Status status = Status::PENDING;
+	};
+
+	bool m_parallel = false;
+	// Only builds nobody has waited for yet
+	std::unordered_map<BuildID, Build> m_builds;
+	BuildID m_nextID = 0;
+
+	Status finish(Build &build);
+
+  public:
+	// Needs a current context
+	ProgramBuilder();
+	ProgramBuilder(const ProgramBuilder &other) = delete;
+	ProgramBuilder(ProgramBuilder &&other) = delete;
+	ProgramBuilder &operator=(const ProgramBuilder &other) = delete;
+	ProgramBuilder &operator=(ProgramBuilder &&other) = delete;
+	~ProgramBuilder();
+
+	// Set binaryRetrievable if the program is going to be passed to
+	// glGetProgramBinary
+	BuildID submit(const std::vector<StageSource> &stages,
+				   bool binaryRetrievable = false);
+	BuildID submit(const ShaderSource &source, bool binaryRetrievable = false);
+
+	// Doesn't block when parallel compilation is supported
+	Status poll(BuildID id);
+	// Never blocks. True once wait() is known not to stall on the compiler,
+	// and always without parallel compilation.
+	[[nodiscard]] bool ready(BuildID id) const;
+	// Blocks until the build is done, returns the program or 0 on failure.
+	// Hands the program over to the caller and forgets the build, so the ID
+	// can't be used afterwards.
+	gl::GLuint wait(BuildID id);
+	// The program of a READY build, 0 otherwise. The builder owns it until
+	// wait() hands it over.
+	[[nodiscard]] gl::GLuint getProgram(BuildID id) const;
+
+	[[nodiscard]] inline bool isParallel() const {
+		return m_parallel;
+	}
+};
@@ -0,0 +1,230 @@
+#include "programcache.h"
+
+#include "renderer.h"
+#include "shadercompiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+using namespace gl;
+
+namespace {
+
+constexpr std::uint32_t kMagic = 0x42505250; // "PRPB"
+
+struct BinaryHeader {
+	std::uint32_t magic;
+	std::uint32_t format;
+	std::uint64_t key;
+	std::uint64_t length;
+};
+
+// 64-bit FNV-1a, stable across runs and platforms unlike std::hash
+std::uint64_t HashBytes(std::string_view bytes, std::uint64_t hash) {
+	for (char c : bytes) {
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 0x100000001b3ULL;
+	}
+	// Separate the fields so "ab"+"c" and "a"+"bc" hash differently
+	hash ^= 0xff;
+	hash *= 0x100000001b3ULL;
+	return hash;
+}
+
+std::string GetString(GLenum name) {
+	const GLubyte *str = GLCallV(glGetString(name));
+	return str ? reinterpret_cast<const char *>(str) : ""; // NOLINT
+}
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+	std::chrono::duration<double, std::milli> elapsed =
+		std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+} // namespace
+
+ProgramCache::ProgramCache(std::string directory)
+	: m_directory(std::move(directory)) {
+	m_driverID = GetString(GL_VENDOR) + "\n" + GetString(GL_RENDERER) + "\n" +
+				 GetString(GL_VERSION);
+
+	GLint formats = 0;
+	GLCall(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats));
+	m_supported = formats > 0;
+	if (m_supported) {
+		std::vector<GLint> values(static_cast<size_t>(formats));
+		GLCall(glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, values.data()));
+		for (GLint value : values)
+			m_formats.push_back(static_cast<GLenum>(value));
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(m_directory, error);
+	if (error) {
+		std::cerr << "[ProgramCache] Can't create " << m_directory << ": "
+				  << error.message() << std::endl;
+		m_supported = false;
+	}
+}
+
+ProgramCache::Request
+ProgramCache::request(const std::string &vertexShaderSrc,
+					  const std::string &fragmentShaderSrc,
+					  const std::vector<std::string> &defines) {
+	auto start = std::chrono::steady_clock::now();
+
+	std::string vertexSrc = ApplyDefines(vertexShaderSrc, defines);
+	std::string fragmentSrc = ApplyDefines(fragmentShaderSrc, defines);
+
+	Request request;
+	request.key = 0xcbf29ce484222325ULL;
+	request.key = HashBytes(m_driverID, request.key);
+	request.key = HashBytes(vertexSrc, request.key);
+	request.key = HashBytes(fragmentSrc, request.key);
+
+	std::ostringstream name;
+	name << std::hex << std::setw(16) << std::setfill('0') << request.key
+		 << ".bin";
+	request.path = (std::filesystem::path(m_directory) / name.str()).string();
+
+	if (m_supported) {
+		GLuint program = GLCallV(glCreateProgram());
+		if (load(request.path, request.key, program)) {
+			m_stats.hits++;
+			m_stats.loadMs += MillisecondsSince(start);
+			request.program = program;
+			return request;
+		}
+		GLCall(glDeleteProgram(program));
+	}
+
+	m_stats.misses++;
+	request.build = m_builder.submit(
+		{{GL_VERTEX_SHADER, {vertexSrc}}, {GL_FRAGMENT_SHADER, {fragmentSrc}}},
+		m_supported);
+	m_stats.compileMs += MillisecondsSince(start);
+	return request;
+}
+
+bool ProgramCache::ready(const Request &request) const {
+	return !request.build || m_builder.ready(*request.build);
+}
+
+GLuint ProgramCache::finish(Request &request) {
+	if (!request.build)
+		return request.program;
+
+	// Only the time spent blocked here counts, not what overlapped with it
+	auto start = std::chrono::steady_clock::now();
+	request.program = m_builder.wait(*request.build);
+	request.build.reset();
+	if (request.program != 0 && m_supported)
+		store(request.path, request.key, request.program);
+	m_stats.compileMs += MillisecondsSince(start);
+	return request.program;
+}
+
+GLuint ProgramCache::getProgram(const std::string &vertexShaderSrc,
+								const std::string &fragmentShaderSrc,
+								const std::vector<std::string> &defines) {
+	Request pending = request(vertexShaderSrc, fragmentShaderSrc, defines);
+	return finish(pending);
+}
+
+bool ProgramCache::load(const std::string &path, std::uint64_t key,
+						GLuint program) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+	std::error_code sizeError;
+	std::uintmax_t fileSize = std::filesystem::file_size(path, sizeError);
+
+	BinaryHeader header{};
+	std::vector<char> binary;
+	// NOLINTNEXTLINE
+	if (file.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+		// A truncated or corrupt entry mustn't make us allocate whatever its
+		// length says, the binary is all that follows the header
+		bool fits =
+			!sizeError && fileSize - sizeof(header) == header.length &&
+			header.length <= static_cast<std::uint64_t>(
+								 std::numeric_limits<GLsizei>::max());
+		if (header.magic == kMagic && header.key == key && fits) {
+			binary.resize(static_cast<std::size_t>(header.length));
+			file.read(binary.data(),
+					  static_cast<std::streamsize>(binary.size()));
+		}
+	}
+	file.close();
+
+	auto format = static_cast<GLenum>(header.format);
+	bool known = std::find(m_formats.begin(), m_formats.end(), format) !=
+				 m_formats.end();
+
+	GLint linked = 0;
+	if (!binary.empty() && file && known) {
+		// Not a GLCall, a binary the driver doesn't like is expected to fail
+		// here and just falls back to compiling
+		GLClearErrors();
+		glProgramBinary(program, format, binary.data(),
+						static_cast<GLsizei>(binary.size()));
+		bool failed = glGetError() != GL_NO_ERROR;
+		GLClearErrors();
+		t_glCallFailed = false;
+		if (!failed) {
+			GLCall(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+		}
+	}
+
+	if (linked == 0) {
+		// Stale or corrupt, make room for a fresh one
+		std::error_code error;
+		std::filesystem::remove(path, error);
+		m_stats.rejected++;
+		return false;
+	}
+	return true;
+}
+
+void ProgramCache::store(const std::string &path, std::uint64_t key,
+						 GLuint program) const {
+	GLint length = 0;
+	GLCall(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+	if (length <= 0)
+		return;
+
+	std::vector<char> binary(static_cast<size_t>(length));
+	GLenum format{};
+	GLCall(glGetProgramBinary(program, length, nullptr, &format,
+							  binary.data()));
+
+	BinaryHeader header{kMagic, static_cast<std::uint32_t>(format), key,
+						binary.size()};
+
+	// Write to a temporary file first so a crash never leaves half an entry
+	std::string tempPath = path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char *>(&header), // NOLINT
+				   sizeof(header));
+		file.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+		if (!file)
+			return;
+	}
+	std::error_code error;
+	std::filesystem::rename(tempPath, path, error);
+}
+
+void ProgramCache::printStats(std::ostream &out) const {
+	out << "[ProgramCache] " << m_stats.hits << " hits ("
+		<< m_stats.loadMs << " ms), " << m_stats.misses << " misses ("
+		<< m_stats.compileMs << " ms), " << m_stats.rejected << " rejected"
+		<< std::endl;
+}
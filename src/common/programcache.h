@@ -0,0 +1,80 @@
+#pragma once
+#include "programbuilder.h"
+
+#include <glbinding/gl/gl.h>
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Stores linked program binaries on disk so that later runs can skip compiling
+// and linking. Entries are keyed by a hash of the shader sources, the compile
+// defines and the driver's vendor/renderer/version strings, so a driver update
+// simply misses the cache. The driver can still reject a binary (e.g. after a
+// change it doesn't reflect in its version string), in which case the entry is
+// deleted and the program is compiled from source again. A relative directory
+// is relative to the working directory, like the res/ paths.
+//
+// Needs GL 4.1 or ARB_get_program_binary. Without any supported binary format
+// every request just compiles from source.
+//
+// Misses are compiled with a ProgramBuilder, so several programs can be
+// requested up front and finished later while the driver compiles them.
+class ProgramCache {
+  public:
+	struct Request {
+		std::string path;
+		std::uint64_t key = 0;
+		// Set right away on a cache hit
+		gl::GLuint program = 0;
+		std::optional<ProgramBuilder::BuildID> build;
+	};
+
+	struct Stats {
+		unsigned int hits = 0;
+		unsigned int misses = 0;
+		// Binaries that were found but rejected by the driver
+		unsigned int rejected = 0;
+		double loadMs = 0.0;
+		double compileMs = 0.0;
+	};
+
+  private:
+	std::string m_directory;
+	std::string m_driverID;
+	bool m_supported = false;
+	// What GL_PROGRAM_BINARY_FORMATS lists, anything else is never loaded
+	std::vector<gl::GLenum> m_formats;
+	Stats m_stats;
+	ProgramBuilder m_builder;
+
+	bool load(const std::string &path, std::uint64_t key, gl::GLuint program);
+	void store(const std::string &path, std::uint64_t key,
+			   gl::GLuint program) const;
+
+  public:
+	// Needs a current context
+	explicit ProgramCache(std::string directory);
+
+	// Loads the program from the cache, or starts compiling it
+	Request request(const std::string &vertexShaderSrc,
+					const std::string &fragmentShaderSrc,
+					const std::vector<std::string> &defines = {});
+	// Never blocks, true once finish() won't wait for the compiler (see
+	// ProgramBuilder::ready)
+	[[nodiscard]] bool ready(const Request &request) const;
+	// Waits for the program if it had to be compiled, and stores it. Returns
+	// a linked program, or 0 if it failed to compile.
+	gl::GLuint finish(Request &request);
+
+	// request() and finish() in one go
+	gl::GLuint getProgram(const std::string &vertexShaderSrc,
+						  const std::string &fragmentShaderSrc,
+						  const std::vector<std::string> &defines = {});
+
+	[[nodiscard]] inline const Stats &getStats() const {
+		return m_stats;
+	}
+	void printStats(std::ostream &out) const;
+};
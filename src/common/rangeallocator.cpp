@@ -0,0 +1,263 @@
+#include "rangeallocator.h"
+
+#include "pr_assert.h"
+
+#include <algorithm>
+
+namespace {
+
+constexpr unsigned int kSecondLevelBits = RangeAllocator::kSecondLevelBits;
+constexpr std::uint32_t kSmallSize = RangeAllocator::kSecondLevels;
+
+unsigned int HighestBit(std::uint32_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+	return 31U - static_cast<unsigned int>(__builtin_clz(value));
+#else
+	unsigned int bit = 0;
+	while (value >>= 1)
+		bit++;
+	return bit;
+#endif
+}
+
+unsigned int LowestBit(std::uint32_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+	return static_cast<unsigned int>(__builtin_ctz(value));
+#else
+	unsigned int bit = 0;
+	while (!(value & 1U)) {
+		value >>= 1;
+		bit++;
+	}
+	return bit;
+#endif
+}
+
+struct Index {
+	unsigned int first;
+	unsigned int second;
+};
+
+// The list a free block of this size goes into
+Index Mapping(std::uint32_t size) {
+	if (size < kSmallSize)
+		return {0, size};
+	unsigned int bit = HighestBit(size);
+	return {bit - kSecondLevelBits + 1,
+			(size >> (bit - kSecondLevelBits)) ^ kSmallSize};
+}
+
+// The first list whose blocks are all at least size big
+Index MappingAtLeast(std::uint32_t size) {
+	if (size >= kSmallSize) {
+		std::uint32_t round =
+			(1U << (HighestBit(size) - kSecondLevelBits)) - 1;
+		// Sizes this close to 2^32 land in the last list of the last level
+		size = size <= 0xffffffffU - round ? size + round : 0xffffffffU;
+	}
+	return Mapping(size);
+}
+
+} // namespace
+
+RangeAllocator::RangeAllocator(std::uint32_t capacity)
+	: m_capacity(capacity) {
+	for (std::array<Handle, kSecondLevels> &lists : m_freeLists)
+		lists.fill(kInvalid);
+	if (capacity == 0)
+		return;
+	m_first = newBlock();
+	m_blocks[m_first].size = capacity;
+	insertFree(m_first);
+}
+
+RangeAllocator::Handle RangeAllocator::newBlock() {
+	if (!m_unusedBlocks.empty()) {
+		Handle handle = m_unusedBlocks.back();
+		m_unusedBlocks.pop_back();
+		m_blocks[handle] = {};
+		return handle;
+	}
+	m_blocks.emplace_back();
+	return static_cast<Handle>(m_blocks.size() - 1);
+}
+
+void RangeAllocator::insertFree(Handle handle) {
+	Block &block = m_blocks[handle];
+	Index index = Mapping(block.size);
+	Handle &head = m_freeLists[index.first][index.second];
+	block.free = true;
+	block.previousFree = kInvalid;
+	block.nextFree = head;
+	if (head != kInvalid)
+		m_blocks[head].previousFree = handle;
+	head = handle;
+	m_firstLevelMap |= 1U << index.first;
+	m_secondLevelMaps[index.first] |= 1U << index.second;
+}
+
+void RangeAllocator::removeFree(Handle handle) {
+	Block &block = m_blocks[handle];
+	Index index = Mapping(block.size);
+	if (block.previousFree != kInvalid)
+		m_blocks[block.previousFree].nextFree = block.nextFree;
+	else
+		m_freeLists[index.first][index.second] = block.nextFree;
+	if (block.nextFree != kInvalid)
+		m_blocks[block.nextFree].previousFree = block.previousFree;
+
+	if (m_freeLists[index.first][index.second] == kInvalid) {
+		m_secondLevelMaps[index.first] &= ~(1U << index.second);
+		if (m_secondLevelMaps[index.first] == 0)
+			m_firstLevelMap &= ~(1U << index.first);
+	}
+	block.free = false;
+	block.previousFree = kInvalid;
+	block.nextFree = kInvalid;
+}
+
+RangeAllocator::Handle RangeAllocator::merge(Handle previous, Handle handle) {
+	Block &first = m_blocks[previous];
+	Block &second = m_blocks[handle];
+	first.size += second.size;
+	first.next = second.next;
+	if (second.next != kInvalid)
+		m_blocks[second.next].previous = previous;
+	m_unusedBlocks.push_back(handle);
+	return previous;
+}
+
+RangeAllocator::Handle RangeAllocator::allocate(std::uint32_t size) {
+	ASSERT(size > 0);
+	Index index = MappingAtLeast(size);
+	if (index.first >= kFirstLevels)
+		return kInvalid;
+
+	// A big enough list in the same first level, or else any list in a
+	// bigger one
+	std::uint32_t secondMap =
+		m_secondLevelMaps[index.first] & (~0U << index.second);
+	if (secondMap == 0) {
+		std::uint32_t firstMap = m_firstLevelMap & (~0U << (index.first + 1));
+		if (firstMap == 0)
+			return kInvalid;
+		index.first = LowestBit(firstMap);
+		secondMap = m_secondLevelMaps[index.first];
+	}
+	index.second = LowestBit(secondMap);
+	Handle handle = m_freeLists[index.first][index.second];
+	// Only sizes close to 2^32 can end up in a list that's too small
+	if (m_blocks[handle].size < size)
+		return kInvalid;
+	removeFree(handle);
+
+	// Give what's left back as a new free block right behind it
+	if (m_blocks[handle].size > size) {
+		Handle rest = newBlock();
+		// newBlock() may have grown m_blocks, so index again
+		Block &block = m_blocks[handle];
+		Block &remainder = m_blocks[rest];
+		remainder.offset = block.offset + size;
+		remainder.size = block.size - size;
+		remainder.previous = handle;
+		remainder.next = block.next;
+		if (block.next != kInvalid)
+			m_blocks[block.next].previous = rest;
+		block.next = rest;
+		block.size = size;
+		insertFree(rest);
+	}
+
+	m_used += size;
+	m_allocations++;
+	return handle;
+}
+
+void RangeAllocator::free(Handle handle) {
+	ASSERT(handle < m_blocks.size() && !m_blocks[handle].free);
+	m_used -= m_blocks[handle].size;
+	m_allocations--;
+
+	Handle next = m_blocks[handle].next;
+	if (next != kInvalid && m_blocks[next].free) {
+		removeFree(next);
+		handle = merge(handle, next);
+	}
+	Handle previous = m_blocks[handle].previous;
+	if (previous != kInvalid && m_blocks[previous].free) {
+		removeFree(previous);
+		handle = merge(previous, handle);
+	}
+	insertFree(handle);
+}
+
+std::vector<RangeAllocator::Move> RangeAllocator::defragment() {
+	std::vector<Move> moves;
+	if (m_first == kInvalid)
+		return moves;
+
+	std::vector<Handle> used;
+	used.reserve(m_allocations);
+	for (Handle handle = m_first; handle != kInvalid;
+		 handle = m_blocks[handle].next) {
+		if (m_blocks[handle].free) {
+			removeFree(handle);
+			m_unusedBlocks.push_back(handle);
+		} else {
+			used.push_back(handle);
+		}
+	}
+
+	std::uint32_t offset = 0;
+	Handle previous = kInvalid;
+	for (Handle current : used) {
+		Block &block = m_blocks[current];
+		if (block.offset != offset)
+			moves.push_back({current, block.offset, offset, block.size});
+		block.offset = offset;
+		block.previous = previous;
+		block.next = kInvalid;
+		if (previous != kInvalid)
+			m_blocks[previous].next = current;
+		offset += block.size;
+		previous = current;
+	}
+
+	if (offset < m_capacity) {
+		Handle rest = newBlock();
+		Block &remainder = m_blocks[rest];
+		remainder.offset = offset;
+		remainder.size = m_capacity - offset;
+		remainder.previous = previous;
+		if (previous != kInvalid)
+			m_blocks[previous].next = rest;
+		insertFree(rest);
+		if (previous == kInvalid)
+			m_first = rest;
+	}
+	if (!used.empty())
+		m_first = used.front();
+	return moves;
+}
+
+RangeAllocator::Stats RangeAllocator::getStats() const {
+	Stats stats;
+	stats.capacity = m_capacity;
+	stats.used = m_used;
+	stats.allocations = m_allocations;
+	for (const std::array<Handle, kSecondLevels> &lists : m_freeLists) {
+		for (Handle handle : lists) {
+			for (; handle != kInvalid; handle = m_blocks[handle].nextFree) {
+				stats.freeRanges++;
+				stats.largestFree =
+					std::max(stats.largestFree, m_blocks[handle].size);
+			}
+		}
+	}
+	std::uint32_t free = m_capacity - m_used;
+	if (free > 0) {
+		stats.fragmentation =
+			1.0 - static_cast<double>(stats.largestFree) / free;
+	}
+	return stats;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Hands out ranges of [0, capacity) with the two-level segregated fit (TLSF)
+// scheme from Masmano et al., "TLSF: a New Dynamic Memory Allocator for
+// Real-Time Systems". Free ranges are kept in lists by size class, a
+// power of two split into kSecondLevels steps, and two levels of bitmaps
+// say which lists aren't empty. Allocating and freeing take constant time,
+// and a freed range is merged with free neighbours right away.
+//
+// It only does the bookkeeping, the memory is somewhere else (e.g. a GL
+// buffer, see BufferArena). Sizes and offsets are in whatever unit the
+// caller likes, e.g. vertices.
+//
+// Allocations are referred to by handles that stay the same when
+// defragment() moves them.
+class RangeAllocator {
+  public:
+	using Handle = std::uint32_t;
+	static constexpr Handle kInvalid = 0xffffffffU;
+	static constexpr unsigned int kSecondLevelBits = 4;
+	static constexpr unsigned int kSecondLevels = 1U << kSecondLevelBits;
+	// Sizes up to 2^32, the first level holds everything below
+	// kSecondLevels
+	static constexpr unsigned int kFirstLevels = 32 - kSecondLevelBits + 1;
+
+	// A range defragment() moved, the data has to be copied by the caller
+	struct Move {
+		Handle handle;
+		std::uint32_t from;
+		std::uint32_t to;
+		std::uint32_t size;
+	};
+
+	struct Stats {
+		std::uint32_t capacity = 0;
+		std::uint32_t used = 0;
+		std::uint32_t largestFree = 0;
+		std::uint32_t allocations = 0;
+		std::uint32_t freeRanges = 0;
+		// 1 - largestFree / free: 0 when all the free space is in one piece
+		double fragmentation = 0.0;
+	};
+
+  private:
+	struct Block {
+		std::uint32_t offset = 0;
+		std::uint32_t size = 0;
+		// Neighbours in memory and in the free list, kInvalid if there's
+		// none
+		Handle previous = kInvalid;
+		Handle next = kInvalid;
+		Handle previousFree = kInvalid;
+		Handle nextFree = kInvalid;
+		bool free = false;
+	};
+
+	std::uint32_t m_capacity;
+	std::vector<Block> m_blocks;
+	// The block at offset 0
+	Handle m_first = kInvalid;
+	// Block slots that can be reused
+	std::vector<Handle> m_unusedBlocks;
+	std::uint32_t m_firstLevelMap = 0;
+	std::array<std::uint32_t, kFirstLevels> m_secondLevelMaps{};
+	std::array<std::array<Handle, kSecondLevels>, kFirstLevels> m_freeLists;
+	std::uint32_t m_used = 0;
+	std::uint32_t m_allocations = 0;
+
+	Handle newBlock();
+	void insertFree(Handle handle);
+	void removeFree(Handle handle);
+	// Merges the block into its previous neighbour, returns the survivor
+	Handle merge(Handle previous, Handle handle);
+
+  public:
+	explicit RangeAllocator(std::uint32_t capacity);
+
+	// kInvalid if there's no free range big enough. size has to be > 0.
+	[[nodiscard]] Handle allocate(std::uint32_t size);
+	void free(Handle handle);
+
+	// Packs every allocation towards the start, keeping their order, so the
+	// free space ends up in one range at the end. Returns the allocations
+	// that moved, in order.
+	std::vector<Move> defragment();
+
+	[[nodiscard]] inline std::uint32_t GetOffset(Handle handle) const {
+		return m_blocks[handle].offset;
+	};
+	[[nodiscard]] inline std::uint32_t GetSize(Handle handle) const {
+		return m_blocks[handle].size;
+	};
+	[[nodiscard]] inline std::uint32_t GetCapacity() const {
+		return m_capacity;
+	};
+	[[nodiscard]] Stats getStats() const;
+};
@@ -1,6 +1,10 @@
 #include "renderer.h"
 
+#include "benchmark.h"
+
+#include <atomic>
 #include <iostream>
+#include <string_view>
 
 void GLClearErrors() {
 	gl::GLenum error_code;
@@ -56,4 +60,361 @@ bool GLLogCall(const char *function, const char *file, int line) {
 	std::cerr << function << " " << file << ":" << line << std::endl;
 
 	return false;
-}
\ No newline at end of file
+}
+
+GLDebugMode GLDebugModeFromArgs(int argc, char **argv) {
+#ifndef NDEBUG
+	GLDebugMode mode = GLDebugMode::SYNCHRONOUS;
+#else
+	GLDebugMode mode = GLDebugMode::OFF;
+#endif
+	std::string_view value = GetArgString(argc, argv, "--gl-debug=", {});
+	if (value == "off")
+		mode = GLDebugMode::OFF;
+	else if (value == "async")
+		mode = GLDebugMode::ASYNC;
+	else if (value == "sync")
+		mode = GLDebugMode::SYNCHRONOUS;
+	return mode;
+}
+
+bool GLHasExtension(std::string_view name) {
+	gl::GLint count = 0;
+	gl::glGetIntegerv(gl::GL_NUM_EXTENSIONS, &count);
+	for (gl::GLint i = 0; i < count; i++) {
+		const auto *extension = reinterpret_cast<const char *>( // NOLINT
+			gl::glGetStringi(gl::GL_EXTENSIONS, static_cast<gl::GLuint>(i)));
+		if (name == extension)
+			return true;
+	}
+	return false;
+}
+
+static const char *GLDebugTypeName(gl::GLenum type) {
+	switch (type) {
+	case gl::GLenum::GL_DEBUG_TYPE_ERROR:
+		return "Error";
+	case gl::GLenum::GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+		return "Deprecated";
+	case gl::GLenum::GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+		return "Undefined behavior";
+	case gl::GLenum::GL_DEBUG_TYPE_PORTABILITY:
+		return "Portability";
+	case gl::GLenum::GL_DEBUG_TYPE_PERFORMANCE:
+		return "Performance";
+	default:
+		return "Other";
+	}
+}
+
+static void GL_APIENTRY GLDebugCallback(gl::GLenum /*source*/,
+										gl::GLenum type, gl::GLuint id,
+										gl::GLenum severity,
+										gl::GLsizei /*length*/,
+										const gl::GLchar *message,
+										const void *userParam) {
+	bool synchronous = userParam != nullptr;
+
+	std::cerr << "[GLDebug] " << GLDebugTypeName(type)
+			  << (severity == gl::GLenum::GL_DEBUG_SEVERITY_HIGH ? " (high)"
+																 : "")
+			  << " #" << id << ": " << message << std::endl;
+
+	// Only a synchronous callback runs on the thread that made the call
+	if (synchronous && t_glCallSite.function != nullptr) {
+		std::cerr << t_glCallSite.function << " " << t_glCallSite.file << ":"
+				  << t_glCallSite.line << std::endl;
+	}
+
+	if (synchronous && type == gl::GLenum::GL_DEBUG_TYPE_ERROR)
+		t_glCallFailed = true;
+}
+
+// Set by GLDebugInit for the contexts shared with its own
+static std::atomic<GLDebugMode> s_glDebugMode{GLDebugMode::OFF};
+
+bool GLDebugInit(GLDebugMode mode) {
+	s_glDebugMode = mode;
+	t_glPollErrors = true;
+	if (mode == GLDebugMode::OFF)
+		return false;
+
+	gl::GLint major = 0;
+	gl::GLint minor = 0;
+	gl::glGetIntegerv(gl::GL_MAJOR_VERSION, &major);
+	gl::glGetIntegerv(gl::GL_MINOR_VERSION, &minor);
+	bool supported = major > 4 || (major == 4 && minor >= 3) ||
+					 GLHasExtension("GL_KHR_debug");
+	if (!supported) {
+		std::cerr << "[GLDebug] KHR_debug isn't supported, falling back to "
+					 "glGetError"
+				  << std::endl;
+		return false;
+	}
+
+	bool synchronous = mode == GLDebugMode::SYNCHRONOUS;
+	gl::glEnable(gl::GL_DEBUG_OUTPUT);
+	if (synchronous)
+		gl::glEnable(gl::GL_DEBUG_OUTPUT_SYNCHRONOUS);
+	else
+		gl::glDisable(gl::GL_DEBUG_OUTPUT_SYNCHRONOUS);
+
+	// Notifications are mostly buffer placement chatter
+	gl::glDebugMessageControl(gl::GL_DONT_CARE, gl::GL_DONT_CARE,
+							  gl::GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr,
+							  gl::GL_FALSE);
+	// The user parameter only tells the callback which mode it's in
+	static const bool s_synchronousTag = true;
+	gl::glDebugMessageCallback(GLDebugCallback,
+							   synchronous ? &s_synchronousTag : nullptr);
+
+	// Anything raised before now would be blamed on the next GLCall
+	GLClearErrors();
+	t_glPollErrors = false;
+	return true;
+}
+
+bool GLDebugInitShared() {
+	return GLDebugInit(s_glDebugMode);
+}
+
+GLState &GLState::get() {
+	static thread_local GLState instance;
+	return instance;
+}
+
+void GLState::useProgram(gl::GLuint program) {
+	if (change(m_program, program)) {
+		GLCall(gl::glUseProgram(program));
+	}
+}
+
+void GLState::bindVertexArray(gl::GLuint vertexArray) {
+	if (change(m_vertexArray, vertexArray)) {
+		GLCall(gl::glBindVertexArray(vertexArray));
+	}
+}
+
+void GLState::bindBuffer(gl::GLenum target, gl::GLuint buffer) {
+	if (target == gl::GLenum::GL_ELEMENT_ARRAY_BUFFER) {
+		// Without knowing the VAO there's no telling what's bound to it
+		if (!m_vertexArray) {
+			m_frameStats.issued++;
+			GLCall(gl::glBindBuffer(target, buffer));
+			return;
+		}
+		auto it = m_elementBuffers.find(*m_vertexArray);
+		if (it != m_elementBuffers.end() && it->second == buffer) {
+			m_frameStats.elided++;
+			return;
+		}
+		m_elementBuffers[*m_vertexArray] = buffer;
+		m_frameStats.issued++;
+		GLCall(gl::glBindBuffer(target, buffer));
+		return;
+	}
+
+	for (size_t i = 0; i < kBufferTargets.size(); i++) {
+		if (kBufferTargets[i] == target) {
+			if (change(m_buffers[i], buffer)) {
+				GLCall(gl::glBindBuffer(target, buffer));
+			}
+			return;
+		}
+	}
+	m_frameStats.issued++;
+	GLCall(gl::glBindBuffer(target, buffer));
+}
+
+void GLState::bindBufferBase(gl::GLenum target, gl::GLuint index,
+							 gl::GLuint buffer) {
+	for (size_t i = 0; i < kBufferTargets.size(); i++) {
+		if (kBufferTargets[i] == target)
+			m_buffers[i] = buffer;
+	}
+	m_frameStats.issued++;
+	GLCall(gl::glBindBufferBase(target, index, buffer));
+}
+
+void GLState::bindFramebuffer(gl::GLuint framebuffer) {
+	if (change(m_framebuffer, framebuffer)) {
+		GLCall(gl::glBindFramebuffer(gl::GL_FRAMEBUFFER, framebuffer));
+	}
+}
+
+void GLState::activeTexture(unsigned int unit) {
+	if (change(m_activeTexture, unit)) {
+		GLCall(gl::glActiveTexture(static_cast<gl::GLenum>(
+			static_cast<unsigned int>(gl::GLenum::GL_TEXTURE0) + unit)));
+	}
+}
+
+void GLState::bindTexture(unsigned int unit, gl::GLenum target,
+						  gl::GLuint texture) {
+	ASSERT(unit < kTextureUnits);
+	for (size_t i = 0; i < kTextureTargets.size(); i++) {
+		if (kTextureTargets[i] == target) {
+			std::optional<gl::GLuint> &shadow = m_textures[unit][i];
+			if (shadow == texture) {
+				m_frameStats.elided++;
+				return;
+			}
+			activeTexture(unit);
+			shadow = texture;
+			m_frameStats.issued++;
+			GLCall(gl::glBindTexture(target, texture));
+			return;
+		}
+	}
+	activeTexture(unit);
+	m_frameStats.issued++;
+	GLCall(gl::glBindTexture(target, texture));
+}
+
+void GLState::setEnabled(std::optional<bool> &shadow, gl::GLenum capability,
+						 bool enabled) {
+	if (!change(shadow, enabled))
+		return;
+	if (enabled) {
+		GLCall(gl::glEnable(capability));
+	} else {
+		GLCall(gl::glDisable(capability));
+	}
+}
+
+void GLState::setBlend(bool enabled) {
+	setEnabled(m_blend, gl::GL_BLEND, enabled);
+}
+
+void GLState::setBlendFunc(gl::GLenum source, gl::GLenum destination) {
+	if (change(m_blendFunc, std::make_pair(source, destination))) {
+		GLCall(gl::glBlendFunc(source, destination));
+	}
+}
+
+void GLState::setDepthTest(bool enabled) {
+	setEnabled(m_depthTest, gl::GL_DEPTH_TEST, enabled);
+}
+
+void GLState::setDepthFunc(gl::GLenum func) {
+	if (change(m_depthFunc, func)) {
+		GLCall(gl::glDepthFunc(func));
+	}
+}
+
+void GLState::setDepthMask(bool enabled) {
+	if (change(m_depthMask, enabled)) {
+		GLCall(gl::glDepthMask(enabled ? gl::GL_TRUE : gl::GL_FALSE));
+	}
+}
+
+void GLState::setPrimitiveRestart(bool enabled, gl::GLuint index) {
+	if (!m_fixedRestartIndex) {
+		gl::GLint major = 0;
+		gl::GLint minor = 0;
+		GLCall(gl::glGetIntegerv(gl::GL_MAJOR_VERSION, &major));
+		GLCall(gl::glGetIntegerv(gl::GL_MINOR_VERSION, &minor));
+		m_fixedRestartIndex = major > 4 || (major == 4 && minor >= 3) ||
+							  GLHasExtension("GL_ARB_ES3_compatibility");
+	}
+
+	if (*m_fixedRestartIndex) {
+		// The index follows from the type of each draw
+		setEnabled(m_primitiveRestart, gl::GL_PRIMITIVE_RESTART_FIXED_INDEX,
+				   enabled);
+		return;
+	}
+	setEnabled(m_primitiveRestart, gl::GL_PRIMITIVE_RESTART, enabled);
+	if (enabled && change(m_restartIndex, index)) {
+		GLCall(gl::glPrimitiveRestartIndex(index));
+	}
+}
+
+void GLState::onProgramDeleted(gl::GLuint program) {
+	// The program stays in use until another one is, but its name may be
+	// handed out again after that
+	if (m_program == program)
+		m_program.reset();
+}
+
+void GLState::onVertexArrayDeleted(gl::GLuint vertexArray) {
+	m_elementBuffers.erase(vertexArray);
+	if (m_vertexArray == vertexArray)
+		m_vertexArray = 0;
+}
+
+void GLState::onBufferDeleted(gl::GLuint buffer) {
+	// Deleting a buffer unbinds it from the context, and from the current VAO
+	// only. Other VAOs keep referring to it.
+	for (std::optional<gl::GLuint> &shadow : m_buffers) {
+		if (shadow == buffer)
+			shadow = 0;
+	}
+	for (auto it = m_elementBuffers.begin(); it != m_elementBuffers.end();) {
+		if (it->second == buffer && m_vertexArray == it->first)
+			(it++)->second = 0;
+		else if (it->second == buffer)
+			it = m_elementBuffers.erase(it);
+		else
+			++it;
+	}
+}
+
+void GLState::onFramebufferDeleted(gl::GLuint framebuffer) {
+	if (m_framebuffer == framebuffer)
+		m_framebuffer = 0;
+}
+
+void GLState::onTextureDeleted(gl::GLuint texture) {
+	for (auto &unit : m_textures) {
+		for (std::optional<gl::GLuint> &shadow : unit) {
+			if (shadow == texture)
+				shadow = 0;
+		}
+	}
+}
+
+void GLState::onElementBufferSet(gl::GLuint vertexArray, gl::GLuint buffer) {
+	m_elementBuffers[vertexArray] = buffer;
+}
+
+bool GLState::hasDirectStateAccess() {
+	if (!m_directStateAccess) {
+		gl::GLint major = 0;
+		gl::GLint minor = 0;
+		GLCall(gl::glGetIntegerv(gl::GL_MAJOR_VERSION, &major));
+		GLCall(gl::glGetIntegerv(gl::GL_MINOR_VERSION, &minor));
+		m_directStateAccess = major > 4 || (major == 4 && minor >= 5) ||
+							  GLHasExtension("GL_ARB_direct_state_access");
+	}
+	return m_directStateAccessAllowed && *m_directStateAccess;
+}
+
+void GLState::setDirectStateAccess(bool allowed) {
+	m_directStateAccessAllowed = allowed;
+}
+
+void GLState::invalidate() {
+	m_program.reset();
+	m_vertexArray.reset();
+	m_framebuffer.reset();
+	m_buffers.fill(std::nullopt);
+	m_elementBuffers.clear();
+	m_activeTexture.reset();
+	for (auto &unit : m_textures)
+		unit.fill(std::nullopt);
+	m_blend.reset();
+	m_blendFunc.reset();
+	m_depthTest.reset();
+	m_depthFunc.reset();
+	m_depthMask.reset();
+	m_primitiveRestart.reset();
+	m_restartIndex.reset();
+}
+
+void GLState::endFrame() {
+	m_totalStats.issued += m_frameStats.issued;
+	m_totalStats.elided += m_frameStats.elided;
+	m_lastFrameStats = m_frameStats;
+	m_frameStats = {};
+}
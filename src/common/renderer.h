@@ -1,23 +1,86 @@
 #pragma once
 
-#include "debugbreak.h"
+#include "pr_assert.h"
+#include <array>
 #include <glbinding/gl/gl.h>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
 
+// How GL errors get caught in debug builds:
+//  - OFF: every GLCall clears and polls glGetError around the call. That's two
+//    or more round trips to the driver per call, but works on any context.
+//  - ASYNC: errors are reported through a KHR_debug callback, which the driver
+//    may call later from another thread, so the call site isn't known.
+//  - SYNCHRONOUS: the callback is invoked from inside the failing GL call,
+//    which lets it be traced back to the GLCall that caused it.
+// Neither callback mode calls glGetError in GLCall.
+enum class GLDebugMode { OFF, ASYNC, SYNCHRONOUS };
 
-#define ASSERT(x)                                                              \
-	if (!(x))                                                                  \
-	debug_break()
+struct GLCallSite {
+	const char *function = nullptr;
+	const char *file = nullptr;
+	int line = 0;
+};
+
+// The last GLCall made on this thread, and whether the synchronous debug
+// callback reported an error for it
+inline thread_local GLCallSite t_glCallSite;
+inline thread_local bool t_glCallFailed = false;
+// Whether GLCall has to poll glGetError on this thread, false once a debug
+// callback is active for the context current on it
+inline thread_local bool t_glPollErrors = true;
+
+void GLClearErrors();
+
+void GLPrintError(gl::GLenum error_code);
+
+void GLCheckErrors();
+
+bool GLLogCall(const char *function, const char *file, int line);
+
+// Needs a current context
+bool GLHasExtension(std::string_view name);
+
+inline void GLBeginCall(const char *function, const char *file, int line) {
+	t_glCallSite = {function, file, line};
+	if (t_glPollErrors)
+		GLClearErrors();
+}
+
+inline bool GLEndCall() {
+	if (t_glPollErrors)
+		return GLLogCall(t_glCallSite.function, t_glCallSite.file,
+						 t_glCallSite.line);
+	bool failed = t_glCallFailed;
+	t_glCallFailed = false;
+	return !failed;
+}
+
+// Parses --gl-debug=off|async|sync. Defaults to SYNCHRONOUS in debug builds and
+// OFF otherwise.
+GLDebugMode GLDebugModeFromArgs(int argc, char **argv);
+
+// Needs a current context, which should be created with the debug context hint
+// to get any messages on most drivers. Falls back to OFF and returns false if
+// neither GL 4.3 nor KHR_debug is available.
+bool GLDebugInit(GLDebugMode mode);
+
+// Debug state is per context, so a shared context made current on a worker
+// thread starts out without a callback. This sets it up in the mode the last
+// GLDebugInit call used, or leaves the thread polling glGetError.
+bool GLDebugInitShared();
 
 #ifndef NDEBUG
 #define GLCall(x)                                                              \
-	GLClearErrors();                                                           \
+	GLBeginCall(#x, __FILE__, __LINE__);                                       \
 	x;                                                                         \
-	ASSERT(GLLogCall(#x, __FILE__, __LINE__))
+	ASSERT(GLEndCall())
 #define GLCallV(x)                                                             \
 	[&]() {                                                                    \
-		GLClearErrors();                                                       \
+		GLBeginCall(#x, __FILE__, __LINE__);                                   \
 		auto retVal = x;                                                       \
-		ASSERT(GLLogCall(#x, __FILE__, __LINE__));                             \
+		ASSERT(GLEndCall());                                                   \
 		return retVal;                                                         \
 	}()
 #else
@@ -25,10 +88,148 @@
 #define GLCall(x) x
 #endif
 
-void GLClearErrors();
+// Shadows the binding and fixed-function state of the context current on
+// this thread, so binding what's already bound doesn't call into the driver.
+// The cache only knows about changes made through it: code that binds things
+// with raw GL calls has to call invalidate() afterwards.
+//
+// The element array buffer binding is part of the VAO, so it's remembered per
+// VAO. Deleting an object through the wrappers has to be reported with the
+// on*Deleted functions since GL unbinds it and may reuse its name.
+class GLState {
+  public:
+	struct Stats {
+		unsigned long issued = 0;
+		unsigned long elided = 0;
+	};
 
-void GLPrintError(gl::GLenum error_code);
+	static constexpr unsigned int kTextureUnits = 32;
 
-void GLCheckErrors();
+  private:
+	// Targets that aren't in this list are passed straight through
+	static constexpr std::array<gl::GLenum, 11> kBufferTargets{
+		gl::GLenum::GL_ARRAY_BUFFER,
+		gl::GLenum::GL_COPY_READ_BUFFER,
+		gl::GLenum::GL_COPY_WRITE_BUFFER,
+		gl::GLenum::GL_DRAW_INDIRECT_BUFFER,
+		gl::GLenum::GL_DISPATCH_INDIRECT_BUFFER,
+		gl::GLenum::GL_PIXEL_PACK_BUFFER,
+		gl::GLenum::GL_PIXEL_UNPACK_BUFFER,
+		gl::GLenum::GL_SHADER_STORAGE_BUFFER,
+		gl::GLenum::GL_TEXTURE_BUFFER,
+		gl::GLenum::GL_UNIFORM_BUFFER,
+		gl::GLenum::GL_ATOMIC_COUNTER_BUFFER};
+	static constexpr std::array<gl::GLenum, 5> kTextureTargets{
+		gl::GLenum::GL_TEXTURE_1D, gl::GLenum::GL_TEXTURE_2D,
+		gl::GLenum::GL_TEXTURE_3D, gl::GLenum::GL_TEXTURE_2D_ARRAY,
+		gl::GLenum::GL_TEXTURE_CUBE_MAP};
+
+	// Empty means the state isn't known, and the next change is always issued
+	std::optional<gl::GLuint> m_program;
+	std::optional<gl::GLuint> m_vertexArray;
+	std::optional<gl::GLuint> m_framebuffer;
+	std::array<std::optional<gl::GLuint>, kBufferTargets.size()> m_buffers;
+	// Element array buffer bound to each VAO we've bound it for
+	std::unordered_map<gl::GLuint, gl::GLuint> m_elementBuffers;
+	std::optional<gl::GLuint> m_activeTexture;
+	std::array<std::array<std::optional<gl::GLuint>, kTextureTargets.size()>,
+			   kTextureUnits>
+		m_textures;
+	std::optional<bool> m_blend;
+	std::optional<std::pair<gl::GLenum, gl::GLenum>> m_blendFunc;
+	std::optional<bool> m_depthTest;
+	std::optional<gl::GLenum> m_depthFunc;
+	std::optional<bool> m_depthMask;
+	std::optional<bool> m_primitiveRestart;
+	std::optional<gl::GLuint> m_restartIndex;
+	// Whether GL_PRIMITIVE_RESTART_FIXED_INDEX is there, checked on first use
+	std::optional<bool> m_fixedRestartIndex;
+	// Whether direct state access is there, checked on first use
+	std::optional<bool> m_directStateAccess;
+	bool m_directStateAccessAllowed = true;
+
+	Stats m_frameStats;
+	Stats m_lastFrameStats;
+	Stats m_totalStats;
+
+	GLState() = default;
+
+	// Returns true if the call has to be made
+	template <typename T> bool change(std::optional<T> &shadow, T value) {
+		if (shadow == value) {
+			m_frameStats.elided++;
+			return false;
+		}
+		shadow = value;
+		m_frameStats.issued++;
+		return true;
+	}
+	void setEnabled(std::optional<bool> &shadow, gl::GLenum capability,
+					bool enabled);
+	void activeTexture(unsigned int unit);
+
+  public:
+	// One per thread, since a context is only ever current on one thread
+	static GLState &get();
+
+	void useProgram(gl::GLuint program);
+	void bindVertexArray(gl::GLuint vertexArray);
+	void bindBuffer(gl::GLenum target, gl::GLuint buffer);
+	// Binds buffer to an indexed binding point of target (shader storage,
+	// uniform or atomic counter buffers). The indexed bindings aren't
+	// tracked, but this binds the generic target too, which is.
+	void bindBufferBase(gl::GLenum target, gl::GLuint index,
+						gl::GLuint buffer);
+	// GL_FRAMEBUFFER, both the draw and read bindings
+	void bindFramebuffer(gl::GLuint framebuffer);
+	void bindTexture(unsigned int unit, gl::GLenum target, gl::GLuint texture);
+
+	void setBlend(bool enabled);
+	void setBlendFunc(gl::GLenum source, gl::GLenum destination);
+	void setDepthTest(bool enabled);
+	void setDepthFunc(gl::GLenum func);
+	void setDepthMask(bool enabled);
+	// index has to be the largest value of the index type drawn with, see
+	// IndexBuffer::GetRestartIndex(). That's all GL 4.3 and ES 3 support,
+	// older contexts fall back to glPrimitiveRestartIndex.
+	void setPrimitiveRestart(bool enabled, gl::GLuint index);
+
+	void onProgramDeleted(gl::GLuint program);
+	void onVertexArrayDeleted(gl::GLuint vertexArray);
+	void onBufferDeleted(gl::GLuint buffer);
+	void onFramebufferDeleted(gl::GLuint framebuffer);
+	void onTextureDeleted(gl::GLuint texture);
+	// glVertexArrayElementBuffer changes a VAO's element array buffer
+	// without binding either
+	void onElementBufferSet(gl::GLuint vertexArray, gl::GLuint buffer);
+
+	// Whether the wrappers create and fill buffers and VAOs with GL 4.5 (or
+	// ARB_direct_state_access) calls that take the object's name, instead of
+	// binding it first. Binding to edit disturbs what's bound for drawing,
+	// and every bind is validated by the driver. Code that mixes the
+	// wrappers with raw GL can't count on them leaving anything bound, e.g.
+	// a new VertexBuffer, and has to bind them itself.
+	[[nodiscard]] bool hasDirectStateAccess();
+	// Falls back to binding even where DSA is there, e.g. to compare the two.
+	// Objects keep working with the path they were created with.
+	void setDirectStateAccess(bool allowed);
+
+	// Forgets everything, e.g. after making a different context current
+	void invalidate();
+
+	// Call once per frame, after swapping the buffers
+	void endFrame();
+	[[nodiscard]] inline const Stats &getLastFrameStats() const {
+		return m_lastFrameStats;
+	}
+	[[nodiscard]] inline const Stats &getTotalStats() const {
+		return m_totalStats;
+	}
+
+	GLState(const GLState &other) = delete;
+	GLState(const GLState &&other) = delete;
+	GLState &operator=(const GLState &other) = delete;
+	GLState &operator=(const GLState &&other) = delete;
 
-bool GLLogCall(const char *function, const char *file, int line);
\ No newline at end of file
+	~GLState() = default;
+};
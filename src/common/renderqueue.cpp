@@ -0,0 +1,133 @@
+#include "renderqueue.h"
+
+#include "indexbuffer.h"
+#include "renderer.h"
+
+#include <algorithm>
+#include <chrono>
+
+using namespace gl;
+
+namespace {
+
+std::uint64_t StateBits(GLuint name) {
+	return name & ((1ULL << SortKey::kStateBits) - 1);
+}
+
+} // namespace
+
+std::uint64_t SortKey::Make(unsigned int layer, bool translucent,
+							GLuint program, GLuint vertexArray, GLuint texture,
+							float depth) {
+	constexpr std::uint64_t kDepthMax = (1ULL << kDepthBits) - 1;
+	auto quantized = static_cast<std::uint64_t>(
+		std::clamp(depth, 0.0f, 1.0f) * static_cast<float>(kDepthMax));
+	std::uint64_t key = static_cast<std::uint64_t>(
+							layer & ((1U << kLayerBits) - 1))
+						<< kLayerShift;
+	std::uint64_t state = StateBits(program) << (kStateBits * 2) |
+						  StateBits(vertexArray) << kStateBits |
+						  StateBits(texture);
+	if (translucent) {
+		// Far ones first
+		key |= 1ULL << kTranslucentShift;
+		key |= (kDepthMax - quantized) << (kStateBits * 3);
+		key |= state;
+	} else {
+		key |= state << kDepthBits;
+		key |= quantized;
+	}
+	return key;
+}
+
+void RadixSort(std::vector<SortEntry> &entries,
+			   std::vector<SortEntry> &scratch) {
+	scratch.resize(entries.size());
+	for (unsigned int shift = 0; shift < 64; shift += 8) {
+		std::array<std::size_t, 256> counts{};
+		for (const SortEntry &entry : entries)
+			counts[(entry.key >> shift) & 0xff]++;
+		// Every key has the same byte here, this pass wouldn't move anything
+		if (std::find(counts.begin(), counts.end(), entries.size()) !=
+			counts.end())
+			continue;
+
+		std::size_t offset = 0;
+		for (std::size_t &count : counts) {
+			std::size_t bucket = count;
+			count = offset;
+			offset += bucket;
+		}
+		for (const SortEntry &entry : entries)
+			scratch[counts[(entry.key >> shift) & 0xff]++] = entry;
+		entries.swap(scratch);
+	}
+}
+
+RenderQueue::RenderQueue(UniformName uniform) : m_uniform(uniform) {}
+
+void RenderQueue::submit(const DrawPacket &packet) {
+	m_order.push_back(
+		{packet.key, static_cast<std::uint32_t>(m_packets.size())});
+	m_packets.push_back(packet);
+}
+
+RenderQueue::StateChanges RenderQueue::countStateChanges() const {
+	StateChanges changes;
+	const DrawPacket *previous = nullptr;
+	for (const SortEntry &entry : m_order) {
+		const DrawPacket &packet = m_packets[entry.index];
+		if (!previous || previous->shader != packet.shader)
+			changes.programs++;
+		if (!previous || previous->vertexArray != packet.vertexArray)
+			changes.vertexArrays++;
+		if (!previous || previous->texture != packet.texture)
+			changes.textures++;
+		previous = &packet;
+	}
+	return changes;
+}
+
+void RenderQueue::flush(bool sort) {
+	StateChanges unsorted = countStateChanges();
+	if (sort) {
+		auto start = std::chrono::steady_clock::now();
+		RadixSort(m_order, m_scratch);
+		std::chrono::duration<double, std::milli> elapsed =
+			std::chrono::steady_clock::now() - start;
+		m_stats.sortMs += elapsed.count();
+	}
+	StateChanges sorted = countStateChanges();
+
+	GLState &state = GLState::get();
+	for (const SortEntry &entry : m_order) {
+		const DrawPacket &packet = m_packets[entry.index];
+		// Binding what's already bound is elided by the state cache
+		packet.shader->bind();
+		state.bindVertexArray(packet.vertexArray);
+		if (packet.texture != 0)
+			state.bindTexture(0, GL_TEXTURE_2D, packet.texture);
+		packet.shader->setUniform(m_uniform, packet.uniform[0],
+								  packet.uniform[1], packet.uniform[2],
+								  packet.uniform[3]);
+		state.setPrimitiveRestart(packet.primitiveRestart,
+								  GetIndexTypeRestartIndex(packet.indexType));
+		// The offset into the index buffer is passed as a pointer
+		const void *offset = reinterpret_cast<const void *>( // NOLINT
+			packet.firstIndex * GetIndexTypeSize(packet.indexType));
+		GLCall(glDrawElementsBaseVertex(
+			GL_TRIANGLES, static_cast<GLsizei>(packet.indexCount),
+			packet.indexType, offset, packet.baseVertex));
+	}
+
+	m_stats.draws += m_packets.size();
+	m_stats.unsorted.programs += unsorted.programs;
+	m_stats.unsorted.vertexArrays += unsorted.vertexArrays;
+	m_stats.unsorted.textures += unsorted.textures;
+	m_stats.sorted.programs += sorted.programs;
+	m_stats.sorted.vertexArrays += sorted.vertexArrays;
+	m_stats.sorted.textures += sorted.textures;
+
+	m_packets.clear();
+	m_order.clear();
+}
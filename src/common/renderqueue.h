@@ -0,0 +1,115 @@
+#pragma once
+#include <glbinding/gl/gl.h>
+
+#include "shader.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Sort key bits, from the most significant down. Opaque draws are grouped by
+// program, then VAO, then texture, and drawn front to back within a group.
+// Translucent ones come after the opaque ones of their layer, back to front,
+// with the state only breaking ties.
+//
+//   opaque:      layer:4 | 0 | program:12 | vao:12 | texture:12 | depth:23
+//   translucent: layer:4 | 1 | ~depth:23 | program:12 | vao:12 | texture:12
+namespace SortKey {
+constexpr unsigned int kLayerBits = 4;
+constexpr unsigned int kStateBits = 12;
+constexpr unsigned int kDepthBits = 23;
+constexpr unsigned int kLayerShift = 60;
+constexpr unsigned int kTranslucentShift = 59;
+
+// The state ids are GL names, only their lowest kStateBits are used. Names
+// that share them just sort less well. depth is clamped to [0, 1].
+std::uint64_t Make(unsigned int layer, bool translucent, gl::GLuint program,
+				   gl::GLuint vertexArray, gl::GLuint texture, float depth);
+} // namespace SortKey
+
+// Everything needed to issue one draw, small and trivially copyable so that
+// packets can be recorded in bulk and shuffled around cheaply
+struct DrawPacket {
+	std::uint64_t key;
+	Shader *shader;
+	gl::GLuint vertexArray;
+	// Bound to GL_TEXTURE_2D on unit 0, 0 leaves the unit alone
+	gl::GLuint texture;
+	gl::GLenum indexType;
+	std::uint32_t indexCount;
+	std::uint32_t firstIndex;
+	std::int32_t baseVertex;
+	// Set to the queue's per-draw uniform
+	std::array<float, 4> uniform;
+	// Whether the largest value of indexType restarts the primitive, see
+	// IndexBuffer::HasPrimitiveRestart()
+	bool primitiveRestart = false;
+};
+
+struct SortEntry {
+	std::uint64_t key;
+	std::uint32_t index;
+};
+
+// Stable LSD radix sort on the keys, a byte per pass. Passes where every key
+// has the same byte are skipped. scratch is resized as needed.
+void RadixSort(std::vector<SortEntry> &entries,
+			   std::vector<SortEntry> &scratch);
+
+// Collects a frame's draws and issues them sorted by key, so that draws
+// sharing a program, VAO and texture end up next to each other and the binds
+// between them are elided by the GLState cache.
+//
+// Usage:
+//   RenderQueue queue("u_Transform");
+//   queue.submit({SortKey::Make(...), &shader, vao, texture, ...});
+//   ...
+//   queue.flush();
+class RenderQueue {
+  public:
+	// Switches that executing the packets in a given order needs
+	struct StateChanges {
+		unsigned long programs = 0;
+		unsigned long vertexArrays = 0;
+		unsigned long textures = 0;
+	};
+
+	struct Stats {
+		unsigned long draws = 0;
+		// In the order the draws were submitted
+		StateChanges unsorted;
+		// In the order they were executed
+		StateChanges sorted;
+		double sortMs = 0.0;
+	};
+
+  private:
+	UniformName m_uniform;
+	std::vector<DrawPacket> m_packets;
+	std::vector<SortEntry> m_order;
+	std::vector<SortEntry> m_scratch;
+	Stats m_stats;
+
+	StateChanges countStateChanges() const;
+
+  public:
+	// uniform is the vec4 each packet's uniform value is written to
+	explicit RenderQueue(UniformName uniform);
+
+	void submit(const DrawPacket &packet);
+
+	// Sorts the packets if sort is set, issues them and empties the queue.
+	// The statistics are added to getStats().
+	void flush(bool sort = true);
+
+	[[nodiscard]] inline std::size_t GetCount() const {
+		return m_packets.size();
+	};
+	[[nodiscard]] inline const Stats &getStats() const {
+		return m_stats;
+	}
+	inline void resetStats() {
+		m_stats = {};
+	}
+};
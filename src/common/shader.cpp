@@ -0,0 +1,292 @@
+#include "shader.h"
+
+#include "renderer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+using namespace gl;
+
+namespace {
+
+// Size in bytes of a single element of a uniform type
+std::uint32_t UniformTypeSize(GLenum type) {
+	switch (type) {
+	case GLenum::GL_FLOAT_VEC2:
+	case GLenum::GL_INT_VEC2:
+	case GLenum::GL_UNSIGNED_INT_VEC2:
+	case GLenum::GL_BOOL_VEC2:
+		return 8;
+	case GLenum::GL_FLOAT_VEC3:
+	case GLenum::GL_INT_VEC3:
+	case GLenum::GL_UNSIGNED_INT_VEC3:
+	case GLenum::GL_BOOL_VEC3:
+		return 12;
+	case GLenum::GL_FLOAT_VEC4:
+	case GLenum::GL_INT_VEC4:
+	case GLenum::GL_UNSIGNED_INT_VEC4:
+	case GLenum::GL_BOOL_VEC4:
+	case GLenum::GL_FLOAT_MAT2:
+		return 16;
+	case GLenum::GL_FLOAT_MAT3:
+		return 36;
+	case GLenum::GL_FLOAT_MAT4:
+		return 64;
+	case GLenum::GL_DOUBLE:
+		return 8;
+	case GLenum::GL_FLOAT:
+	case GLenum::GL_INT:
+	case GLenum::GL_UNSIGNED_INT:
+	case GLenum::GL_BOOL:
+		return 4;
+	default:
+		// Samplers and images are ints, the remaining types don't have a
+		// setter, a mat4 worth of space is plenty
+		return 64;
+	}
+}
+
+} // namespace
+
+Shader::Shader(unsigned int program) : m_rendererID(program) {
+	reflect();
+}
+
+Shader::Shader(Shader &&other) {
+	this->m_rendererID = other.m_rendererID;
+	this->m_lookup = std::move(other.m_lookup);
+	this->m_uniforms = std::move(other.m_uniforms);
+	this->m_values = std::move(other.m_values);
+	this->m_stats = other.m_stats;
+	other.moved = true;
+}
+
+Shader &Shader::operator=(Shader &&other) {
+	if (this == &other) {
+		return *this;
+	}
+
+	// Free existing resources being held by this object
+	release();
+
+	this->m_rendererID = other.m_rendererID;
+	this->m_lookup = std::move(other.m_lookup);
+	this->m_uniforms = std::move(other.m_uniforms);
+	this->m_values = std::move(other.m_values);
+	this->m_stats = other.m_stats;
+	this->moved = false;
+	other.moved = true;
+
+	return *this;
+}
+
+Shader::~Shader() {
+	release();
+}
+
+void Shader::release() {
+	if (!moved) {
+		GLState::get().onProgramDeleted(m_rendererID);
+		GLCall(glDeleteProgram(m_rendererID));
+	}
+}
+
+void Shader::reload(unsigned int program) {
+	if (program == m_rendererID)
+		return;
+	release();
+	m_rendererID = program;
+	moved = false;
+	reflect();
+}
+
+void Shader::reflect() {
+	m_lookup.clear();
+	m_uniforms.clear();
+	m_values.clear();
+	if (m_rendererID == 0)
+		return;
+
+	GLint count = 0;
+	GLint maxLength = 0;
+	GLCall(glGetProgramiv(m_rendererID, GL_ACTIVE_UNIFORMS, &count));
+	GLCall(glGetProgramiv(m_rendererID, GL_ACTIVE_UNIFORM_MAX_LENGTH,
+						  &maxLength));
+
+	std::string name(static_cast<size_t>(std::max(maxLength, 1)), '\0');
+	for (GLint i = 0; i < count; i++) {
+		GLsizei length = 0;
+		GLint arraySize = 0;
+		GLenum type{};
+		GLCall(glGetActiveUniform(m_rendererID, static_cast<GLuint>(i),
+								  maxLength, &length, &arraySize, &type,
+								  name.data()));
+		std::string_view uniformName(name.data(),
+									 static_cast<size_t>(length));
+
+		// Members of uniform blocks don't have a location
+		std::string nameString(uniformName);
+		GLint location =
+			GLCallV(glGetUniformLocation(m_rendererID, nameString.c_str()));
+		if (location == -1)
+			continue;
+
+		std::uint32_t size = UniformTypeSize(type) *
+							 static_cast<std::uint32_t>(std::max(arraySize, 1));
+		auto index = static_cast<std::uint32_t>(m_uniforms.size());
+		m_uniforms.push_back({location, type,
+							  static_cast<std::uint32_t>(m_values.size()), size,
+							  false});
+		m_values.resize(m_values.size() + size);
+
+		m_lookup.emplace_back(UniformName::hash(uniformName), index);
+		// Arrays are reported as "name[0]", allow "name" as well
+		if (uniformName.size() > 3 &&
+			uniformName.substr(uniformName.size() - 3) == "[0]")
+			m_lookup.emplace_back(
+				UniformName::hash(
+					uniformName.substr(0, uniformName.size() - 3)),
+				index);
+	}
+
+	std::sort(m_lookup.begin(), m_lookup.end());
+}
+
+Shader::Uniform *Shader::find(UniformName name) {
+	auto it = std::lower_bound(
+		m_lookup.begin(), m_lookup.end(), name.getHash(),
+		[](const auto &entry, std::uint64_t hash) {
+			return entry.first < hash;
+		});
+	if (it == m_lookup.end() || it->first != name.getHash()) {
+		m_stats.missing++;
+		return nullptr;
+	}
+	return &m_uniforms[it->second];
+}
+
+GLint Shader::getUniformLocation(UniformName name) {
+	Uniform *uniform = find(name);
+	return uniform ? uniform->location : -1;
+}
+
+bool Shader::update(Uniform &uniform, const void *value, size_t size) {
+	// Never write past the uniform's slot, a mismatched type is the caller's
+	// bug and the driver will complain about it
+	size = std::min<size_t>(size, uniform.size);
+	unsigned char *cached = m_values.data() + uniform.offset;
+	if (uniform.uploaded && std::memcmp(cached, value, size) == 0) {
+		m_stats.skipped++;
+		return false;
+	}
+	std::memcpy(cached, value, size);
+	uniform.uploaded = true;
+	m_stats.issued++;
+	return true;
+}
+
+void Shader::bind() const {
+	GLState::get().useProgram(m_rendererID);
+}
+
+void Shader::unbind() const {
+	GLState::get().useProgram(0);
+}
+
+void Shader::setUniform(UniformName name, float x) {
+	Uniform *uniform = find(name);
+	if (uniform && update(*uniform, &x, sizeof(x))) {
+		GLCall(glUniform1f(uniform->location, x));
+	}
+}
+
+void Shader::setUniform(UniformName name, float x, float y) {
+	Uniform *uniform = find(name);
+	std::array<float, 2> value{x, y};
+	if (uniform && update(*uniform, value.data(), sizeof(value))) {
+		GLCall(glUniform2f(uniform->location, x, y));
+	}
+}
+
+void Shader::setUniform(UniformName name, float x, float y, float z) {
+	Uniform *uniform = find(name);
+	std::array<float, 3> value{x, y, z};
+	if (uniform && update(*uniform, value.data(), sizeof(value))) {
+		GLCall(glUniform3f(uniform->location, x, y, z));
+	}
+}
+
+void Shader::setUniform(UniformName name, float x, float y, float z,
+						float w) {
+	Uniform *uniform = find(name);
+	std::array<float, 4> value{x, y, z, w};
+	if (uniform && update(*uniform, value.data(), sizeof(value))) {
+		GLCall(glUniform4f(uniform->location, x, y, z, w));
+	}
+}
+
+void Shader::setUniform(UniformName name, int x) {
+	Uniform *uniform = find(name);
+	if (uniform && update(*uniform, &x, sizeof(x))) {
+		GLCall(glUniform1i(uniform->location, x));
+	}
+}
+
+void Shader::setUniform(UniformName name, int x, int y) {
+	Uniform *uniform = find(name);
+	std::array<int, 2> value{x, y};
+	if (uniform && update(*uniform, value.data(), sizeof(value))) {
+		GLCall(glUniform2i(uniform->location, x, y));
+	}
+}
+
+void Shader::setUniform(UniformName name, int x, int y, int z, int w) {
+	Uniform *uniform = find(name);
+	std::array<int, 4> value{x, y, z, w};
+	if (uniform && update(*uniform, value.data(), sizeof(value))) {
+		GLCall(glUniform4i(uniform->location, x, y, z, w));
+	}
+}
+
+void Shader::setUniform(UniformName name, unsigned int x) {
+	Uniform *uniform = find(name);
+	if (uniform && update(*uniform, &x, sizeof(x))) {
+		GLCall(glUniform1ui(uniform->location, x));
+	}
+}
+
+void Shader::setUniform(UniformName name, const int *values,
+						std::size_t count) {
+	Uniform *uniform = find(name);
+	if (uniform && update(*uniform, values, count * sizeof(int))) {
+		GLCall(glUniform1iv(uniform->location, static_cast<GLsizei>(count),
+							values));
+	}
+}
+
+void Shader::setUniform(UniformName name, const std::array<float, 4> *values,
+						std::size_t count) {
+	Uniform *uniform = find(name);
+	if (uniform && update(*uniform, values, count * sizeof(*values))) {
+		GLCall(glUniform4fv(uniform->location, static_cast<GLsizei>(count),
+							values->data()));
+	}
+}
+
+void Shader::setUniform(UniformName name, const std::array<float, 9> &matrix) {
+	Uniform *uniform = find(name);
+	if (uniform && update(*uniform, matrix.data(), sizeof(matrix))) {
+		GLCall(glUniformMatrix3fv(uniform->location, 1, GL_FALSE,
+								  matrix.data()));
+	}
+}
+
+void Shader::setUniform(UniformName name,
+						const std::array<float, 16> &matrix) {
+	Uniform *uniform = find(name);
+	if (uniform && update(*uniform, matrix.data(), sizeof(matrix))) {
+		GLCall(glUniformMatrix4fv(uniform->location, 1, GL_FALSE,
+								  matrix.data()));
+	}
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <glbinding/gl/gl.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// A uniform name together with its hash. Looking a uniform up only compares
+// hashes and never touches the string. The constructors are constexpr, so a
+// constexpr UniformName has its hash computed at compile time:
+//   static constexpr UniformName kColor("u_Color");
+//   shader.setUniform(kColor, r, g, b, a);
+// Passing the string straight to setUniform() converts it at the call, which
+// hashes the name at runtime every time (unless the optimizer folds it).
+class UniformName {
+  private:
+	std::uint64_t m_hash;
+
+  public:
+	static constexpr std::uint64_t hash(std::string_view name) {
+		// 64-bit FNV-1a
+		std::uint64_t hash = 0xcbf29ce484222325ULL;
+		for (char c : name) {
+			hash ^= static_cast<unsigned char>(c);
+			hash *= 0x100000001b3ULL;
+		}
+		return hash;
+	}
+
+	// NOLINTNEXTLINE(google-explicit-constructor)
+	constexpr UniformName(std::string_view name) : m_hash(hash(name)) {}
+	// NOLINTNEXTLINE(google-explicit-constructor)
+	constexpr UniformName(const char *name)
+		: m_hash(hash(std::string_view(name))) {}
+
+	[[nodiscard]] constexpr std::uint64_t getHash() const {
+		return m_hash;
+	}
+};
+
+// Owns a linked program. All its active uniforms are looked up once after
+// linking and kept in a flat table sorted by name hash, along with the last
+// value uploaded to each of them. Setting a uniform to the value it already
+// has doesn't call into the driver at all.
+//
+// Like glUniform*, the setters need the program to be bound.
+class Shader {
+  public:
+	struct Stats {
+		unsigned long issued = 0;
+		unsigned long skipped = 0;
+		// Uniforms that don't exist, or were optimized out by the compiler
+		unsigned long missing = 0;
+	};
+
+  private:
+	struct Uniform {
+		gl::GLint location;
+		gl::GLenum type;
+		// Where the last uploaded value lives in m_values
+		std::uint32_t offset;
+		std::uint32_t size;
+		bool uploaded;
+	};
+
+	unsigned int m_rendererID;
+	bool moved = false;
+	// Sorted by hash
+	std::vector<std::pair<std::uint64_t, std::uint32_t>> m_lookup;
+	std::vector<Uniform> m_uniforms;
+	std::vector<unsigned char> m_values;
+	Stats m_stats;
+
+	void reflect();
+	void release();
+	Uniform *find(UniformName name);
+	// Returns false if the value is the same as the last one uploaded
+	bool update(Uniform &uniform, const void *value, size_t size);
+
+  public:
+	// Takes ownership of a linked program
+	explicit Shader(unsigned int program);
+	Shader(const Shader &other) = delete;
+	Shader(Shader &&other);
+	Shader operator=(const Shader &other) = delete;
+	Shader &operator=(Shader &&other);
+	~Shader();
+
+	// Replaces the program, e.g. after a hot reload. The old one is deleted and
+	// the uniforms are looked up again.
+	void reload(unsigned int program);
+
+	void bind() const;
+	void unbind() const;
+
+	// -1 if the uniform doesn't exist
+	[[nodiscard]] gl::GLint getUniformLocation(UniformName name);
+
+	void setUniform(UniformName name, float x);
+	void setUniform(UniformName name, float x, float y);
+	void setUniform(UniformName name, float x, float y, float z);
+	void setUniform(UniformName name, float x, float y, float z, float w);
+	void setUniform(UniformName name, int x);
+	void setUniform(UniformName name, int x, int y);
+	void setUniform(UniformName name, int x, int y, int z, int w);
+	void setUniform(UniformName name, unsigned int x);
+	// A whole int array, e.g. the texture units of a sampler array
+	void setUniform(UniformName name, const int *values, std::size_t count);
+	// A whole vec4 array, e.g. the planes of a frustum
+	void setUniform(UniformName name, const std::array<float, 4> *values,
+					std::size_t count);
+	// Column major, like GLSL
+	void setUniform(UniformName name, const std::array<float, 9> &matrix);
+	void setUniform(UniformName name, const std::array<float, 16> &matrix);
+
+	[[nodiscard]] inline unsigned int GetRendererID() const {
+		return m_rendererID;
+	};
+	[[nodiscard]] inline const Stats &getStats() const {
+		return m_stats;
+	}
+	inline void resetStats() {
+		m_stats = {};
+	}
+};
@@ -0,0 +1,176 @@
+#include "shadercompiler.h"
+
+#include "renderer.h"
+
+#include <iostream>
+
+using namespace gl;
+
+static const char *ShaderTypeName(GLenum type) {
+	switch (type) {
+	case GLenum::GL_VERTEX_SHADER:
+		return "vertex";
+	case GLenum::GL_FRAGMENT_SHADER:
+		return "fragment";
+	case GLenum::GL_GEOMETRY_SHADER:
+		return "geometry";
+	case GLenum::GL_TESS_CONTROL_SHADER:
+		return "tessellation control";
+	case GLenum::GL_TESS_EVALUATION_SHADER:
+		return "tessellation evaluation";
+	case GLenum::GL_COMPUTE_SHADER:
+		return "compute";
+	default:
+		return "unknown";
+	}
+}
+
+GLenum GetShaderStageType(ShaderStage stage) {
+	switch (stage) {
+	case ShaderStage::VERTEX:
+		return GL_VERTEX_SHADER;
+	case ShaderStage::FRAGMENT:
+		return GL_FRAGMENT_SHADER;
+	case ShaderStage::GEOMETRY:
+		return GL_GEOMETRY_SHADER;
+	case ShaderStage::TESS_CONTROL:
+		return GL_TESS_CONTROL_SHADER;
+	case ShaderStage::TESS_EVALUATION:
+		return GL_TESS_EVALUATION_SHADER;
+	case ShaderStage::COMPUTE:
+		return GL_COMPUTE_SHADER;
+	}
+	return GL_NONE;
+}
+
+GLuint CompileShader(GLenum type, const std::string &source) {
+	return CompileShader(type, std::vector<std::string_view>{source});
+}
+
+GLuint SubmitShader(GLenum type, const std::vector<std::string_view> &pieces) {
+	std::vector<const GLchar *> strings;
+	std::vector<GLint> lengths;
+	strings.reserve(pieces.size());
+	lengths.reserve(pieces.size());
+	for (std::string_view piece : pieces) {
+		strings.push_back(piece.data());
+		lengths.push_back(static_cast<GLint>(piece.size()));
+	}
+
+	GLuint id = GLCallV(glCreateShader(type));
+	GLCall(glShaderSource(id, static_cast<GLsizei>(strings.size()),
+						  strings.data(), lengths.data()));
+	GLCall(glCompileShader(id));
+	return id;
+}
+
+GLuint CompileShader(GLenum type, const std::vector<std::string_view> &pieces) {
+	GLuint id = SubmitShader(type, pieces);
+
+	// Retrieve the result of the compilation
+	GLint result = 0;
+	GLCall(glGetShaderiv(id, GL_COMPILE_STATUS, &result));
+	if (result == 0) {
+		// Shader didn't compile successfully
+		// Query the error message's length
+		int length = 0;
+		GLCall(glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length));
+		std::string message(static_cast<size_t>(length), '\0');
+		// Returns the information log for a shader object
+		GLCall(glGetShaderInfoLog(id, length, nullptr, message.data()));
+		std::cerr << "Failed to compile " << ShaderTypeName(type)
+				  << " shader!" << std::endl
+				  << message << std::endl;
+		GLCall(glDeleteShader(id));
+		return 0;
+	}
+
+	return id;
+}
+
+// Links the shaders into a program and deletes them, returns 0 if linking
+// failed
+static GLuint LinkProgram(const std::vector<GLuint> &shaders,
+						  bool binaryRetrievable) {
+	GLuint program = GLCallV(glCreateProgram());
+	if (binaryRetrievable) {
+		// Has to be set before linking, GL_TRUE
+		GLCall(glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+								   1));
+	}
+
+	for (GLuint shader : shaders) {
+		GLCall(glAttachShader(program, shader));
+	}
+	GLCall(glLinkProgram(program));
+	GLCall(glValidateProgram(program));
+
+	for (GLuint shader : shaders) {
+		GLCall(glDeleteShader(shader));
+	}
+
+	GLint linked = 0;
+	GLCall(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+	if (linked == 0) {
+		int length = 0;
+		GLCall(glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length));
+		std::string message(static_cast<size_t>(length), '\0');
+		GLCall(glGetProgramInfoLog(program, length, nullptr, message.data()));
+		std::cerr << "Failed to link program!" << std::endl
+				  << message << std::endl;
+		GLCall(glDeleteProgram(program));
+		return 0;
+	}
+
+	return program;
+}
+
+GLuint CreateProgram(const std::string &vertexShaderSrc,
+					 const std::string &fragmentShaderSrc,
+					 bool binaryRetrievable) {
+	// Create the two shader objects
+	GLuint vs = CompileShader(GL_VERTEX_SHADER, vertexShaderSrc);
+	GLuint fs = CompileShader(GL_FRAGMENT_SHADER, fragmentShaderSrc);
+	if (vs == 0 || fs == 0) {
+		GLCall(glDeleteShader(vs));
+		GLCall(glDeleteShader(fs));
+		return 0;
+	}
+
+	return LinkProgram({vs, fs}, binaryRetrievable);
+}
+
+GLuint CreateComputeProgram(const std::string &computeShaderSrc) {
+	GLuint cs = CompileShader(GL_COMPUTE_SHADER, computeShaderSrc);
+	if (cs == 0)
+		return 0;
+	return LinkProgram({cs}, false);
+}
+
+std::string ApplyDefines(const std::string &source,
+						 const std::vector<std::string> &defines) {
+	if (defines.empty())
+		return source;
+
+	std::string block;
+	for (const std::string &define : defines)
+		block += "#define " + define + "\n";
+
+	// Insert after the line holding #version, or at the very top without one
+	size_t insertAt = 0;
+	size_t version = source.find("#version");
+	if (version != std::string::npos) {
+		size_t lineEnd = source.find('\n', version);
+		insertAt = lineEnd == std::string::npos ? source.size() : lineEnd + 1;
+	}
+
+	std::string result;
+	result.reserve(source.size() + block.size());
+	result.append(source, 0, insertAt);
+	if (insertAt == source.size() && insertAt != 0 &&
+		source.back() != '\n')
+		result += '\n';
+	result += block;
+	result.append(source, insertAt, std::string::npos);
+	return result;
+}
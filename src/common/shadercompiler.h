@@ -0,0 +1,38 @@
+#pragma once
+#include "shadersource.h"
+
+#include <glbinding/gl/gl.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+gl::GLenum GetShaderStageType(ShaderStage stage);
+
+// Creates the shader and starts compiling it without waiting for the result,
+// so the driver can get on with it in the background. The caller checks
+// GL_COMPILE_STATUS (or the link status of a program it's attached to).
+gl::GLuint SubmitShader(gl::GLenum type,
+						const std::vector<std::string_view> &pieces);
+
+// Compile a single shader stage, returns 0 and prints the info log on failure
+gl::GLuint CompileShader(gl::GLenum type, const std::string &source);
+// Same as above, but hands the slices to the driver as they are instead of
+// joining them first
+gl::GLuint CompileShader(gl::GLenum type,
+						 const std::vector<std::string_view> &pieces);
+
+// Compile the two shaders and link them together into a single program and
+// return its id, or 0 if anything failed. Set binaryRetrievable when the
+// program is going to be passed to glGetProgramBinary.
+gl::GLuint CreateProgram(const std::string &vertexShaderSrc,
+						 const std::string &fragmentShaderSrc,
+						 bool binaryRetrievable = false);
+
+// Same for a compute shader, which makes up a program on its own. Needs GL 4.3
+// or ARB_compute_shader.
+gl::GLuint CreateComputeProgram(const std::string &computeShaderSrc);
+
+// Returns source with a "#define <define>" line for each define inserted right
+// after the #version directive (which has to stay the first line)
+std::string ApplyDefines(const std::string &source,
+						 const std::vector<std::string> &defines);
@@ -0,0 +1,150 @@
+#include "shaderreloader.h"
+
+#include "filewatcher.h"
+#include "programbuilder.h"
+#include "renderer.h"
+#include "shadersource.h"
+
+#include <algorithm>
+#include <glbinding/glbinding.h>
+#include <iostream>
+
+using namespace gl;
+
+ShaderReloader::ShaderReloader(const GLFWObjects::Window &window)
+	: m_context(GLFWObjects::Window::createSharedContext(window)) {}
+
+ShaderReloader::~ShaderReloader() {
+	m_stop = true;
+	if (m_worker.joinable())
+		m_worker.join();
+
+	// Programs that were built but never swapped in
+	for (const Result &result : m_results) {
+		GLCall(glDeleteSync(result.fence));
+		GLCall(glDeleteProgram(result.program));
+	}
+}
+
+ShaderReloader::Handle ShaderReloader::watch(const std::string &path,
+											 GLuint program) {
+	ASSERT(!m_worker.joinable());
+	m_entries.push_back({ShaderLibrary::normalizePath(path), program});
+	return m_entries.size() - 1;
+}
+
+void ShaderReloader::start() {
+	if (!m_context.isValid()) {
+		std::cerr << "[ShaderReloader] Couldn't create a shared context, "
+					 "hot reloading is disabled"
+				  << std::endl;
+		return;
+	}
+	m_worker = std::thread(&ShaderReloader::run, this);
+}
+
+bool ShaderReloader::update() {
+	// The common case is a single atomic load
+	if (!m_hasResults.load(std::memory_order_acquire))
+		return false;
+
+	std::vector<Result> results;
+	{
+		std::lock_guard<std::mutex> lock(m_resultsMutex);
+		results.swap(m_results);
+		m_hasResults = false;
+	}
+
+	for (const Result &result : results) {
+		// Make sure the worker's commands are done before using the program,
+		// this waits on the GPU side without blocking here
+		GLCall(glWaitSync(result.fence, GL_NONE_BIT, GL_TIMEOUT_IGNORED));
+		GLCall(glDeleteSync(result.fence));
+
+		Entry &entry = m_entries[result.handle];
+		entry.program = result.program;
+		std::cerr << "[ShaderReloader] Reloaded " << entry.path << std::endl;
+	}
+	return true;
+}
+
+GLuint ShaderReloader::getProgram(Handle handle) const {
+	return m_entries.at(handle).program;
+}
+
+void ShaderReloader::run() {
+	GLFWObjects::GLFW::getInstance().makeContextCurrent(m_context);
+	// Every context needs its own function pointers
+	auto contextHandle = reinterpret_cast<glbinding::ContextHandle>(this);
+	glbinding::initialize(contextHandle, glfwGetProcAddress);
+	GLDebugInitShared();
+
+	ShaderLibrary library;
+	FileWatcher watcher;
+	ProgramBuilder builder;
+
+	auto watchDependencies = [&](const std::string &path) {
+		watcher.addFile(path);
+		for (const std::string &dependency : library.getDependencies(path))
+			watcher.addFile(dependency);
+	};
+	for (const Entry &entry : m_entries)
+		watchDependencies(entry.path);
+
+	while (!m_stop) {
+		std::vector<std::string> changed =
+			watcher.waitForChanges(std::chrono::milliseconds(100));
+		if (changed.empty())
+			continue;
+
+		// Work out which shaders are affected before forgetting the files,
+		// the include graph goes with them
+		std::vector<Handle> affected;
+		for (const std::string &path : changed) {
+			std::vector<std::string> dependents = library.getDependents(path);
+			dependents.push_back(path);
+			for (Handle handle = 0; handle < m_entries.size(); handle++) {
+				bool isAffected =
+					std::find(dependents.begin(), dependents.end(),
+							  m_entries[handle].path) != dependents.end();
+				if (isAffected && std::find(affected.begin(), affected.end(),
+											handle) == affected.end())
+					affected.push_back(handle);
+			}
+		}
+		for (const std::string &path : changed)
+			library.invalidate(path);
+
+		for (Handle handle : affected) {
+			const std::string &path = m_entries[handle].path;
+			std::optional<ShaderSource> source = library.parse(path);
+			if (!source) {
+				std::cerr << "[ShaderReloader] Keeping the old " << path
+						  << std::endl;
+				continue;
+			}
+			// New includes might have shown up
+			watchDependencies(path);
+
+			GLuint program = builder.wait(builder.submit(*source));
+			if (program == 0) {
+				std::cerr << "[ShaderReloader] Keeping the old " << path
+						  << std::endl;
+				continue;
+			}
+
+			// The render context may only use the program once everything
+			// here has executed, and the fence has to reach the GPU
+			GLsync fence = GLCallV(
+				glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, GL_NONE_BIT));
+			GLCall(glFlush());
+
+			std::lock_guard<std::mutex> lock(m_resultsMutex);
+			m_results.push_back({handle, program, fence});
+			m_hasResults.store(true, std::memory_order_release);
+		}
+	}
+
+	glbinding::releaseContext(contextHandle);
+	glfwMakeContextCurrent(nullptr);
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "pr_glfw.h"
+
+#include <glbinding/gl/gl.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Rebuilds programs whenever their shader files, or any file they include,
+// change on disk. The files are watched, parsed and compiled on a background
+// thread with its own context that shares objects with the render context,
+// so the render loop never waits on the compiler. Finished programs are
+// handed over through update(), which the render thread calls at a frame
+// boundary. A program that fails to build is reported and the old one keeps
+// running.
+//
+// Usage:
+//   Shader shader(program);
+//   ShaderReloader reloader(window);
+//   auto handle = reloader.watch("res/shaders/Basic.shader", program);
+//   reloader.start();
+//   while (...) {
+//       if (reloader.update())
+//           shader.reload(reloader.getProgram(handle));
+//       ...
+//   }
+class ShaderReloader {
+  public:
+	using Handle = size_t;
+
+  private:
+	struct Entry {
+		std::string path;
+		gl::GLuint program;
+	};
+
+	struct Result {
+		Handle handle;
+		gl::GLuint program;
+		gl::GLsync fence;
+	};
+
+	GLFWObjects::Window m_context;
+	// Only the render thread touches the programs, the paths don't change
+	// once the worker is running
+	std::vector<Entry> m_entries;
+
+	std::mutex m_resultsMutex;
+	std::vector<Result> m_results;
+	std::atomic<bool> m_hasResults{false};
+
+	std::atomic<bool> m_stop{false};
+	std::thread m_worker;
+
+	void run();
+
+  public:
+	// Creates the shared context, has to be called on the main thread
+	explicit ShaderReloader(const GLFWObjects::Window &window);
+	ShaderReloader(const ShaderReloader &other) = delete;
+	ShaderReloader &operator=(const ShaderReloader &other) = delete;
+	~ShaderReloader();
+
+	// Registers a shader file and the program currently built from it. Only
+	// valid before start(). All the programs are owned by the caller, which
+	// has to delete the old one when update() swaps in a new one.
+	Handle watch(const std::string &path, gl::GLuint program);
+	void start();
+
+	// Swaps in the programs that finished rebuilding, returns true if any did.
+	// Call on the render thread between frames.
+	bool update();
+	[[nodiscard]] gl::GLuint getProgram(Handle handle) const;
+};
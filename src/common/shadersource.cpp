@@ -0,0 +1,304 @@
+#include "shadersource.h"
+
+#include "jobsystem.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+
+constexpr std::array<std::string_view, kShaderStageCount> kStageTags{
+	"vertex",		"fragment",		   "geometry",
+	"tess_control", "tess_evaluation", "compute"};
+
+bool IsSpace(char c) {
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+std::string_view TrimLeft(std::string_view str) {
+	size_t i = 0;
+	while (i < str.size() && IsSpace(str[i]))
+		i++;
+	return str.substr(i);
+}
+
+// Returns the rest of line if it starts with the given directive
+std::optional<std::string_view> MatchDirective(std::string_view line,
+											   std::string_view directive) {
+	line = TrimLeft(line);
+	if (line.empty() || line[0] != '#')
+		return std::nullopt;
+	line = TrimLeft(line.substr(1));
+	if (line.substr(0, directive.size()) != directive)
+		return std::nullopt;
+	line = line.substr(directive.size());
+	if (!line.empty() && !IsSpace(line[0]) && line[0] != '"')
+		return std::nullopt;
+	return TrimLeft(line);
+}
+
+} // namespace
+
+const char *ShaderStageName(ShaderStage stage) {
+	return kStageTags[static_cast<size_t>(stage)].data();
+}
+
+std::string ShaderSource::str(ShaderStage stage) const {
+	const std::vector<std::string_view> &slices = pieces(stage);
+	size_t size = 0;
+	for (std::string_view slice : slices)
+		size += slice.size();
+
+	std::string result;
+	result.reserve(size);
+	for (std::string_view slice : slices)
+		result.append(slice);
+	return result;
+}
+
+std::string ShaderLibrary::normalizePath(const std::string &path) {
+	return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+std::unique_ptr<ShaderLibrary::File>
+ShaderLibrary::read(const std::string &path) {
+	MappedFile mapping(path);
+	if (!mapping.isValid()) {
+		std::cerr << "Failed to open shader file " << path << std::endl;
+		return nullptr;
+	}
+
+	auto file = std::make_unique<File>(File{std::move(mapping), {}, {}, {}});
+	std::string_view text = file->mapping.view();
+	std::filesystem::path directory = std::filesystem::path(path).parent_path();
+
+	Section *section = &file->preamble;
+	section->present = true;
+	size_t runStart = 0;
+	auto flushRun = [&](size_t end) {
+		if (end > runStart)
+			section->segments.push_back(
+				{text.substr(runStart, end - runStart), {}});
+	};
+
+	size_t lineStart = 0;
+	while (lineStart < text.size()) {
+		const char *newline = static_cast<const char *>(std::memchr(
+			text.data() + lineStart, '\n', text.size() - lineStart));
+		size_t lineEnd = newline == nullptr
+							 ? text.size()
+							 : static_cast<size_t>(newline - text.data()) + 1;
+		std::string_view line = text.substr(lineStart, lineEnd - lineStart);
+
+		// Only lines starting with a '#' can be directives we care about
+		std::string_view trimmed = TrimLeft(line);
+		if (!trimmed.empty() && trimmed[0] == '#') {
+			if (auto tag = MatchDirective(line, "shader")) {
+				flushRun(lineStart);
+				auto stage = std::find_if(
+					kStageTags.begin(), kStageTags.end(),
+					[&](std::string_view name) {
+						return tag->substr(0, name.size()) == name &&
+							   (tag->size() == name.size() ||
+								IsSpace((*tag)[name.size()]) ||
+								(*tag)[name.size()] == '\n');
+					});
+				if (stage == kStageTags.end()) {
+					std::cerr << path << ": unknown shader stage in " << line;
+					return nullptr;
+				}
+				section = &file->stages[static_cast<size_t>(
+					stage - kStageTags.begin())];
+				section->present = true;
+				runStart = lineEnd;
+			} else if (auto include = MatchDirective(line, "include")) {
+				size_t open = include->find('"');
+				size_t close = include->find('"', open + 1);
+				if (open == std::string_view::npos ||
+					close == std::string_view::npos) {
+					std::cerr << path << ": malformed " << line;
+					return nullptr;
+				}
+				flushRun(lineStart);
+				std::string includePath = normalizePath(
+					(directory / std::string(include->substr(
+									 open + 1, close - open - 1)))
+						.string());
+				section->segments.push_back({{}, includePath});
+				if (std::find(file->includes.begin(), file->includes.end(),
+							  includePath) == file->includes.end())
+					file->includes.push_back(includePath);
+				runStart = lineEnd;
+			}
+		}
+		lineStart = lineEnd;
+	}
+	flushRun(text.size());
+	return file;
+}
+
+const ShaderLibrary::File *ShaderLibrary::load(const std::string &path) {
+	auto cached = m_files.find(path);
+	if (cached != m_files.end())
+		return cached->second.get();
+
+	std::unique_ptr<File> file = read(path);
+	if (!file)
+		return nullptr;
+	return m_files.emplace(path, std::move(file)).first->second.get();
+}
+
+bool ShaderLibrary::appendSection(const Section &section, ShaderStage stage,
+								  std::vector<std::string_view> &pieces,
+								  std::vector<const File *> &included) {
+	for (const Segment &segment : section.segments) {
+		if (segment.path.empty()) {
+			pieces.push_back(segment.text);
+		} else if (!append(segment.path, stage, pieces, included)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ShaderLibrary::append(const std::string &path, ShaderStage stage,
+						   std::vector<std::string_view> &pieces,
+						   std::vector<const File *> &included) {
+	const File *file = load(path);
+	if (file == nullptr)
+		return false;
+
+	// Include once, this also stops include cycles
+	if (std::find(included.begin(), included.end(), file) != included.end())
+		return true;
+	included.push_back(file);
+
+	return appendSection(file->preamble, stage, pieces, included) &&
+		   appendSection(file->stages[static_cast<size_t>(stage)], stage,
+						 pieces, included);
+}
+
+std::optional<ShaderSource> ShaderLibrary::parse(const std::string &path) {
+	std::string normalized = normalizePath(path);
+	const File *file = load(normalized);
+	if (file == nullptr)
+		return std::nullopt;
+
+	ShaderSource source;
+	std::vector<const File *> included;
+	for (size_t i = 0; i < kShaderStageCount; i++) {
+		// Stages the file doesn't define stay empty, even with a preamble
+		if (!file->stages[i].present)
+			continue;
+		included.clear();
+		if (!append(normalized, static_cast<ShaderStage>(i),
+					source.stages[i], included))
+			return std::nullopt;
+	}
+	return source;
+}
+
+std::vector<std::optional<ShaderSource>>
+ShaderLibrary::parseAll(const std::vector<std::string> &paths,
+						JobSystem &jobs) {
+	// Read the files that aren't cached yet on the workers, then the ones
+	// they include, and so on. Only the merge into m_files runs here.
+	std::vector<std::string> pending;
+	std::vector<std::string> failed;
+	auto addPending = [&](const std::string &path) {
+		if (m_files.find(path) == m_files.end() &&
+			std::find(pending.begin(), pending.end(), path) == pending.end() &&
+			std::find(failed.begin(), failed.end(), path) == failed.end())
+			pending.push_back(path);
+	};
+	for (const std::string &path : paths)
+		addPending(normalizePath(path));
+
+	while (!pending.empty()) {
+		std::vector<std::unique_ptr<File>> files(pending.size());
+		jobs.parallelFor(pending.size(), 1, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++)
+				files[i] = read(pending[i]);
+		});
+
+		std::vector<const File *> batch;
+		for (size_t i = 0; i < pending.size(); i++) {
+			if (files[i]) {
+				batch.push_back(
+					m_files.emplace(pending[i], std::move(files[i]))
+						.first->second.get());
+			} else {
+				// read() already said why
+				failed.push_back(pending[i]);
+			}
+		}
+		pending.clear();
+		for (const File *file : batch) {
+			for (const std::string &include : file->includes)
+				addPending(include);
+		}
+	}
+
+	// Assembling the stages only collects slices
+	std::vector<std::optional<ShaderSource>> sources;
+	sources.reserve(paths.size());
+	for (const std::string &path : paths) {
+		if (std::find(failed.begin(), failed.end(), normalizePath(path)) !=
+			failed.end())
+			sources.emplace_back();
+		else
+			sources.push_back(parse(path));
+	}
+	return sources;
+}
+
+std::vector<std::string>
+ShaderLibrary::getDependencies(const std::string &path) {
+	std::string root = normalizePath(path);
+	std::vector<std::string> dependencies;
+	std::vector<std::string> pending{root};
+	while (!pending.empty()) {
+		std::string current = std::move(pending.back());
+		pending.pop_back();
+		const File *file = load(current);
+		if (file == nullptr)
+			continue;
+		for (const std::string &include : file->includes) {
+			if (include != root &&
+				std::find(dependencies.begin(), dependencies.end(), include) ==
+					dependencies.end()) {
+				dependencies.push_back(include);
+				pending.push_back(include);
+			}
+		}
+	}
+	return dependencies;
+}
+
+std::vector<std::string>
+ShaderLibrary::getDependents(const std::string &path) const {
+	std::vector<std::string> dependents;
+	std::vector<std::string> pending{normalizePath(path)};
+	while (!pending.empty()) {
+		std::string current = std::move(pending.back());
+		pending.pop_back();
+		for (const auto &[filePath, file] : m_files) {
+			bool includesCurrent =
+				std::find(file->includes.begin(), file->includes.end(),
+						  current) != file->includes.end();
+			if (includesCurrent &&
+				std::find(dependents.begin(), dependents.end(), filePath) ==
+					dependents.end()) {
+				dependents.push_back(filePath);
+				pending.push_back(filePath);
+			}
+		}
+	}
+	return dependents;
+}
+
+void ShaderLibrary::invalidate(const std::string &path) {
+	m_files.erase(normalizePath(path));
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include "mappedfile.h"
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class JobSystem;
+
+// Shader files hold several stages, each one starts with a tag line
+//   #shader vertex|fragment|geometry|tess_control|tess_evaluation|compute
+// Anything before the first tag is a preamble shared by every stage, so a
+// single #version line can go there.
+//
+// Stages can pull in other files with
+//   #include "relative/path.glsl"
+// which is resolved relative to the including file. An included file
+// contributes its preamble followed by its section for the same stage, if it
+// has one. Every file is included at most once per stage, repeated (or
+// recursive) includes are skipped.
+enum class ShaderStage {
+	VERTEX,
+	FRAGMENT,
+	GEOMETRY,
+	TESS_CONTROL,
+	TESS_EVALUATION,
+	COMPUTE
+};
+inline constexpr size_t kShaderStageCount = 6;
+
+const char *ShaderStageName(ShaderStage stage);
+
+// The assembled source of every stage as a list of slices into the mapped
+// files, in order. The slices stay valid as long as the ShaderLibrary that
+// produced them, and until any of the files are invalidated.
+struct ShaderSource {
+	std::array<std::vector<std::string_view>, kShaderStageCount> stages;
+
+	[[nodiscard]] inline bool hasStage(ShaderStage stage) const {
+		return !stages[static_cast<size_t>(stage)].empty();
+	}
+	[[nodiscard]] inline const std::vector<std::string_view> &
+	pieces(ShaderStage stage) const {
+		return stages[static_cast<size_t>(stage)];
+	}
+	// Joins the slices of a stage into a single string
+	[[nodiscard]] std::string str(ShaderStage stage) const;
+};
+
+// Memory maps shader files and splits them into stages without copying any
+// of their text. Parsed files are cached, so shared includes are only read
+// once, and the include graph is kept around for file watchers.
+class ShaderLibrary {
+  private:
+	struct Segment {
+		// Either a run of text, or an include when path isn't empty
+		std::string_view text;
+		std::string path;
+	};
+
+	struct Section {
+		bool present = false;
+		std::vector<Segment> segments;
+	};
+
+	struct File {
+		MappedFile mapping;
+		Section preamble;
+		std::array<Section, kShaderStageCount> stages;
+		// Resolved paths of the files this one includes directly
+		std::vector<std::string> includes;
+	};
+
+	std::unordered_map<std::string, std::unique_ptr<File>> m_files;
+
+	// Maps and splits a file without touching the cache
+	static std::unique_ptr<File> read(const std::string &path);
+	const File *load(const std::string &path);
+	bool append(const std::string &path, ShaderStage stage,
+				std::vector<std::string_view> &pieces,
+				std::vector<const File *> &included);
+	bool appendSection(const Section &section, ShaderStage stage,
+					   std::vector<std::string_view> &pieces,
+					   std::vector<const File *> &included);
+
+  public:
+	// Returns nothing if the file, or any file it includes, can't be read
+	std::optional<ShaderSource> parse(const std::string &path);
+	// parse() for every path, with the files and the ones they include read
+	// and split on the job system. Only the calling thread touches the
+	// cache, so a library can still only be used by one thread at a time.
+	std::vector<std::optional<ShaderSource>>
+	parseAll(const std::vector<std::string> &paths, JobSystem &jobs);
+
+	// Every file path includes, directly or indirectly
+	std::vector<std::string> getDependencies(const std::string &path);
+	// Every cached file that includes path, directly or indirectly
+	std::vector<std::string> getDependents(const std::string &path) const;
+	// Drops path from the cache so the next parse reads it again. Slices
+	// pointing into it become invalid.
+	void invalidate(const std::string &path);
+
+	[[nodiscard]] inline size_t getCachedFileCount() const {
+		return m_files.size();
+	}
+
+	static std::string normalizePath(const std::string &path);
+};
@@ -0,0 +1,70 @@
+#include "storagebuffer.h"
+
+#include "deletionqueue.h"
+#include "glbinding/gl/gl.h"
+#include "renderer.h"
+
+using namespace gl;
+
+StorageBuffer::StorageBuffer(const void *data, std::size_t size)
+	: m_rendererID(0), m_size(size) {
+	GLCall(glGenBuffers(1, &m_rendererID));
+	GLState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, m_rendererID);
+	GLCall(glBufferData(GL_SHADER_STORAGE_BUFFER,
+						static_cast<GLsizeiptr>(size), data, GL_DYNAMIC_DRAW));
+}
+
+StorageBuffer::StorageBuffer(StorageBuffer &&other) {
+	this->m_rendererID = other.m_rendererID;
+	this->m_size = other.m_size;
+	other.moved = true;
+}
+
+StorageBuffer &StorageBuffer::operator=(StorageBuffer &&other) {
+	if (this == &other) {
+		return *this;
+	}
+
+	// Free existing resources being held by this object
+	release();
+
+	this->m_rendererID = other.m_rendererID;
+	this->m_size = other.m_size;
+	this->moved = false;
+	other.moved = true;
+
+	return *this;
+}
+
+StorageBuffer::~StorageBuffer() {
+	release();
+}
+
+void StorageBuffer::release() {
+	if (!moved) {
+		DeletionQueue::get().enqueueBuffer(m_rendererID);
+	}
+}
+
+void StorageBuffer::setData(const void *data, std::size_t size) {
+	GLState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, m_rendererID);
+	auto glSize = static_cast<GLsizeiptr>(size);
+	GLCall(glBufferData(GL_SHADER_STORAGE_BUFFER, glSize, nullptr,
+						GL_DYNAMIC_DRAW));
+	GLCall(glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, glSize, data));
+	m_size = size;
+}
+
+void StorageBuffer::setSubData(const void *data, std::size_t offset,
+							   std::size_t size) {
+	ASSERT(offset + size <= m_size);
+	GLState::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, m_rendererID);
+	GLCall(glBufferSubData(GL_SHADER_STORAGE_BUFFER,
+						   static_cast<GLintptr>(offset),
+						   static_cast<GLsizeiptr>(size), data));
+}
+
+void StorageBuffer::bindBase(unsigned int index) const {
+	GLState::get().bindBufferBase(GL_SHADER_STORAGE_BUFFER, index,
+								  m_rendererID);
+}
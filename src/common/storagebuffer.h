@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+
+// A shader storage buffer, for data that shaders index into themselves, e.g.
+// per-draw transforms looked up with gl_DrawID or gl_BaseInstance. The data
+// is bound to a binding point that matches the shader's
+// layout(std430, binding = N) block.
+//
+// Needs GL 4.3 or ARB_shader_storage_buffer_object.
+class StorageBuffer {
+  private:
+	unsigned int m_rendererID;
+	std::size_t m_size;
+	bool moved = false;
+
+	void release();
+
+  public:
+	// data can be null to leave the contents undefined
+	StorageBuffer(const void *data, std::size_t size);
+	StorageBuffer(const StorageBuffer &other) = delete;
+	StorageBuffer(StorageBuffer &&other);
+	StorageBuffer operator=(const StorageBuffer &other) = delete;
+	StorageBuffer &operator=(StorageBuffer &&other);
+	~StorageBuffer();
+
+	// Replaces the contents. The old storage is orphaned, so this doesn't
+	// wait for draws still reading it, and size may differ from the old one.
+	void setData(const void *data, std::size_t size);
+	// Overwrites size bytes at offset, which have to be within the buffer
+	void setSubData(const void *data, std::size_t offset, std::size_t size);
+
+	// Binds to GL_SHADER_STORAGE_BUFFER binding point index
+	void bindBase(unsigned int index) const;
+
+	[[nodiscard]] inline unsigned int GetRendererID() const {
+		return m_rendererID;
+	};
+	[[nodiscard]] inline std::size_t GetSize() const { return m_size; };
+};
@@ -0,0 +1,146 @@
+#include "streambuffer.h"
+
+#include "renderer.h"
+
+#include <utility>
+
+using namespace gl;
+
+StreamBuffer::StreamBuffer(GLenum target, std::size_t regionSize,
+						   unsigned int regionCount)
+	: m_target(target), m_regionSize(regionSize), m_regionCount(regionCount),
+	  m_fences(regionCount, nullptr) {
+	ASSERT(regionCount > 0);
+	auto size = static_cast<GLsizeiptr>(m_regionSize * m_regionCount);
+
+	GLCall(glGenBuffers(1, &m_rendererID));
+	GLState::get().bindBuffer(m_target, m_rendererID);
+	// Immutable storage is what allows the buffer to be used for drawing
+	// while it's mapped
+	GLCall(glBufferStorage(m_target, size, nullptr,
+						   GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+							   GL_MAP_COHERENT_BIT));
+	// Coherent means the writes are visible to the GPU without flushing or
+	// barriers, it's written sequentially so the write-combined memory the
+	// driver hands out is fine
+	m_mapping = static_cast<unsigned char *>(GLCallV(
+		glMapBufferRange(m_target, 0, size,
+						 GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+							 GL_MAP_COHERENT_BIT)));
+	ASSERT(m_mapping != nullptr);
+}
+
+StreamBuffer::StreamBuffer(StreamBuffer &&other)
+	: m_rendererID(other.m_rendererID), m_target(other.m_target),
+	  m_regionSize(other.m_regionSize), m_regionCount(other.m_regionCount),
+	  m_mapping(other.m_mapping), m_fences(std::move(other.m_fences)),
+	  m_region(other.m_region), m_head(other.m_head),
+	  m_stats(other.m_stats) {
+	other.moved = true;
+}
+
+StreamBuffer &StreamBuffer::operator=(StreamBuffer &&other) {
+	if (this == &other) {
+		return *this;
+	}
+
+	// Free existing resources being held by this object
+	release();
+
+	this->m_rendererID = other.m_rendererID;
+	this->m_target = other.m_target;
+	this->m_regionSize = other.m_regionSize;
+	this->m_regionCount = other.m_regionCount;
+	this->m_mapping = other.m_mapping;
+	this->m_fences = std::move(other.m_fences);
+	this->m_region = other.m_region;
+	this->m_head = other.m_head;
+	this->m_stats = other.m_stats;
+	this->moved = false;
+	other.moved = true;
+
+	return *this;
+}
+
+StreamBuffer::~StreamBuffer() {
+	release();
+}
+
+void StreamBuffer::release() {
+	if (moved)
+		return;
+	for (GLsync fence : m_fences) {
+		if (fence != nullptr) {
+			GLCall(glDeleteSync(fence));
+		}
+	}
+	// Deleting a mapped buffer unmaps it
+	GLState::get().onBufferDeleted(m_rendererID);
+	GLCall(glDeleteBuffers(1, &m_rendererID));
+}
+
+bool StreamBuffer::isSupported() {
+	GLint major = 0;
+	GLint minor = 0;
+	GLCall(glGetIntegerv(GL_MAJOR_VERSION, &major));
+	GLCall(glGetIntegerv(GL_MINOR_VERSION, &minor));
+	return major > 4 || (major == 4 && minor >= 4) ||
+		   GLHasExtension("GL_ARB_buffer_storage");
+}
+
+StreamBuffer::Allocation StreamBuffer::allocate(std::size_t size,
+												std::size_t alignment) {
+	std::size_t start = (m_head + alignment - 1) & ~(alignment - 1);
+	if (start + size > m_regionSize) {
+		m_stats.overflows++;
+		return {};
+	}
+	m_head = start + size;
+
+	std::size_t offset = m_region * m_regionSize + start;
+	return {m_mapping + offset, offset, size};
+}
+
+void StreamBuffer::endFrame() {
+	m_fences[m_region] =
+		GLCallV(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, GL_NONE_BIT));
+
+	m_region = (m_region + 1) % m_regionCount;
+	m_head = 0;
+	waitForRegion(m_region);
+}
+
+void StreamBuffer::waitForRegion(unsigned int region) {
+	GLsync &fence = m_fences[region];
+	if (fence == nullptr)
+		return;
+
+	// Checking without a timeout first keeps the common case cheap and
+	// lets the stall be measured accurately
+	GLenum result = GLCallV(glClientWaitSync(fence, GL_NONE_BIT, 0));
+	if (result == GL_TIMEOUT_EXPIRED) {
+		Clock::time_point start = Clock::now();
+		do {
+			// Flushing makes sure the fence actually gets to the GPU,
+			// otherwise this could wait forever
+			result = GLCallV(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+											  1000000));
+		} while (result == GL_TIMEOUT_EXPIRED);
+		m_stats.stalls++;
+		m_stats.stallMs +=
+			std::chrono::duration<double, std::milli>(Clock::now() - start)
+				.count();
+	}
+	ASSERT(result != GL_WAIT_FAILED);
+
+	GLCall(glDeleteSync(fence));
+	fence = nullptr;
+}
+
+void StreamBuffer::bind() const {
+	GLState::get().bindBuffer(m_target, m_rendererID);
+}
+
+void StreamBuffer::unbind() const {
+	GLState::get().bindBuffer(m_target, 0);
+}
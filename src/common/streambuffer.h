@@ -0,0 +1,97 @@
+#pragma once
+#include <glbinding/gl/gl.h>
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+// A buffer for data that's rewritten every frame. It's allocated once with
+// glBufferStorage and stays persistently and coherently mapped, split into
+// regionCount regions of regionSize bytes. Every frame writes straight into
+// the next region through the mapped pointer, and a fence is placed behind
+// the frame's draws so the CPU only waits when it's about to overwrite a
+// region the GPU is still reading, i.e. when it's regionCount frames ahead.
+//
+// Needs GL 4.4 or ARB_buffer_storage.
+//
+// Usage:
+//   StreamBuffer stream(GL_ARRAY_BUFFER, 16 << 20);
+//   while (...) {
+//       StreamBuffer::Allocation vertices = stream.allocate(size);
+//       write(vertices.data, size);
+//       stream.bind();
+//       glDrawArrays(GL_TRIANGLES, vertices.offset / stride, count);
+//       stream.endFrame();
+//       window.swapBuffers();
+//   }
+class StreamBuffer {
+  public:
+	struct Allocation {
+		// Null if the region doesn't have enough room left
+		void *data = nullptr;
+		// From the start of the buffer, what draw calls need
+		std::size_t offset = 0;
+		std::size_t size = 0;
+	};
+
+	struct Stats {
+		// Frames that had to wait for the GPU to release their region
+		unsigned long stalls = 0;
+		double stallMs = 0.0;
+		// Allocations that didn't fit into their region
+		unsigned long overflows = 0;
+	};
+
+  private:
+	using Clock = std::chrono::steady_clock;
+
+	unsigned int m_rendererID = 0;
+	gl::GLenum m_target;
+	std::size_t m_regionSize;
+	unsigned int m_regionCount;
+	unsigned char *m_mapping = nullptr;
+	// The fence behind the last frame that used each region
+	std::vector<gl::GLsync> m_fences;
+	unsigned int m_region = 0;
+	// Bytes used in the current region
+	std::size_t m_head = 0;
+	Stats m_stats;
+	bool moved = false;
+
+	void release();
+	void waitForRegion(unsigned int region);
+
+  public:
+	StreamBuffer(gl::GLenum target, std::size_t regionSize,
+				 unsigned int regionCount = 3);
+	StreamBuffer(const StreamBuffer &other) = delete;
+	StreamBuffer(StreamBuffer &&other);
+	StreamBuffer operator=(const StreamBuffer &other) = delete;
+	StreamBuffer &operator=(StreamBuffer &&other);
+	~StreamBuffer();
+
+	// Needs a current context
+	static bool isSupported();
+
+	// Space in the current frame's region, which stays valid until
+	// endFrame(). alignment has to be a power of two.
+	[[nodiscard]] Allocation allocate(std::size_t size,
+									  std::size_t alignment = 16);
+
+	// Call after the last draw that reads this frame's data. Fences the
+	// region and moves on to the next one, waiting if the GPU still uses it.
+	void endFrame();
+
+	void bind() const;
+	void unbind() const;
+
+	[[nodiscard]] inline unsigned int GetRendererID() const {
+		return m_rendererID;
+	};
+	[[nodiscard]] inline std::size_t GetRegionSize() const {
+		return m_regionSize;
+	};
+	[[nodiscard]] inline const Stats &getStats() const {
+		return m_stats;
+	}
+};
@@ -0,0 +1,179 @@
+#include "vertexarray.h"
+
+#include "glbinding/gl/gl.h"
+#include "indexbuffer.h"
+#include "renderer.h"
+
+using namespace gl;
+
+VertexArray::VertexArray()
+	: m_rendererID(0),
+	  m_directStateAccess(GLState::get().hasDirectStateAccess()) {
+	if (m_directStateAccess) {
+		GLCall(glCreateVertexArrays(1, &m_rendererID));
+	} else {
+		GLCall(glGenVertexArrays(1, &m_rendererID));
+	}
+}
+
+VertexArray::VertexArray(VertexArray &&other) {
+	this->m_rendererID = other.m_rendererID;
+	this->m_nextLocation = other.m_nextLocation;
+	this->m_directStateAccess = other.m_directStateAccess;
+	other.moved = true;
+}
+
+VertexArray &VertexArray::operator=(VertexArray &&other) {
+	if (this == &other) {
+		return *this;
+	}
+
+	// Free existing resources being held by this object
+	release();
+
+	this->m_rendererID = other.m_rendererID;
+	this->m_nextLocation = other.m_nextLocation;
+	this->m_directStateAccess = other.m_directStateAccess;
+	this->moved = false;
+	other.moved = true;
+
+	return *this;
+}
+
+VertexArray::~VertexArray() {
+	release();
+}
+
+void VertexArray::release() {
+	if (!moved) {
+		GLState::get().onVertexArrayDeleted(m_rendererID);
+		GLCall(glDeleteVertexArrays(1, &m_rendererID));
+	}
+}
+
+void VertexArray::addAttributes(unsigned int buffer,
+								const VertexAttribute *attributes,
+								std::size_t count, std::size_t stride,
+								unsigned int divisor) {
+	if (m_directStateAccess) {
+		// One binding per buffer, and locations are never handed out twice,
+		// so its first location is a binding no other buffer uses
+		GLuint binding = m_nextLocation;
+		GLCall(glVertexArrayVertexBuffer(m_rendererID, binding, buffer, 0,
+										 static_cast<GLsizei>(stride)));
+		for (std::size_t i = 0; i < count; i++) {
+			const VertexAttribute &attribute = attributes[i]; // NOLINT
+			GLuint location = m_nextLocation++;
+			auto size = static_cast<GLint>(attribute.count);
+			auto offset = static_cast<GLuint>(attribute.offset);
+
+			GLCall(glEnableVertexArrayAttrib(m_rendererID, location));
+			if (attribute.integer) {
+				GLCall(glVertexArrayAttribIFormat(m_rendererID, location, size,
+												  attribute.type, offset));
+			} else {
+				GLCall(glVertexArrayAttribFormat(
+					m_rendererID, location, size, attribute.type,
+					attribute.normalized ? GL_TRUE : GL_FALSE, offset));
+			}
+			GLCall(glVertexArrayAttribBinding(m_rendererID, location, binding));
+		}
+		if (divisor != 0) {
+			GLCall(glVertexArrayBindingDivisor(m_rendererID, binding, divisor));
+		}
+		return;
+	}
+
+	bind();
+	// glVertexAttribPointer captures whatever is bound to GL_ARRAY_BUFFER
+	GLState::get().bindBuffer(GL_ARRAY_BUFFER, buffer);
+	for (std::size_t i = 0; i < count; i++) {
+		const VertexAttribute &attribute = attributes[i]; // NOLINT
+		GLuint location = m_nextLocation++;
+		auto size = static_cast<GLint>(attribute.count);
+		auto glStride = static_cast<GLsizei>(stride);
+		// The offset into the buffer is passed as a pointer
+		const void *offset =
+			reinterpret_cast<const void *>(attribute.offset); // NOLINT
+
+		GLCall(glEnableVertexAttribArray(location));
+		if (attribute.integer) {
+			GLCall(glVertexAttribIPointer(location, size, attribute.type,
+										  glStride, offset));
+		} else {
+			GLCall(glVertexAttribPointer(
+				location, size, attribute.type,
+				attribute.normalized ? GL_TRUE : GL_FALSE, glStride, offset));
+		}
+		if (divisor != 0) {
+			GLCall(glVertexAttribDivisor(location, divisor));
+		}
+	}
+}
+
+void VertexArray::setIndexBuffer(const IndexBuffer &buffer) {
+	if (m_directStateAccess) {
+		setElementBuffer(buffer.GetRendererID());
+		return;
+	}
+	bind();
+	buffer.bind();
+}
+
+void VertexArray::setIndexBuffer(const BufferArena &arena) {
+	if (m_directStateAccess) {
+		setElementBuffer(arena.GetRendererID());
+		return;
+	}
+	bind();
+	arena.bind(GL_ELEMENT_ARRAY_BUFFER);
+}
+
+void VertexArray::setElementBuffer(unsigned int buffer) {
+	GLCall(glVertexArrayElementBuffer(m_rendererID, buffer));
+	GLState::get().onElementBufferSet(m_rendererID, buffer);
+}
+
+void VertexArray::bind() const {
+	GLState::get().bindVertexArray(m_rendererID);
+}
+
+void VertexArray::unbind() const {
+	GLState::get().bindVertexArray(0);
+}
+
+void VertexArray::draw(const IndexBuffer &ib, int baseVertex,
+					   GLenum mode) const {
+	bind();
+	GLState::get().setPrimitiveRestart(ib.HasPrimitiveRestart(),
+									   ib.GetRestartIndex());
+	auto count = static_cast<GLsizei>(ib.GetCount());
+	// NOLINTNEXTLINE(performance-no-int-to-ptr)
+	const void *offset = reinterpret_cast<const void *>(ib.GetOffset());
+	if (baseVertex == 0) {
+		GLCall(glDrawElements(mode, count, ib.GetType(), offset));
+	} else {
+		GLCall(glDrawElementsBaseVertex(mode, count, ib.GetType(), offset,
+										baseVertex));
+	}
+}
+
+void VertexArray::drawInstanced(const IndexBuffer &ib,
+								unsigned int instanceCount,
+								unsigned int baseInstance) const {
+	bind();
+	GLState::get().setPrimitiveRestart(ib.HasPrimitiveRestart(),
+									   ib.GetRestartIndex());
+	auto count = static_cast<GLsizei>(ib.GetCount());
+	auto instances = static_cast<GLsizei>(instanceCount);
+	// NOLINTNEXTLINE(performance-no-int-to-ptr)
+	const void *offset = reinterpret_cast<const void *>(ib.GetOffset());
+	if (baseInstance == 0) {
+		GLCall(glDrawElementsInstanced(GL_TRIANGLES, count, ib.GetType(),
+									   offset, instances));
+	} else {
+		GLCall(glDrawElementsInstancedBaseInstance(
+			GL_TRIANGLES, count, ib.GetType(), offset, instances,
+			baseInstance));
+	}
+}
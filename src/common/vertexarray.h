@@ -0,0 +1,118 @@
+#pragma once
+#include "vertexlayout.h"
+
+#include "vertexbuffer.h"
+
+#include <array>
+#include <cstddef>
+
+class BufferArena;
+class IndexBuffer;
+
+// Owns a VAO. The attribute setup for a whole VertexLayout is baked into it
+// in a single call, either from one interleaved buffer (array of structs) or
+// from one buffer per attribute (struct of arrays). Attribute locations are
+// handed out in order, starting after the ones set up by earlier calls.
+// Instance buffers are set up the same way, their attributes advance once
+// per instance instead of once per vertex.
+//
+// With direct state access (see GLState::hasDirectStateAccess()) the VAO is
+// set up without binding it or the buffers, and each addBuffer call gets a
+// vertex buffer binding of its own, numbered after its first attribute.
+//
+// Usage:
+//   VertexArray va;
+//   va.addBuffer<Layout>(vb);
+//   va.setIndexBuffer(ib);
+//   ...
+//   va.bind();
+//   glDrawElements(...);
+class VertexArray {
+  private:
+	unsigned int m_rendererID;
+	unsigned int m_nextLocation = 0;
+	// Whether it was created with glCreateVertexArrays, names from
+	// glGenVertexArrays can't be used with DSA before they're first bound
+	bool m_directStateAccess;
+	bool moved = false;
+
+	void release();
+	// Sets up the attributes from buffer starting at the next free location.
+	// A divisor of 0 advances them per vertex, n once every n instances.
+	void addAttributes(unsigned int buffer, const VertexAttribute *attributes,
+					   std::size_t count, std::size_t stride,
+					   unsigned int divisor);
+	// DSA only
+	void setElementBuffer(unsigned int buffer);
+
+  public:
+	VertexArray();
+	VertexArray(const VertexArray &other) = delete;
+	VertexArray(VertexArray &&other);
+	VertexArray operator=(const VertexArray &other) = delete;
+	VertexArray &operator=(VertexArray &&other);
+	~VertexArray();
+
+	// Every attribute of Layout comes from buffer, interleaved. buffer can be
+	// anything with a GetRendererID(), e.g. a VertexBuffer or StreamBuffer.
+	template <typename Layout, typename Buffer>
+	void addBuffer(const Buffer &buffer) {
+		addAttributes(buffer.GetRendererID(), Layout::attributes.data(),
+					  Layout::attributes.size(), Layout::stride, 0);
+	}
+
+	// Same as addBuffer, but the attributes advance once per divisor
+	// instances. A matrix takes one vec4 attribute per column.
+	template <typename Layout, typename Buffer>
+	void addInstanceBuffer(const Buffer &buffer, unsigned int divisor = 1) {
+		addAttributes(buffer.GetRendererID(), Layout::attributes.data(),
+					  Layout::attributes.size(), Layout::stride, divisor);
+	}
+
+	// Attribute i of Layout comes from buffers[i], tightly packed
+	template <typename Layout>
+	void addBuffers(const std::array<const VertexBuffer *,
+									 Layout::attributeCount> &buffers) {
+		for (std::size_t i = 0; i < Layout::attributeCount; i++) {
+			VertexAttribute attribute = Layout::attributes[i];
+			attribute.offset = 0;
+			addAttributes(buffers[i]->GetRendererID(), &attribute, 1,
+						  attribute.size, 0);
+		}
+	}
+
+	// Stays bound to the VAO, binding the VAO binds it too
+	void setIndexBuffer(const IndexBuffer &buffer);
+	// Every IndexBuffer allocated from arena can be drawn with the VAO
+	void setIndexBuffer(const BufferArena &arena);
+
+	void bind() const;
+	void unbind() const;
+
+	// Binds the VAO and draws the primitives in ib, which has to be the one
+	// set with setIndexBuffer, or another one in the same BufferArena. The
+	// indices start at ib's first index and have baseVertex added, which is
+	// how meshes that share arenas are drawn:
+	//   va.draw(ib, vb.GetBaseVertex());
+	// Primitive restart is turned on for index buffers created with it, e.g.
+	// to draw several strips at once with GL_TRIANGLE_STRIP.
+	void draw(const IndexBuffer &ib, int baseVertex = 0,
+			  gl::GLenum mode = gl::GLenum::GL_TRIANGLES) const;
+
+	// Binds the VAO and draws instanceCount instances of the triangles in ib,
+	// which has to be the one set with setIndexBuffer, with primitive restart
+	// the same as draw(). Instance attributes
+	// start at baseInstance, which needs GL 4.2 or ARB_base_instance unless
+	// it's 0. A streamed instance buffer can use it to point at this frame's
+	// region without setting the attributes up again.
+	void drawInstanced(const IndexBuffer &ib, unsigned int instanceCount,
+					   unsigned int baseInstance = 0) const;
+
+	[[nodiscard]] inline unsigned int GetRendererID() const {
+		return m_rendererID;
+	};
+	// The location the next attribute gets
+	[[nodiscard]] inline unsigned int GetNextLocation() const {
+		return m_nextLocation;
+	};
+};
@@ -1,5 +1,6 @@
 #include "vertexbuffer.h"
 
+#include "deletionqueue.h"
 #include "glbinding/gl/gl.h"
 #include "renderer.h"
 
@@ -7,17 +8,35 @@ using namespace gl;
 
 VertexBuffer::VertexBuffer(const void *data, unsigned int size)
 	: m_rendererID(0) {
+	if (GLState::get().hasDirectStateAccess()) {
+		// setData() orphans the storage and may grow it, so it can't be
+		// immutable
+		GLCall(glCreateBuffers(1, &m_rendererID));
+		GLCall(glNamedBufferData(m_rendererID, size, data, GL_STATIC_DRAW));
+		return;
+	}
 	// This function generates a buffer and stores
 	// its id in the second argument
 	GLCall(glGenBuffers(1, &m_rendererID));
 	// Select the buffer
-	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_rendererID));
+	GLState::get().bindBuffer(GL_ARRAY_BUFFER, m_rendererID);
 	// Set the buffer data in vram
 	GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));
 }
 
+VertexBuffer::VertexBuffer(BufferArena &arena, const void *data,
+						   unsigned int size)
+	: m_rendererID(arena.GetRendererID()), m_arena(&arena),
+	  m_allocation(arena.allocate(size)) {
+	// Out of room
+	ASSERT(m_allocation != BufferArena::kInvalid);
+	arena.upload(m_allocation, data, size);
+}
+
 VertexBuffer::VertexBuffer(VertexBuffer &&other) {
 	this->m_rendererID = other.m_rendererID;
+	this->m_arena = other.m_arena;
+	this->m_allocation = other.m_allocation;
 	other.moved = true;
 }
 
@@ -27,23 +46,51 @@ VertexBuffer &VertexBuffer::operator=(VertexBuffer &&other) {
 	}
 
 	// Free existing resources being held by this object
-	GLCall(glDeleteBuffers(1, &m_rendererID));
+	release();
 
 	this->m_rendererID = other.m_rendererID;
+	this->m_arena = other.m_arena;
+	this->m_allocation = other.m_allocation;
+	this->moved = false;
 	other.moved = true;
 
 	return *this;
 }
 
 VertexBuffer::~VertexBuffer() {
-	if (!moved)
-		GLCall(glDeleteBuffers(1, &m_rendererID));
+	release();
+}
+
+void VertexBuffer::release() {
+	if (moved)
+		return;
+	if (m_arena) {
+		if (m_allocation != BufferArena::kInvalid)
+			m_arena->free(m_allocation);
+		return;
+	}
+	DeletionQueue::get().enqueueBuffer(m_rendererID);
 }
 
 void VertexBuffer::bind() const {
-	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_rendererID));
+	GLState::get().bindBuffer(GL_ARRAY_BUFFER, m_rendererID);
 }
 
 void VertexBuffer::unbind() const {
-	GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+	GLState::get().bindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void VertexBuffer::setData(const void *data, unsigned int size) {
+	if (m_arena) {
+		m_arena->upload(m_allocation, data, size);
+		return;
+	}
+	if (GLState::get().hasDirectStateAccess()) {
+		GLCall(glNamedBufferData(m_rendererID, size, nullptr, GL_STREAM_DRAW));
+		GLCall(glNamedBufferSubData(m_rendererID, 0, size, data));
+		return;
+	}
+	bind();
+	GLCall(glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW));
+	GLCall(glBufferSubData(GL_ARRAY_BUFFER, 0, size, data));
 }
@@ -1,14 +1,26 @@
 #pragma once
+#include "bufferarena.h"
 
+// Either owns a buffer object, or is a range of a BufferArena shared with
+// other meshes. The latter binds the arena's buffer, and its vertices start
+// at GetBaseVertex() when the arena's unit size is the vertex stride.
 class VertexBuffer {
   private:
 	// The id of the vbo, we're calling it renderer id to keep it generic with
 	// other graphics APIs
 	unsigned int m_rendererID;
+	BufferArena *m_arena = nullptr;
+	BufferArena::Handle m_allocation = BufferArena::kInvalid;
 	bool moved = false;
 
+	void release();
+
   public:
+	// Leaves the buffer bound to GL_ARRAY_BUFFER, unless it's created with
+	// direct state access (see GLState::setDirectStateAccess())
 	VertexBuffer(const void *data, unsigned int size);
+	// Allocates size bytes in arena, which has to have room for them
+	VertexBuffer(BufferArena &arena, const void *data, unsigned int size);
 
 	VertexBuffer(const VertexBuffer &other) = delete;
 	VertexBuffer(VertexBuffer &&other);
@@ -20,4 +32,26 @@ class VertexBuffer {
 
 	void bind() const;
 	void unbind() const;
-};
\ No newline at end of file
+
+	// Replaces the contents with data that changes every frame. The old
+	// storage is orphaned, so this doesn't wait for draws still reading it.
+	// In an arena the range is overwritten in place and size can't grow.
+	void setData(const void *data, unsigned int size);
+
+	[[nodiscard]] inline unsigned int GetRendererID() const {
+		return m_rendererID;
+	};
+	// Bytes from the start of the buffer, 0 unless it's in an arena
+	[[nodiscard]] inline std::size_t GetOffset() const {
+		return m_arena ? m_arena->GetOffset(m_allocation) : 0;
+	};
+	// The offset in units of the arena, 0 unless it's in an arena
+	[[nodiscard]] inline int GetBaseVertex() const {
+		return m_arena ? static_cast<int>(m_arena->GetFirstElement(
+							 m_allocation))
+					   : 0;
+	};
+	[[nodiscard]] inline const BufferArena *GetArena() const {
+		return m_arena;
+	};
+};
@@ -0,0 +1,135 @@
+#pragma once
+#include <glbinding/gl/gl.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// The GL type enum of a C++ attribute component type
+template <typename T> struct GLTypeOf;
+template <> struct GLTypeOf<float> {
+	static constexpr gl::GLenum value = gl::GLenum::GL_FLOAT;
+};
+template <> struct GLTypeOf<std::int8_t> {
+	static constexpr gl::GLenum value = gl::GLenum::GL_BYTE;
+};
+template <> struct GLTypeOf<std::uint8_t> {
+	static constexpr gl::GLenum value = gl::GLenum::GL_UNSIGNED_BYTE;
+};
+template <> struct GLTypeOf<std::int16_t> {
+	static constexpr gl::GLenum value = gl::GLenum::GL_SHORT;
+};
+template <> struct GLTypeOf<std::uint16_t> {
+	static constexpr gl::GLenum value = gl::GLenum::GL_UNSIGNED_SHORT;
+};
+template <> struct GLTypeOf<std::int32_t> {
+	static constexpr gl::GLenum value = gl::GLenum::GL_INT;
+};
+template <> struct GLTypeOf<std::uint32_t> {
+	static constexpr gl::GLenum value = gl::GLenum::GL_UNSIGNED_INT;
+};
+
+// One vertex attribute made of Count components of type T, i.e. a member
+// declared as T[Count], std::array<T, Count> or an equivalent vector type.
+// Integers that aren't Normalized reach the shader as ints (glVertexAttribI*),
+// Normalized ones as floats in [0, 1] or [-1, 1].
+template <typename T, unsigned int Count, bool Normalized = false> struct Attr {
+	static_assert(Count >= 1 && Count <= 4,
+				  "GL attributes have 1 to 4 components");
+	static_assert(!Normalized || std::is_integral_v<T>,
+				  "Only integers can be normalized");
+
+	using Type = T;
+	static constexpr unsigned int count = Count;
+	static constexpr bool normalized = Normalized;
+	static constexpr bool integer = std::is_integral_v<T> && !Normalized;
+	static constexpr gl::GLenum glType = GLTypeOf<T>::value;
+	static constexpr std::size_t size = sizeof(T) * Count;
+	static constexpr std::size_t alignment = alignof(T);
+};
+
+// What the VertexArray needs to know about a single attribute
+struct VertexAttribute {
+	unsigned int count;
+	gl::GLenum type;
+	bool normalized;
+	bool integer;
+	// From the start of the vertex for interleaved buffers
+	std::size_t offset;
+	// Tightly packed size, the stride when the attribute has its own buffer
+	std::size_t size;
+};
+
+// Describes a vertex as a list of Attrs, computing the offsets and stride at
+// compile time. Members are placed the way the compiler lays out a struct
+// with the same members in the same order, so a layout can be checked
+// against the vertex struct it describes by passing the members' offsets:
+//
+//   struct Vertex {
+//       std::array<float, 3> position;
+//       std::array<std::uint8_t, 4> color;
+//   };
+//   using Layout = VertexLayout<Attr<float, 3>, Attr<std::uint8_t, 4, true>>;
+//   static_assert(Layout::matches<Vertex>(
+//       {offsetof(Vertex, position), offsetof(Vertex, color)}));
+template <typename... Attrs> struct VertexLayout {
+	static_assert(sizeof...(Attrs) > 0, "A vertex needs an attribute");
+	static constexpr std::size_t attributeCount = sizeof...(Attrs);
+
+  private:
+	static constexpr std::size_t alignUp(std::size_t value,
+										 std::size_t alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	static constexpr std::array<VertexAttribute, attributeCount> compute() {
+		std::array<VertexAttribute, attributeCount> attributes{
+			VertexAttribute{Attrs::count, Attrs::glType, Attrs::normalized,
+							Attrs::integer, 0, Attrs::size}...};
+		constexpr std::array<std::size_t, attributeCount> alignments{
+			Attrs::alignment...};
+		std::size_t offset = 0;
+		for (std::size_t i = 0; i < attributeCount; i++) {
+			offset = alignUp(offset, alignments[i]);
+			attributes[i].offset = offset;
+			offset += attributes[i].size;
+		}
+		return attributes;
+	}
+
+	static constexpr std::size_t maxAlignment() {
+		std::size_t alignment = 1;
+		((alignment = Attrs::alignment > alignment ? Attrs::alignment
+												   : alignment),
+		 ...);
+		return alignment;
+	}
+
+  public:
+	static constexpr std::array<VertexAttribute, attributeCount> attributes =
+		compute();
+	// Size of an interleaved vertex, including any trailing padding
+	static constexpr std::size_t stride =
+		alignUp(attributes.back().offset + attributes.back().size,
+				maxAlignment());
+
+	// Only compares the size, so it can't tell members apart that are in a
+	// different order or of a different type with the same size
+	template <typename Vertex> static constexpr bool matches() {
+		return sizeof(Vertex) == stride && std::is_standard_layout_v<Vertex>;
+	}
+	// Also compares each attribute's offset with the one of the member it
+	// describes, given in attribute order
+	template <typename Vertex>
+	static constexpr bool
+	matches(const std::array<std::size_t, attributeCount> &offsets) {
+		if (!matches<Vertex>())
+			return false;
+		for (std::size_t i = 0; i < attributeCount; i++) {
+			if (attributes[i].offset != offsets[i])
+				return false;
+		}
+		return true;
+	}
+};
@@ -0,0 +1,137 @@
+// clang-format off
+#include <glbinding/gl/gl.h>
+#define GLFW_INCLUDE_NONE
+#include "pr_glfw.h"
+// clang-format on
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "batchrenderer.h"
+#include "benchcontext.h"
+#include "benchmark.h"
+#include "renderer.h"
+
+// Stress test for the BatchRenderer: a few hundred thousand small quads
+// bouncing around, a third of them flat colored and the rest using one of a
+// handful of textures.
+//
+// Options (on top of the usual ones):
+//   --quads=N     quads per frame (default 200000)
+//   --batch=N     quads per batch (default 65536), 1 is a draw per quad
+//   --textures=N  distinct textures (default 8)
+
+using namespace gl;
+
+constexpr int kWidth = 1280;
+constexpr int kHeight = 720;
+
+struct Particle {
+	std::array<float, 2> position;
+	std::array<float, 2> velocity;
+	std::array<float, 4> color;
+	unsigned int texture;
+};
+
+// Column major, maps [0, width] x [0, height] to clip space
+static std::array<float, 16> Ortho(float width, float height) {
+	return {2.0f / width, 0.0f, 0.0f, 0.0f, 0.0f, 2.0f / height, 0.0f, 0.0f,
+			0.0f,		  0.0f, -1.0f, 0.0f, -1.0f, -1.0f, 0.0f, 1.0f};
+}
+
+// Checkerboards in different colors
+static std::vector<unsigned int> CreateTextures(unsigned long count) {
+	std::vector<unsigned int> textures(count);
+	GLCall(glGenTextures(static_cast<GLsizei>(count), textures.data()));
+	std::vector<std::uint32_t> pixels(16 * 16);
+	for (unsigned long i = 0; i < count; i++) {
+		auto tint = static_cast<std::uint32_t>(0xff000000U |
+											   (0x3f9fdfU * (i + 1)));
+		for (std::uint32_t p = 0; p < pixels.size(); p++)
+			pixels[p] = ((p % 16) / 4 + p / 64) % 2 ? tint : 0xffffffffU;
+		GLState::get().bindTexture(0, GL_TEXTURE_2D, textures[i]);
+		GLCall(glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(GL_RGBA8), 16,
+							16, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+							   static_cast<GLint>(GL_NEAREST)));
+		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
+							   static_cast<GLint>(GL_NEAREST)));
+	}
+	return textures;
+}
+
+int main(int argc, char **argv) {
+	FrameBenchmark bench(argc, argv);
+	unsigned long quadCount = GetArgValue(argc, argv, "--quads=", 200000);
+	auto batchSize =
+		static_cast<unsigned int>(GetArgValue(argc, argv, "--batch=", 65536));
+	unsigned long textureCount = GetArgValue(argc, argv, "--textures=", 8);
+
+	BenchContext context(argc, argv, bench, "Bench-Batch", 3, 3, kWidth,
+						 kHeight);
+	if (!context.isValid())
+		return -1;
+	GLFWObjects::Window &window = context.getWindow();
+
+	BatchRenderer batch(batchSize);
+	if (!batch.isValid())
+		return -1;
+	std::vector<unsigned int> textures = CreateTextures(textureCount);
+
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<Particle> particles(quadCount);
+	for (Particle &particle : particles) {
+		particle.position = {unit(rng) * kWidth, unit(rng) * kHeight};
+		particle.velocity = {unit(rng) * 4.0f - 2.0f, unit(rng) * 4.0f - 2.0f};
+		particle.color = {unit(rng), unit(rng), unit(rng), 1.0f};
+		auto pick = static_cast<size_t>(unit(rng) * 1.5f *
+										static_cast<float>(textureCount));
+		particle.texture = pick < textures.size() ? textures[pick] : 0;
+	}
+
+	GLState &state = GLState::get();
+	state.setBlend(true);
+	state.setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	std::array<float, 16> viewProjection = Ortho(kWidth, kHeight);
+
+	while (!window.shouldClose() && !bench.isDone()) {
+		GLCall(glClear(GL_COLOR_BUFFER_BIT));
+
+		batch.resetStats();
+		batch.begin(viewProjection);
+		for (Particle &particle : particles) {
+			for (size_t axis = 0; axis < 2; axis++) {
+				float limit = static_cast<float>(axis == 0 ? kWidth : kHeight);
+				particle.position[axis] += particle.velocity[axis];
+				if (particle.position[axis] < 0.0f ||
+					particle.position[axis] > limit)
+					particle.velocity[axis] = -particle.velocity[axis];
+			}
+			batch.drawQuad(particle.position, {4.0f, 4.0f}, particle.color,
+						   particle.texture);
+		}
+		batch.end();
+
+		window.swapBuffers();
+		bench.endFrame();
+		state.endFrame();
+		glfwPollEvents();
+	}
+
+	bench.report(std::cout);
+	const BatchRenderer::Stats &stats = batch.getStats();
+	std::cout << "{\"quads\": " << stats.quads
+			  << ", \"draw_calls\": " << stats.drawCalls
+			  << ", \"texture_flushes\": " << stats.textureFlushes
+			  << ", \"batch_size\": " << batchSize << "}" << std::endl;
+
+	for (unsigned int texture : textures)
+		state.onTextureDeleted(texture);
+	GLCall(glDeleteTextures(static_cast<GLsizei>(textures.size()),
+							textures.data()));
+	return 0;
+}
@@ -0,0 +1,237 @@
+// clang-format off
+#include <glbinding/gl/gl.h>
+#define GLFW_INCLUDE_NONE
+#include "pr_glfw.h"
+// clang-format on
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "benchcontext.h"
+#include "benchmark.h"
+#include "bufferarena.h"
+#include "deletionqueue.h"
+#include "indexbuffer.h"
+#include "renderer.h"
+#include "shader.h"
+#include "shadercompiler.h"
+#include "shadersource.h"
+#include "vertexarray.h"
+#include "vertexbuffer.h"
+#include "vertexlayout.h"
+
+// Thousands of small polygons, each with its own vertices and indices. With
+// --mode=arena they're all suballocated from one vertex and one index
+// BufferArena and drawn through a single VAO with base vertices, with
+// --mode=separate every mesh has its own buffers and VAO. Every frame some
+// meshes are replaced by ones of a different size, which fragments the
+// arenas until they get defragmented. In separate mode the replaced meshes'
+// buffers go through the DeletionQueue.
+//
+// Options (on top of the usual ones):
+//   --mode=arena|separate  how the meshes are stored (default arena)
+//   --meshes=N             meshes in the scene (default 5000)
+//   --churn=N              meshes replaced per frame (default 50)
+//   --defrag=P             defragment once P percent of the free space is
+//                          split off from the largest free range (default 50)
+
+using namespace gl;
+
+constexpr unsigned int kMaxSides = 64;
+using Layout = VertexLayout<Attr<float, 2>>;
+
+struct Mesh {
+	std::optional<VertexBuffer> vertices;
+	std::optional<IndexBuffer> indices;
+	// Only with --mode=separate
+	std::optional<VertexArray> vertexArray;
+	std::array<float, 2> offset;
+	float scale;
+	std::array<float, 4> color;
+};
+
+// A regular polygon as a triangle fan around its center
+static void CreateMesh(Mesh &mesh, unsigned int sides, BufferArena *vertexArena,
+					   BufferArena *indexArena) {
+	std::vector<float> positions{0.0f, 0.0f};
+	std::vector<std::uint16_t> indices;
+	for (unsigned int side = 0; side < sides; side++) {
+		float angle =
+			6.2831853f * static_cast<float>(side) / static_cast<float>(sides);
+		positions.insert(positions.end(), {std::cos(angle), std::sin(angle)});
+		indices.insert(indices.end(),
+					   {0, static_cast<std::uint16_t>(side + 1),
+						static_cast<std::uint16_t>((side + 1) % sides + 1)});
+	}
+	auto size = static_cast<unsigned int>(positions.size() * sizeof(float));
+
+	// Release the old ones first, so their ranges can be reused
+	mesh.vertexArray.reset();
+	mesh.indices.reset();
+	mesh.vertices.reset();
+	if (vertexArena) {
+		mesh.vertices.emplace(*vertexArena, positions.data(), size);
+		mesh.indices.emplace(*indexArena, indices, sides + 1);
+	} else {
+		mesh.vertices.emplace(positions.data(), size);
+		mesh.indices.emplace(indices, sides + 1);
+		mesh.vertexArray.emplace();
+		mesh.vertexArray->addBuffer<Layout>(*mesh.vertices);
+		mesh.vertexArray->setIndexBuffer(*mesh.indices);
+	}
+}
+
+int main(int argc, char **argv) {
+	FrameBenchmark bench(argc, argv);
+	bool useArena =
+		GetArgString(argc, argv, "--mode=", "arena") != "separate";
+	unsigned long meshCount = GetArgValue(argc, argv, "--meshes=", 5000);
+	unsigned long churn = GetArgValue(argc, argv, "--churn=", 50);
+	double defragThreshold =
+		static_cast<double>(GetArgValue(argc, argv, "--defrag=", 50)) / 100.0;
+
+	BenchContext context(argc, argv, bench, "Bench-BufferArena");
+	if (!context.isValid())
+		return -1;
+	GLFWObjects::Window &window = context.getWindow();
+
+	ShaderLibrary shaderLibrary;
+	std::optional<ShaderSource> source =
+		shaderLibrary.parse("res/shaders/Instanced.shader");
+	if (!source)
+		return -1;
+	Shader shader(CreateProgram(source->str(ShaderStage::VERTEX),
+								source->str(ShaderStage::FRAGMENT)));
+	if (shader.GetRendererID() == 0)
+		return -1;
+
+	// Twice what the biggest meshes would need, so there's room to churn
+	std::size_t vertexBytes =
+		meshCount * (kMaxSides + 1) * Layout::stride * 2;
+	std::size_t indexBytes =
+		meshCount * kMaxSides * 3 * sizeof(std::uint16_t) * 2;
+	std::optional<BufferArena> vertexArena;
+	std::optional<BufferArena> indexArena;
+	VertexArray arenaVertexArray;
+	if (useArena) {
+		vertexArena.emplace(vertexBytes, Layout::stride);
+		indexArena.emplace(indexBytes, sizeof(std::uint16_t));
+		arenaVertexArray.addBuffer<Layout>(*vertexArena);
+		arenaVertexArray.setIndexBuffer(*indexArena);
+	}
+
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	auto randomSides = [&]() {
+		return 3 + static_cast<unsigned int>(rng() % (kMaxSides - 2));
+	};
+	std::vector<Mesh> meshes(meshCount);
+	for (Mesh &mesh : meshes) {
+		CreateMesh(mesh, randomSides(), useArena ? &*vertexArena : nullptr,
+				   useArena ? &*indexArena : nullptr);
+		mesh.offset = {unit(rng) * 2.0f - 1.0f, unit(rng) * 2.0f - 1.0f};
+		mesh.scale = 0.005f + unit(rng) * 0.02f;
+		mesh.color = {unit(rng), unit(rng), unit(rng), 1.0f};
+	}
+
+	GLState &state = GLState::get();
+	shader.bind();
+
+	using Clock = std::chrono::steady_clock;
+	Clock::duration churnTime{};
+	Clock::duration submitTime{};
+	Clock::duration defragTime{};
+	unsigned long frames = 0;
+	double fragmentation = 0.0;
+	while (!window.shouldClose() && !bench.isDone()) {
+		GLCall(glClear(GL_COLOR_BUFFER_BIT));
+
+		Clock::time_point churnStart = Clock::now();
+		for (unsigned long i = 0; i < churn && !meshes.empty(); i++) {
+			CreateMesh(meshes[rng() % meshes.size()], randomSides(),
+					   useArena ? &*vertexArena : nullptr,
+					   useArena ? &*indexArena : nullptr);
+		}
+		churnTime += Clock::now() - churnStart;
+		if (useArena) {
+			Clock::time_point start = Clock::now();
+			for (BufferArena *arena : {&*vertexArena, &*indexArena}) {
+				double arenaFragmentation = arena->getStats().fragmentation;
+				fragmentation += arenaFragmentation;
+				if (arenaFragmentation > defragThreshold)
+					arena->defragment();
+			}
+			defragTime += Clock::now() - start;
+		}
+
+		Clock::time_point start = Clock::now();
+		for (const Mesh &mesh : meshes) {
+			shader.setUniform("u_Offset", mesh.offset[0], mesh.offset[1]);
+			shader.setUniform("u_Scale", mesh.scale);
+			shader.setUniform("u_Color", mesh.color[0], mesh.color[1],
+							  mesh.color[2], mesh.color[3]);
+			if (useArena)
+				arenaVertexArray.draw(*mesh.indices,
+									  mesh.vertices->GetBaseVertex());
+			else
+				mesh.vertexArray->draw(*mesh.indices);
+		}
+		submitTime += Clock::now() - start;
+		frames++;
+
+		window.swapBuffers();
+		bench.endFrame();
+		state.endFrame();
+		glfwPollEvents();
+	}
+
+	bench.report(std::cout);
+	double frameCount = std::max(static_cast<double>(frames), 1.0);
+	std::chrono::duration<double, std::micro> churnUs = churnTime;
+	std::chrono::duration<double, std::micro> submitUs = submitTime;
+	std::chrono::duration<double, std::micro> defragUs = defragTime;
+	std::cout << "{\"mode\": \"" << (useArena ? "arena" : "separate")
+			  << "\", \"meshes\": " << meshCount << ", \"churn\": " << churn
+			  << ", \"buffer_objects\": " << (useArena ? 2 : meshCount * 2)
+			  << ", \"churn_us\": " << churnUs.count() / frameCount
+			  << ", \"submit_us\": " << submitUs.count() / frameCount
+			  << ", \"state_changes_per_frame\": "
+			  << static_cast<double>(state.getTotalStats().issued) /
+					 frameCount;
+	if (useArena) {
+		BufferArena::Stats vertexStats = vertexArena->getStats();
+		BufferArena::Stats indexStats = indexArena->getStats();
+		auto occupancy = [](const BufferArena::Stats &stats) {
+			return static_cast<double>(stats.used) /
+				   static_cast<double>(std::max<std::size_t>(stats.capacity,
+															 1));
+		};
+		std::cout << ", \"vertex_occupancy\": " << occupancy(vertexStats)
+				  << ", \"index_occupancy\": " << occupancy(indexStats)
+				  << ", \"mean_fragmentation\": "
+				  << fragmentation / (2.0 * frameCount)
+				  << ", \"free_ranges\": "
+				  << vertexStats.freeRanges + indexStats.freeRanges
+				  << ", \"defragmentations\": "
+				  << vertexStats.defragmentations +
+						 indexStats.defragmentations
+				  << ", \"bytes_moved\": "
+				  << vertexStats.bytesMoved + indexStats.bytesMoved
+				  << ", \"defrag_us\": " << defragUs.count() / frameCount;
+	}
+	DeletionQueue::Stats deletions = DeletionQueue::get().getStats();
+	std::cout << ", \"buffers_deleted\": " << deletions.deleted
+			  << ", \"deletion_batches\": " << deletions.batches
+			  << ", \"deletions_pending\": "
+			  << DeletionQueue::get().GetPendingCount() << "}" << std::endl;
+
+	// The meshes give their ranges back to the arenas, which go after them
+	meshes.clear();
+	return 0;
+}
@@ -0,0 +1,225 @@
+// clang-format off
+#include <glbinding/gl/gl.h>
+#define GLFW_INCLUDE_NONE
+#include "pr_glfw.h"
+// clang-format on
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchcontext.h"
+#include "benchmark.h"
+#include "commandlist.h"
+#include "indexbuffer.h"
+#include "jobsystem.h"
+#include "renderer.h"
+#include "shader.h"
+#include "shadercompiler.h"
+#include "shadersource.h"
+#include "vertexarray.h"
+#include "vertexbuffer.h"
+#include "vertexlayout.h"
+
+// Walks a scene of orbiting polygons on a JobSystem, every job recording the
+// draws of its slice into its own CommandList, and replays the lists on the
+// main thread in slice order.
+//
+// Options (on top of the usual ones):
+//   --threads=N  threads recording, the main one included (default: one per
+//                core)
+//   --draws=N    objects in the scene (default 50000)
+
+using namespace gl;
+
+constexpr unsigned int kPrograms = 4;
+constexpr unsigned int kMeshes = 4;
+constexpr unsigned int kTextures = 4;
+
+struct Object {
+	unsigned int program;
+	unsigned int mesh;
+	unsigned int texture;
+	std::array<float, 2> center;
+	float radius;
+	float phase;
+	float scale;
+};
+
+// Checkerboards in different colors
+static std::vector<unsigned int> CreateTextures(unsigned long count) {
+	std::vector<unsigned int> textures(count);
+	GLCall(glGenTextures(static_cast<GLsizei>(count), textures.data()));
+	std::vector<std::uint32_t> pixels(8 * 8);
+	for (unsigned long i = 0; i < count; i++) {
+		auto tint = static_cast<std::uint32_t>(0xff000000U |
+											   (0x3f9fdfU * (i + 1)));
+		for (std::uint32_t p = 0; p < pixels.size(); p++)
+			pixels[p] = (p % 8 / 2 + p / 16) % 2 ? tint : 0xffffffffU;
+		GLState::get().bindTexture(0, GL_TEXTURE_2D, textures[i]);
+		GLCall(glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(GL_RGBA8), 8,
+							8, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+							   static_cast<GLint>(GL_NEAREST)));
+		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
+							   static_cast<GLint>(GL_NEAREST)));
+	}
+	return textures;
+}
+
+int main(int argc, char **argv) {
+	FrameBenchmark bench(argc, argv);
+	unsigned long threadCount = std::max(
+		GetArgValue(argc, argv, "--threads=",
+					std::max(std::thread::hardware_concurrency(), 1U)),
+		1UL);
+	unsigned long drawCount = GetArgValue(argc, argv, "--draws=", 50000);
+
+	BenchContext context(argc, argv, bench, "Bench-CommandLists");
+	if (!context.isValid())
+		return -1;
+	GLFWObjects::Window &window = context.getWindow();
+
+	ShaderLibrary shaderLibrary;
+	std::optional<ShaderSource> source =
+		shaderLibrary.parse("res/shaders/Queue.shader");
+	if (!source)
+		return -1;
+	std::vector<Shader> shaders;
+	for (unsigned int i = 0; i < kPrograms; i++) {
+		shaders.emplace_back(CreateProgram(
+			source->str(ShaderStage::VERTEX),
+			ApplyDefines(source->str(ShaderStage::FRAGMENT),
+						 {"VARIANT " + std::to_string(i)})));
+		if (shaders.back().GetRendererID() == 0)
+			return -1;
+	}
+
+	// Regular polygons with 3, 4, 5... sides, each in its own VAO
+	std::vector<VertexArray> vertexArrays(kMeshes);
+	std::vector<VertexBuffer> vertexBuffers;
+	std::vector<IndexBuffer> indexBuffers;
+	vertexBuffers.reserve(kMeshes);
+	indexBuffers.reserve(kMeshes);
+	for (unsigned int mesh = 0; mesh < kMeshes; mesh++) {
+		unsigned int sides = mesh + 3;
+		std::vector<float> positions{0.0f, 0.0f};
+		std::vector<std::uint32_t> indices;
+		for (unsigned int side = 0; side < sides; side++) {
+			float angle = 6.2831853f * static_cast<float>(side) /
+						  static_cast<float>(sides);
+			positions.insert(positions.end(),
+							 {std::cos(angle), std::sin(angle)});
+			indices.insert(indices.end(),
+						   {0, side + 1, (side + 1) % sides + 1});
+		}
+		vertexBuffers.emplace_back(
+			positions.data(),
+			static_cast<unsigned int>(positions.size() * sizeof(float)));
+		indexBuffers.emplace_back(indices, sides + 1);
+		vertexArrays[mesh].addBuffer<VertexLayout<Attr<float, 2>>>(
+			vertexBuffers[mesh]);
+		vertexArrays[mesh].setIndexBuffer(indexBuffers[mesh]);
+	}
+	std::vector<unsigned int> textures = CreateTextures(kTextures);
+
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<Object> scene(drawCount);
+	for (Object &object : scene) {
+		object.program = static_cast<unsigned int>(rng() % kPrograms);
+		object.mesh = static_cast<unsigned int>(rng() % kMeshes);
+		object.texture = static_cast<unsigned int>(rng() % kTextures);
+		object.center = {unit(rng) * 2.0f - 1.0f, unit(rng) * 2.0f - 1.0f};
+		object.radius = unit(rng) * 0.1f;
+		object.phase = unit(rng) * 6.28f;
+		object.scale = 0.005f + unit(rng) * 0.02f;
+	}
+
+	// One list per slice of the scene, always replayed in slice order
+	std::vector<CommandList> lists(threadCount);
+	auto record = [&](unsigned long slice, float time) {
+		CommandList &list = lists[slice];
+		list.reset();
+		size_t begin = scene.size() * slice / threadCount;
+		size_t end = scene.size() * (slice + 1) / threadCount;
+		for (size_t i = begin; i < end; i++) {
+			const Object &object = scene[i];
+			const IndexBuffer &indexBuffer = indexBuffers[object.mesh];
+			float angle = time + object.phase;
+			list.bindProgram(shaders[object.program]);
+			list.bindVertexArray(vertexArrays[object.mesh].GetRendererID());
+			list.bindTexture(0, textures[object.texture]);
+			list.setUniform(
+				"u_Transform",
+				object.center[0] + std::cos(angle) * object.radius,
+				object.center[1] + std::sin(angle) * object.radius,
+				object.scale,
+				static_cast<float>(i) / static_cast<float>(scene.size()));
+			list.drawIndexed(indexBuffer.GetType(), indexBuffer.GetCount(),
+							 0, 0, indexBuffer.HasPrimitiveRestart());
+		}
+	};
+
+	GLState &state = GLState::get();
+	state.setDepthTest(true);
+
+	using Clock = std::chrono::steady_clock;
+	Clock::duration recordTime{};
+	Clock::duration executeTime{};
+	unsigned long frames = 0;
+	JobSystem jobs(static_cast<unsigned int>(threadCount - 1));
+	while (!window.shouldClose() && !bench.isDone()) {
+		GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+		float time = static_cast<float>(frames) * 0.01f;
+
+		Clock::time_point start = Clock::now();
+		// The main thread records slices too while it waits
+		jobs.parallelFor(threadCount, 1, [&](size_t begin, size_t) {
+			record(begin, time);
+		});
+		Clock::time_point recorded = Clock::now();
+
+		for (const CommandList &list : lists)
+			list.execute();
+		executeTime += Clock::now() - recorded;
+		recordTime += recorded - start;
+		frames++;
+
+		window.swapBuffers();
+		bench.endFrame();
+		state.endFrame();
+		glfwPollEvents();
+	}
+
+	bench.report(std::cout);
+	size_t commands = 0;
+	size_t bytes = 0;
+	for (const CommandList &list : lists) {
+		commands += list.GetCount();
+		bytes += list.GetBytesUsed();
+	}
+	std::chrono::duration<double, std::milli> recordMs = recordTime;
+	std::chrono::duration<double, std::milli> executeMs = executeTime;
+	double frameCount = std::max(static_cast<double>(frames), 1.0);
+	std::cout << "{\"threads\": " << threadCount
+			  << ", \"draws\": " << drawCount
+			  << ", \"commands_per_frame\": " << commands
+			  << ", \"command_bytes_per_frame\": " << bytes
+			  << ", \"record_ms\": " << recordMs.count() / frameCount
+			  << ", \"execute_ms\": " << executeMs.count() / frameCount << "}"
+			  << std::endl;
+
+	for (unsigned int texture : textures)
+		state.onTextureDeleted(texture);
+	GLCall(glDeleteTextures(static_cast<GLsizei>(textures.size()),
+							textures.data()));
+	return 0;
+}
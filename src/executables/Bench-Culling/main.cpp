@@ -0,0 +1,210 @@
+// clang-format off
+#include <glbinding/gl/gl.h>
+#define GLFW_INCLUDE_NONE
+#include "pr_glfw.h"
+// clang-format on
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "benchcontext.h"
+#include "benchmark.h"
+#include "frustumculler.h"
+#include "indexbuffer.h"
+#include "jobsystem.h"
+#include "renderer.h"
+#include "shader.h"
+#include "shadercompiler.h"
+#include "shadersource.h"
+#include "vertexarray.h"
+#include "vertexbuffer.h"
+#include "vertexlayout.h"
+
+// A field of boxes around a camera that turns in place, so only a part of
+// them is in view at any time. They're culled against the frustum either by
+// the FrustumCuller's compute shader or on the CPU, and drawn with one
+// multi-draw indirect call either way.
+//
+// Options (on top of the usual ones):
+//   --mode=gpu|cpu  where the culling happens (default gpu)
+//   --objects=N     boxes in the scene (default 100000)
+//   --threads=N     threads culling in cpu mode, the main one included
+//                   (default 1)
+
+using namespace gl;
+
+constexpr int kWidth = 640;
+constexpr int kHeight = 480;
+constexpr float kFieldSize = 200.0f;
+
+using Matrix = std::array<float, 16>;
+
+// Column major, like GLSL
+static Matrix Multiply(const Matrix &a, const Matrix &b) {
+	Matrix result{};
+	for (size_t column = 0; column < 4; column++) {
+		for (size_t row = 0; row < 4; row++) {
+			float sum = 0.0f;
+			for (size_t k = 0; k < 4; k++)
+				sum += a[k * 4 + row] * b[column * 4 + k];
+			result[column * 4 + row] = sum;
+		}
+	}
+	return result;
+}
+
+static Matrix Perspective(float fovY, float aspect, float near, float far) {
+	float f = 1.0f / std::tan(fovY / 2.0f);
+	Matrix result{};
+	result[0] = f / aspect;
+	result[5] = f;
+	result[10] = (far + near) / (near - far);
+	result[11] = -1.0f;
+	result[14] = 2.0f * far * near / (near - far);
+	return result;
+}
+
+// A camera at the origin looking along the xz plane at angle yaw
+static Matrix View(float yaw) {
+	float c = std::cos(yaw);
+	float s = std::sin(yaw);
+	// The inverse of a rotation around y
+	return {c, 0.0f, s, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
+			-s, 0.0f, c, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+}
+
+static std::vector<CullObject> CreateObjects(unsigned long count,
+											 unsigned int indexCount) {
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> position(-kFieldSize, kFieldSize);
+	std::uniform_real_distribution<float> size(0.2f, 1.5f);
+	std::vector<CullObject> objects(count);
+	for (CullObject &object : objects) {
+		object.center = {position(rng), position(rng) * 0.25f, position(rng)};
+		object.halfExtents = {size(rng), size(rng), size(rng)};
+		const std::array<float, 3> &extents = object.halfExtents;
+		object.radius = std::sqrt(extents[0] * extents[0] +
+								  extents[1] * extents[1] +
+								  extents[2] * extents[2]);
+		object.indexCount = indexCount;
+		object.firstIndex = 0;
+		object.baseVertex = 0;
+		object.padding = {0, 0};
+	}
+	return objects;
+}
+
+int main(int argc, char **argv) {
+	FrameBenchmark bench(argc, argv);
+	bool gpu = GetArgString(argc, argv, "--mode=", "gpu") != "cpu";
+	unsigned long objectCount = GetArgValue(argc, argv, "--objects=", 100000);
+	unsigned long threadCount =
+		std::max(GetArgValue(argc, argv, "--threads=", 1), 1UL);
+
+	// Compute shaders are core since 4.3, llvmpipe has 4.5
+	BenchContext context(argc, argv, bench, "Bench-Culling", 4, 3,
+						 kWidth, kHeight);
+	if (!context.isValid())
+		return -1;
+	GLFWObjects::Window &window = context.getWindow();
+
+	if (!FrustumCuller::isSupported()) {
+		std::cerr << "Compute shaders or multi-draw indirect aren't supported"
+				  << std::endl;
+		return -1;
+	}
+
+	ShaderLibrary shaderLibrary;
+	std::optional<ShaderSource> source =
+		shaderLibrary.parse("res/shaders/Culled.shader");
+	if (!source)
+		return -1;
+	Shader shader(CreateProgram(source->str(ShaderStage::VERTEX),
+								source->str(ShaderStage::FRAGMENT)));
+	if (shader.GetRendererID() == 0)
+		return -1;
+
+	// A unit cube
+	std::array<float, 24> cube{-1.0f, -1.0f, -1.0f, 1.0f,  -1.0f, -1.0f,
+							   1.0f,  1.0f,	 -1.0f, -1.0f, 1.0f,  -1.0f,
+							   -1.0f, -1.0f, 1.0f,	1.0f,  -1.0f, 1.0f,
+							   1.0f,  1.0f,	 1.0f,	-1.0f, 1.0f,  1.0f};
+	std::array<std::uint8_t, 36> cubeIndices{
+		0, 2, 1, 2, 0, 3, 4, 5, 6, 6, 7, 4, 0, 1, 5, 5, 4, 0,
+		3, 6, 2, 6, 3, 7, 0, 4, 7, 7, 3, 0, 1, 2, 6, 6, 5, 1};
+
+	FrustumCuller culler(CreateObjects(
+		objectCount, static_cast<unsigned int>(cubeIndices.size())));
+	if (!culler.isValid())
+		return -1;
+
+	VertexArray va;
+	VertexBuffer vb(cube.data(), sizeof(cube));
+	va.addBuffer<VertexLayout<Attr<float, 3>>>(vb);
+	// Object IDs for drivers without gl_BaseInstance
+	std::vector<std::uint32_t> ids(objectCount);
+	std::iota(ids.begin(), ids.end(), 0U);
+	VertexBuffer idBuffer(ids.data(), static_cast<unsigned int>(
+										  ids.size() * sizeof(std::uint32_t)));
+	va.addInstanceBuffer<VertexLayout<Attr<std::uint32_t, 1>>>(idBuffer);
+	IndexBuffer ib(cubeIndices, 8);
+	va.setIndexBuffer(ib);
+
+	GLState &state = GLState::get();
+	state.setDepthTest(true);
+	Matrix projection = Perspective(1.0f, static_cast<float>(kWidth) / kHeight,
+									0.1f, kFieldSize * 1.5f);
+
+	JobSystem jobs(static_cast<unsigned int>(threadCount - 1));
+
+	using Clock = std::chrono::steady_clock;
+	Clock::duration cullTime{};
+	unsigned long frames = 0;
+	while (!window.shouldClose() && !bench.isDone()) {
+		GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+		Matrix viewProjection = Multiply(
+			projection, View(static_cast<float>(frames) * 0.005f));
+
+		// Everything the CPU does to get from the camera to the draws
+		Clock::time_point start = Clock::now();
+		if (gpu)
+			culler.cull(viewProjection);
+		else
+			culler.cullOnCPU(viewProjection,
+							 threadCount > 1 ? &jobs : nullptr);
+		shader.bind();
+		shader.setUniform("u_ViewProjection", viewProjection);
+		culler.draw(va, ib);
+		cullTime += Clock::now() - start;
+		frames++;
+
+		window.swapBuffers();
+		bench.endFrame();
+		state.endFrame();
+		glfwPollEvents();
+	}
+
+	bench.report(std::cout);
+	// Waits for the last frame's culling on the GPU
+	std::uint32_t visible = culler.readVisibleCount();
+	std::chrono::duration<double, std::micro> cullUs = cullTime;
+	std::cout << "{\"mode\": \"" << (gpu ? "gpu" : "cpu")
+			  << "\", \"objects\": " << objectCount
+			  << ", \"threads\": " << threadCount
+			  << ", \"visible\": " << visible
+			  << ", \"culled\": " << objectCount - visible
+			  << ", \"indirect_count\": "
+			  << (culler.HasIndirectCount() ? "true" : "false")
+			  << ", \"cpu_cull_submit_us\": "
+			  << (frames > 0 ? cullUs.count() / static_cast<double>(frames)
+							 : 0.0)
+			  << "}" << std::endl;
+	return 0;
+}
@@ -0,0 +1,156 @@
+// clang-format off
+#include <glbinding/gl/gl.h>
+#define GLFW_INCLUDE_NONE
+#include "pr_glfw.h"
+// clang-format on
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "benchcontext.h"
+#include "benchmark.h"
+#include "indexbuffer.h"
+#include "renderer.h"
+#include "shader.h"
+#include "shadercompiler.h"
+#include "shadersource.h"
+#include "vertexarray.h"
+#include "vertexbuffer.h"
+#include "vertexlayout.h"
+
+// Creates small polygons from scratch every frame, each with its own vertex
+// buffer, index buffer and VAO, draws them once and throws them away. That's
+// mostly buffer and VAO setup, which is bound to edit with --mode=bind and
+// done through the objects' names with --mode=dsa. Both draw the same way, so
+// the difference in state changes per frame is the binds DSA saves.
+//
+// Options (on top of the usual ones):
+//   --mode=dsa|bind  how the objects are set up (default dsa, falls back to
+//                    bind without GL 4.5 or ARB_direct_state_access)
+//   --meshes=N       meshes created per frame (default 1000)
+
+using namespace gl;
+
+struct Mesh {
+	VertexBuffer vertices;
+	IndexBuffer indices;
+	VertexArray vertexArray;
+	std::array<float, 4> transform;
+};
+
+// A regular polygon with sides sides as a triangle fan around its center
+static void CreatePolygon(unsigned int sides, std::vector<float> &positions,
+						  std::vector<std::uint16_t> &indices) {
+	positions.assign({0.0f, 0.0f});
+	indices.clear();
+	for (unsigned int side = 0; side < sides; side++) {
+		float angle =
+			6.2831853f * static_cast<float>(side) / static_cast<float>(sides);
+		positions.insert(positions.end(), {std::cos(angle), std::sin(angle)});
+		indices.insert(indices.end(),
+					   {0, static_cast<std::uint16_t>(side + 1),
+						static_cast<std::uint16_t>((side + 1) % sides + 1)});
+	}
+}
+
+int main(int argc, char **argv) {
+	FrameBenchmark bench(argc, argv);
+	bool dsa = GetArgString(argc, argv, "--mode=", "dsa") != "bind";
+	unsigned long meshCount = GetArgValue(argc, argv, "--meshes=", 1000);
+
+	BenchContext context(argc, argv, bench, "Bench-DSA");
+	if (!context.isValid())
+		return -1;
+	GLFWObjects::Window &window = context.getWindow();
+
+	GLState &state = GLState::get();
+	state.setDirectStateAccess(dsa);
+	if (dsa && !state.hasDirectStateAccess()) {
+		std::cerr << "Direct state access isn't supported, binding instead"
+				  << std::endl;
+		dsa = false;
+	}
+
+	ShaderLibrary shaderLibrary;
+	std::optional<ShaderSource> source =
+		shaderLibrary.parse("res/shaders/Queue.shader");
+	if (!source)
+		return -1;
+	Shader shader(CreateProgram(source->str(ShaderStage::VERTEX),
+								source->str(ShaderStage::FRAGMENT)));
+	if (shader.GetRendererID() == 0)
+		return -1;
+
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<Mesh> meshes;
+	meshes.reserve(meshCount);
+	std::vector<float> positions;
+	std::vector<std::uint16_t> indices;
+
+	using Clock = std::chrono::steady_clock;
+	Clock::duration createTime{};
+	unsigned long frames = 0;
+	unsigned long stateChanges = 0;
+	while (!window.shouldClose() && !bench.isDone()) {
+		GLCall(glClear(GL_COLOR_BUFFER_BIT));
+
+		Clock::time_point start = Clock::now();
+		for (unsigned long i = 0; i < meshCount; i++) {
+			CreatePolygon(3 + static_cast<unsigned int>(rng() % 30), positions,
+						  indices);
+			meshes.push_back(
+				{VertexBuffer(positions.data(),
+							  static_cast<unsigned int>(positions.size() *
+														sizeof(float))),
+				 IndexBuffer(indices,
+							 static_cast<unsigned int>(positions.size() / 2)),
+				 VertexArray(),
+				 {unit(rng) * 2.0f - 1.0f, unit(rng) * 2.0f - 1.0f,
+				  0.01f + unit(rng) * 0.03f, unit(rng)}});
+			Mesh &mesh = meshes.back();
+			mesh.vertexArray.addBuffer<VertexLayout<Attr<float, 2>>>(
+				mesh.vertices);
+			mesh.vertexArray.setIndexBuffer(mesh.indices);
+		}
+		createTime += Clock::now() - start;
+
+		shader.bind();
+		for (const Mesh &mesh : meshes) {
+			shader.setUniform("u_Transform", mesh.transform[0],
+							  mesh.transform[1], mesh.transform[2],
+							  mesh.transform[3]);
+			mesh.vertexArray.draw(mesh.indices);
+		}
+		// The buffers go to the DeletionQueue, the VAOs are deleted now
+		meshes.clear();
+		frames++;
+
+		window.swapBuffers();
+		bench.endFrame();
+		state.endFrame();
+		stateChanges += state.getLastFrameStats().issued;
+		glfwPollEvents();
+	}
+
+	bench.report(std::cout);
+	double frameCount = std::max(static_cast<double>(frames), 1.0);
+	std::chrono::duration<double, std::micro> createUs = createTime;
+	std::cout << "{\"mode\": \"" << (dsa ? "dsa" : "bind")
+			  << "\", \"meshes\": " << meshCount
+			  << ", \"state_changes_per_frame\": "
+			  << static_cast<double>(stateChanges) / frameCount
+			  << ", \"state_changes_per_mesh\": "
+			  << static_cast<double>(stateChanges) /
+					 (frameCount *
+					  static_cast<double>(std::max(meshCount, 1UL)))
+			  << ", \"create_us\": " << createUs.count() / frameCount << "}"
+			  << std::endl;
+	return 0;
+}
@@ -0,0 +1,164 @@
+#include "allocationcounter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<unsigned long> g_news{0};
+std::atomic<unsigned long> g_deletes{0};
+std::atomic<std::size_t> g_bytes{0};
+
+void *Allocate(std::size_t size) {
+	g_news.fetch_add(1, std::memory_order_relaxed);
+	g_bytes.fetch_add(size, std::memory_order_relaxed);
+	return std::malloc(size ? size : 1);
+}
+
+void *AllocateAligned(std::size_t size, std::align_val_t alignment) {
+	g_news.fetch_add(1, std::memory_order_relaxed);
+	g_bytes.fetch_add(size, std::memory_order_relaxed);
+	auto align = static_cast<std::size_t>(alignment);
+#ifdef _WIN32
+	return _aligned_malloc(size ? size : 1, align);
+#else
+	// aligned_alloc wants a non-zero multiple of the alignment, and may
+	// return null for 0 like malloc
+	size = std::max(size, align);
+	return std::aligned_alloc(align, (size + align - 1) / align * align);
+#endif
+}
+
+void Free(void *pointer) {
+	if (!pointer)
+		return;
+	g_deletes.fetch_add(1, std::memory_order_relaxed);
+	std::free(pointer);
+}
+
+void FreeAligned(void *pointer) {
+	if (!pointer)
+		return;
+	g_deletes.fetch_add(1, std::memory_order_relaxed);
+#ifdef _WIN32
+	_aligned_free(pointer);
+#else
+	std::free(pointer);
+#endif
+}
+
+void *AllocateOrThrow(std::size_t size) {
+	void *pointer = Allocate(size);
+	if (!pointer)
+		throw std::bad_alloc();
+	return pointer;
+}
+
+void *AllocateAlignedOrThrow(std::size_t size, std::align_val_t alignment) {
+	void *pointer = AllocateAligned(size, alignment);
+	if (!pointer)
+		throw std::bad_alloc();
+	return pointer;
+}
+
+} // namespace
+
+AllocationStats GetAllocationStats() {
+	return {g_news.load(std::memory_order_relaxed),
+			g_deletes.load(std::memory_order_relaxed),
+			g_bytes.load(std::memory_order_relaxed)};
+}
+
+// The replaceable allocation functions, all of them so that none falls back
+// to the library's version that bypasses the counters
+
+void *operator new(std::size_t size) {
+	return AllocateOrThrow(size);
+}
+
+void *operator new[](std::size_t size) {
+	return AllocateOrThrow(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t & /*tag*/) noexcept {
+	return Allocate(size);
+}
+
+void *operator new[](std::size_t size,
+					 const std::nothrow_t & /*tag*/) noexcept {
+	return Allocate(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+	return AllocateAlignedOrThrow(size, alignment);
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+	return AllocateAlignedOrThrow(size, alignment);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment,
+				   const std::nothrow_t & /*tag*/) noexcept {
+	return AllocateAligned(size, alignment);
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment,
+					 const std::nothrow_t & /*tag*/) noexcept {
+	return AllocateAligned(size, alignment);
+}
+
+void operator delete(void *pointer) noexcept {
+	Free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept {
+	Free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t /*size*/) noexcept {
+	Free(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t /*size*/) noexcept {
+	Free(pointer);
+}
+
+void operator delete(void *pointer, const std::nothrow_t & /*tag*/) noexcept {
+	Free(pointer);
+}
+
+void operator delete[](void *pointer,
+					   const std::nothrow_t & /*tag*/) noexcept {
+	Free(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t /*alignment*/) noexcept {
+	FreeAligned(pointer);
+}
+
+void operator delete[](void *pointer,
+					   std::align_val_t /*alignment*/) noexcept {
+	FreeAligned(pointer);
+}
+
+void operator delete(void *pointer, std::size_t /*size*/,
+					 std::align_val_t /*alignment*/) noexcept {
+	FreeAligned(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t /*size*/,
+					   std::align_val_t /*alignment*/) noexcept {
+	FreeAligned(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t /*alignment*/,
+					 const std::nothrow_t & /*tag*/) noexcept {
+	FreeAligned(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t /*alignment*/,
+					   const std::nothrow_t & /*tag*/) noexcept {
+	FreeAligned(pointer);
+}
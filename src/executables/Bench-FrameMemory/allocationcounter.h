@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+
+// Counts the calls to the global operator new and delete, which
+// allocationcounter.cpp replaces. It lives next to Bench-FrameMemory so that
+// it's only compiled into that executable, the others keep the library's
+// allocator. The counters are relaxed atomics. malloc() and the driver's own
+// allocations aren't counted.
+struct AllocationStats {
+	unsigned long news = 0;
+	unsigned long deletes = 0;
+	std::size_t bytes = 0;
+};
+
+// Totals since the program started. Take two and subtract them to get the
+// allocations in between.
+AllocationStats GetAllocationStats();
+
+inline AllocationStats operator-(const AllocationStats &a,
+								 const AllocationStats &b) {
+	return {a.news - b.news, a.deletes - b.deletes, a.bytes - b.bytes};
+}
+
+inline AllocationStats &operator+=(AllocationStats &a,
+								   const AllocationStats &b) {
+	a.news += b.news;
+	a.deletes += b.deletes;
+	a.bytes += b.bytes;
+	return a;
+}
@@ -0,0 +1,281 @@
+// clang-format off
+#include <glbinding/gl/gl.h>
+#define GLFW_INCLUDE_NONE
+#include "pr_glfw.h"
+// clang-format on
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <memory_resource>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "allocationcounter.h"
+#include "benchcontext.h"
+#include "benchmark.h"
+#include "framearena.h"
+#include "indexbuffer.h"
+#include "poolallocator.h"
+#include "renderer.h"
+#include "renderqueue.h"
+#include "shader.h"
+#include "shadercompiler.h"
+#include "shadersource.h"
+#include "vertexarray.h"
+#include "vertexbuffer.h"
+#include "vertexlayout.h"
+
+// Builds the per-frame data of a scene from scratch every frame, the way a
+// renderer does: a list of the objects that pass a visibility test, a
+// uniform block for each of them, and short-lived sparks that are spawned
+// and destroyed every frame. With --mode=arena the lists and blocks come
+// from a FrameArena and the sparks from a PoolAllocator, with --mode=heap
+// both go through the global heap. Either way the code only sees a
+// std::pmr::memory_resource.
+//
+// Prints the calls to the global operator new per frame after the warm-up,
+// for the whole loop and for building and drawing the frame data alone. The
+// latter should be 0 with the arena. The rest of the loop (swapping,
+// events, the benchmark and state bookkeeping) isn't the arena's to remove.
+//
+// Options (on top of the usual ones):
+//   --mode=arena|heap  where the frame data comes from (default arena)
+//   --objects=N        objects in the scene (default 20000)
+//   --sparks=N         sparks spawned per frame (default 500)
+
+using namespace gl;
+
+constexpr unsigned int kMeshes = 4;
+constexpr unsigned int kSparkLife = 60;
+// Frames before the allocations are counted, while the arena, the pool and
+// the queue grow to their steady state
+constexpr unsigned long kWarmupFrames = 30;
+
+struct Object {
+	unsigned int mesh;
+	std::array<float, 2> center;
+	float radius;
+	float phase;
+	float scale;
+};
+
+struct Spark {
+	std::array<float, 2> position;
+	std::array<float, 2> velocity;
+	unsigned int life;
+};
+
+struct UniformBlock {
+	std::array<float, 4> transform;
+	unsigned int mesh;
+	bool spark;
+};
+
+int main(int argc, char **argv) {
+	FrameBenchmark bench(argc, argv);
+	bool useArena = GetArgString(argc, argv, "--mode=", "arena") != "heap";
+	unsigned long objectCount = GetArgValue(argc, argv, "--objects=", 20000);
+	unsigned long sparkCount = GetArgValue(argc, argv, "--sparks=", 500);
+
+	BenchContext context(argc, argv, bench, "Bench-FrameMemory");
+	if (!context.isValid())
+		return -1;
+	GLFWObjects::Window &window = context.getWindow();
+
+	ShaderLibrary shaderLibrary;
+	std::optional<ShaderSource> source =
+		shaderLibrary.parse("res/shaders/Queue.shader");
+	if (!source)
+		return -1;
+	// One look for the objects and one for the sparks
+	std::vector<Shader> shaders;
+	for (unsigned int i = 0; i < 2; i++) {
+		shaders.emplace_back(CreateProgram(
+			source->str(ShaderStage::VERTEX),
+			ApplyDefines(source->str(ShaderStage::FRAGMENT),
+						 {"VARIANT " + std::to_string(i + 1)})));
+		if (shaders.back().GetRendererID() == 0)
+			return -1;
+	}
+
+	// Regular polygons with 3, 4, 5... sides, each in its own VAO
+	std::vector<VertexArray> vertexArrays(kMeshes);
+	std::vector<VertexBuffer> vertexBuffers;
+	std::vector<IndexBuffer> indexBuffers;
+	vertexBuffers.reserve(kMeshes);
+	indexBuffers.reserve(kMeshes);
+	for (unsigned int mesh = 0; mesh < kMeshes; mesh++) {
+		unsigned int sides = mesh + 3;
+		std::vector<float> positions{0.0f, 0.0f};
+		std::vector<std::uint32_t> indices;
+		for (unsigned int side = 0; side < sides; side++) {
+			float angle = 6.2831853f * static_cast<float>(side) /
+						  static_cast<float>(sides);
+			positions.insert(positions.end(),
+							 {std::cos(angle), std::sin(angle)});
+			indices.insert(indices.end(),
+						   {0, side + 1, (side + 1) % sides + 1});
+		}
+		vertexBuffers.emplace_back(
+			positions.data(),
+			static_cast<unsigned int>(positions.size() * sizeof(float)));
+		indexBuffers.emplace_back(indices, sides + 1);
+		vertexArrays[mesh].addBuffer<VertexLayout<Attr<float, 2>>>(
+			vertexBuffers[mesh]);
+		vertexArrays[mesh].setIndexBuffer(indexBuffers[mesh]);
+	}
+
+	unsigned int white = 0;
+	std::uint32_t whitePixel = 0xffffffffU;
+	GLCall(glGenTextures(1, &white));
+	GLState::get().bindTexture(0, GL_TEXTURE_2D, white);
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(GL_RGBA8), 1, 1,
+						0, GL_RGBA, GL_UNSIGNED_BYTE, &whitePixel));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+						   static_cast<GLint>(GL_NEAREST)));
+
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<Object> scene(objectCount);
+	for (Object &object : scene) {
+		object.mesh = static_cast<unsigned int>(rng() % kMeshes);
+		object.center = {unit(rng) * 2.4f - 1.2f, unit(rng) * 2.4f - 1.2f};
+		object.radius = unit(rng) * 0.2f;
+		object.phase = unit(rng) * 6.28f;
+		object.scale = 0.005f + unit(rng) * 0.02f;
+	}
+
+	FrameArena frameArena;
+	PoolAllocator sparkPool(sizeof(Spark), 1024);
+	std::pmr::memory_resource *frameMemory =
+		useArena ? static_cast<std::pmr::memory_resource *>(&frameArena)
+				 : std::pmr::new_delete_resource();
+	std::pmr::memory_resource *sparkMemory =
+		useArena ? static_cast<std::pmr::memory_resource *>(&sparkPool)
+				 : std::pmr::new_delete_resource();
+	if (useArena)
+		window.setFrameArena(&frameArena);
+
+	// Sized for the most sparks that can be alive at once
+	std::vector<Spark *> sparks;
+	sparks.reserve(sparkCount * kSparkLife);
+
+	GLState &state = GLState::get();
+	RenderQueue queue("u_Transform");
+
+	unsigned long frames = 0;
+	unsigned long countedFrames = 0;
+	// The whole loop body, and only the part that builds the frame data
+	AllocationStats counted;
+	AllocationStats countedFrameData;
+	while (!window.shouldClose() && !bench.isDone()) {
+		AllocationStats start = GetAllocationStats();
+		GLCall(glClear(GL_COLOR_BUFFER_BIT));
+		float time = static_cast<float>(frames) * 0.01f;
+
+		// Retire the sparks that burnt out and spawn new ones
+		for (size_t i = 0; i < sparks.size();) {
+			Spark *spark = sparks[i];
+			if (--spark->life > 0) {
+				spark->position[0] += spark->velocity[0];
+				spark->position[1] += spark->velocity[1];
+				i++;
+				continue;
+			}
+			sparkMemory->deallocate(spark, sizeof(Spark), alignof(Spark));
+			sparks[i] = sparks.back();
+			sparks.pop_back();
+		}
+		for (unsigned long i = 0; i < sparkCount; i++) {
+			auto *spark = new (sparkMemory->allocate(sizeof(Spark),
+													 alignof(Spark))) Spark{
+				{0.0f, 0.0f},
+				{(unit(rng) - 0.5f) * 0.03f, (unit(rng) - 0.5f) * 0.03f},
+				1 + static_cast<unsigned int>(rng() % kSparkLife)};
+			sparks.push_back(spark);
+		}
+
+		// The culling list and the uniform blocks only live for this frame
+		std::pmr::vector<const Object *> visible(frameMemory);
+		visible.reserve(scene.size());
+		for (const Object &object : scene) {
+			float angle = time + object.phase;
+			float x = object.center[0] + std::cos(angle) * object.radius;
+			float y = object.center[1] + std::sin(angle) * object.radius;
+			if (std::abs(x) < 1.0f && std::abs(y) < 1.0f)
+				visible.push_back(&object);
+		}
+		std::pmr::vector<UniformBlock> blocks(frameMemory);
+		blocks.reserve(visible.size() + sparks.size());
+		for (const Object *object : visible) {
+			float angle = time + object->phase;
+			blocks.push_back(
+				{{object->center[0] + std::cos(angle) * object->radius,
+				  object->center[1] + std::sin(angle) * object->radius,
+				  object->scale, 0.5f},
+				 object->mesh,
+				 false});
+		}
+		for (const Spark *spark : sparks) {
+			blocks.push_back({{spark->position[0], spark->position[1], 0.004f,
+							   0.25f},
+							  0,
+							  true});
+		}
+
+		for (const UniformBlock &block : blocks) {
+			Shader &shader = shaders[block.spark ? 1 : 0];
+			const VertexArray &vertexArray = vertexArrays[block.mesh];
+			const IndexBuffer &indexBuffer = indexBuffers[block.mesh];
+			std::uint64_t key = SortKey::Make(
+				0, false, shader.GetRendererID(), vertexArray.GetRendererID(),
+				white, block.transform[3]);
+			queue.submit({key, &shader, vertexArray.GetRendererID(), white,
+						  indexBuffer.GetType(), indexBuffer.GetCount(), 0, 0,
+						  block.transform});
+		}
+		queue.flush();
+		AllocationStats frameDataEnd = GetAllocationStats();
+
+		window.swapBuffers();
+		bench.endFrame();
+		state.endFrame();
+		glfwPollEvents();
+
+		if (frames >= kWarmupFrames) {
+			counted += GetAllocationStats() - start;
+			countedFrameData += frameDataEnd - start;
+			countedFrames++;
+		}
+		frames++;
+	}
+
+	bench.report(std::cout);
+	double frameCount = std::max(static_cast<double>(countedFrames), 1.0);
+	std::cout << "{\"mode\": \"" << (useArena ? "arena" : "heap")
+			  << "\", \"objects\": " << objectCount
+			  << ", \"sparks_per_frame\": " << sparkCount
+			  << ", \"news_per_frame\": "
+			  << static_cast<double>(counted.news) / frameCount
+			  << ", \"deletes_per_frame\": "
+			  << static_cast<double>(counted.deletes) / frameCount
+			  << ", \"new_bytes_per_frame\": "
+			  << static_cast<double>(counted.bytes) / frameCount
+			  << ", \"frame_data_news_per_frame\": "
+			  << static_cast<double>(countedFrameData.news) / frameCount
+			  << ", \"frame_data_deletes_per_frame\": "
+			  << static_cast<double>(countedFrameData.deletes) / frameCount
+			  << ", \"arena_capacity\": " << frameArena.GetCapacity()
+			  << ", \"spark_pool_blocks\": " << sparkPool.GetBlockCount()
+			  << "}" << std::endl;
+
+	for (Spark *spark : sparks)
+		sparkMemory->deallocate(spark, sizeof(Spark), alignof(Spark));
+	state.onTextureDeleted(white);
+	GLCall(glDeleteTextures(1, &white));
+	return 0;
+}
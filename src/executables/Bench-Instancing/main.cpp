@@ -0,0 +1,243 @@
+// clang-format off
+#include <glbinding/gl/gl.h>
+#define GLFW_INCLUDE_NONE
+#include "pr_glfw.h"
+// clang-format on
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchcontext.h"
+#include "benchmark.h"
+#include "indexbuffer.h"
+#include "renderer.h"
+#include "shader.h"
+#include "shadercompiler.h"
+#include "shadersource.h"
+#include "streambuffer.h"
+#include "vertexarray.h"
+#include "vertexbuffer.h"
+#include "vertexlayout.h"
+
+// Draws the same small quad many times with a different offset, scale and
+// color each, either with one draw per quad and the data set as uniforms, or
+// with a single instanced draw reading it from an instance buffer that's
+// rewritten every frame.
+//
+// Options (on top of the usual ones):
+//   --mode=instanced|persistent|uniforms
+//                     instanced streams the instances with glBufferSubData,
+//                     persistent through a StreamBuffer and base instance,
+//                     uniforms makes a draw per quad (default instanced)
+//   --instances=N     quads per frame (default 10000)
+//   --sweep           instead of a single run, time --sweep-frames=N frames
+//                     (default 20) for every power of ten from 1 up to
+//                     --instances and print one JSON line each
+
+using namespace gl;
+
+struct Instance {
+	std::array<float, 2> offset;
+	float scale;
+	std::array<std::uint8_t, 4> color;
+};
+using QuadLayout = VertexLayout<Attr<float, 2>>;
+using InstanceLayout =
+	VertexLayout<Attr<float, 2>, Attr<float, 1>, Attr<std::uint8_t, 4, true>>;
+static_assert(InstanceLayout::matches<Instance>(
+	{offsetof(Instance, offset), offsetof(Instance, scale),
+	 offsetof(Instance, color)}));
+
+enum class Mode { INSTANCED, PERSISTENT, UNIFORMS };
+
+// Moves every instance along its velocity and bounces it off the edges of
+// clip space
+static void Update(std::vector<Instance> &instances,
+				   std::vector<std::array<float, 2>> &velocities,
+				   size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		for (size_t axis = 0; axis < 2; axis++) {
+			float &position = instances[i].offset[axis];
+			position += velocities[i][axis];
+			if (position < -1.0f || position > 1.0f)
+				velocities[i][axis] = -velocities[i][axis];
+		}
+	}
+}
+
+int main(int argc, char **argv) {
+	FrameBenchmark bench(argc, argv);
+	std::string_view modeName =
+		GetArgString(argc, argv, "--mode=", "instanced");
+	Mode mode = modeName == "uniforms"	   ? Mode::UNIFORMS
+				: modeName == "persistent" ? Mode::PERSISTENT
+										   : Mode::INSTANCED;
+	size_t maxInstances = GetArgValue(argc, argv, "--instances=", 10000);
+	bool sweep = HasArg(argc, argv, "--sweep");
+	unsigned long sweepFrames =
+		std::max(GetArgValue(argc, argv, "--sweep-frames=", 20), 1UL);
+
+	// The StreamBuffer needs glBufferStorage and drawing from its regions
+	// needs base instance, both core by 4.4
+	int version = mode == Mode::PERSISTENT ? 4 : 3;
+	BenchContext context(argc, argv, bench, "Bench-Instancing", version,
+						 version);
+	if (!context.isValid())
+		return -1;
+	GLFWObjects::Window &window = context.getWindow();
+	// The sweep times every step, vsync would cap them all
+	if (sweep)
+		glfwSwapInterval(0);
+
+	if (mode == Mode::PERSISTENT && !StreamBuffer::isSupported()) {
+		std::cerr << "glBufferStorage isn't supported, try --mode=instanced"
+				  << std::endl;
+		return -1;
+	}
+
+	ShaderLibrary shaderLibrary;
+	std::optional<ShaderSource> source =
+		shaderLibrary.parse("res/shaders/Instanced.shader");
+	if (!source)
+		return -1;
+	std::vector<std::string> defines;
+	if (mode != Mode::UNIFORMS)
+		defines.emplace_back("INSTANCED");
+	Shader shader(
+		CreateProgram(ApplyDefines(source->str(ShaderStage::VERTEX), defines),
+					  source->str(ShaderStage::FRAGMENT)));
+	if (shader.GetRendererID() == 0)
+		return -1;
+
+	std::array<float, 8> quad{-1.0f, -1.0f, 1.0f, -1.0f,
+							  1.0f,	 1.0f,	-1.0f, 1.0f};
+	std::array<std::uint8_t, 6> quadIndices{0, 1, 2, 2, 3, 0};
+
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<Instance> instances(maxInstances);
+	std::vector<std::array<float, 2>> velocities(maxInstances);
+	for (size_t i = 0; i < maxInstances; i++) {
+		instances[i].offset = {unit(rng) * 2.0f - 1.0f,
+							   unit(rng) * 2.0f - 1.0f};
+		instances[i].scale = 0.002f + unit(rng) * 0.01f;
+		instances[i].color = {static_cast<std::uint8_t>(unit(rng) * 255.0f),
+							  static_cast<std::uint8_t>(unit(rng) * 255.0f),
+							  static_cast<std::uint8_t>(unit(rng) * 255.0f),
+							  255};
+		velocities[i] = {unit(rng) * 0.01f - 0.005f,
+						 unit(rng) * 0.01f - 0.005f};
+	}
+	size_t instanceBytes = maxInstances * sizeof(Instance);
+
+	VertexArray va;
+	VertexBuffer quadBuffer(quad.data(), sizeof(quad));
+	va.addBuffer<QuadLayout>(quadBuffer);
+	IndexBuffer ib(quadIndices, 4);
+	va.setIndexBuffer(ib);
+
+	std::optional<VertexBuffer> instanceBuffer;
+	std::optional<StreamBuffer> stream;
+	if (mode == Mode::INSTANCED) {
+		instanceBuffer.emplace(nullptr,
+							   static_cast<unsigned int>(instanceBytes));
+		va.addInstanceBuffer<InstanceLayout>(*instanceBuffer);
+	} else if (mode == Mode::PERSISTENT) {
+		stream.emplace(GL_ARRAY_BUFFER, instanceBytes);
+		va.addInstanceBuffer<InstanceLayout>(*stream);
+	}
+
+	GLState &state = GLState::get();
+	shader.bind();
+	va.bind();
+
+	unsigned long drawCalls = 0;
+	auto drawFrame = [&](size_t count) {
+		GLCall(glClear(GL_COLOR_BUFFER_BIT));
+		Update(instances, velocities, count);
+		size_t bytes = count * sizeof(Instance);
+		switch (mode) {
+		case Mode::INSTANCED:
+			instanceBuffer->setData(instances.data(),
+									static_cast<unsigned int>(bytes));
+			va.drawInstanced(ib, static_cast<unsigned int>(count));
+			drawCalls++;
+			break;
+		case Mode::PERSISTENT: {
+			StreamBuffer::Allocation allocation =
+				stream->allocate(bytes, sizeof(Instance));
+			ASSERT(allocation.data != nullptr);
+			std::memcpy(allocation.data, instances.data(), bytes);
+			// The attributes point at the start of the buffer, the base
+			// instance moves them to this frame's region
+			auto baseInstance = static_cast<unsigned int>(allocation.offset /
+														  sizeof(Instance));
+			va.drawInstanced(ib, static_cast<unsigned int>(count),
+							 baseInstance);
+			drawCalls++;
+			stream->endFrame();
+			break;
+		}
+		case Mode::UNIFORMS:
+			for (size_t i = 0; i < count; i++) {
+				const Instance &instance = instances[i];
+				shader.setUniform("u_Offset", instance.offset[0],
+								  instance.offset[1]);
+				shader.setUniform("u_Scale", instance.scale);
+				shader.setUniform("u_Color", instance.color[0] / 255.0f,
+								  instance.color[1] / 255.0f,
+								  instance.color[2] / 255.0f,
+								  instance.color[3] / 255.0f);
+				GLCall(glDrawElements(GL_TRIANGLES,
+									  static_cast<GLsizei>(ib.GetCount()),
+									  ib.GetType(), nullptr));
+				drawCalls++;
+			}
+			break;
+		}
+		window.swapBuffers();
+		state.endFrame();
+		glfwPollEvents();
+	};
+
+	if (sweep) {
+		for (size_t count = 1; count <= maxInstances; count *= 10) {
+			// Let the previous count's frames drain first
+			drawFrame(count);
+			GLCall(glFinish());
+			drawCalls = 0;
+			auto start = std::chrono::steady_clock::now();
+			for (unsigned long frame = 0; frame < sweepFrames; frame++)
+				drawFrame(count);
+			GLCall(glFinish());
+			std::chrono::duration<double, std::milli> elapsed =
+				std::chrono::steady_clock::now() - start;
+			std::cout << "{\"mode\": \"" << modeName
+					  << "\", \"instances\": " << count
+					  << ", \"ms_per_frame\": "
+					  << elapsed.count() / static_cast<double>(sweepFrames)
+					  << ", \"draw_calls_per_frame\": "
+					  << drawCalls / sweepFrames << "}" << std::endl;
+		}
+		return 0;
+	}
+
+	while (!window.shouldClose() && !bench.isDone()) {
+		drawFrame(maxInstances);
+		bench.endFrame();
+	}
+
+	bench.report(std::cout);
+	std::cout << "{\"mode\": \"" << modeName
+			  << "\", \"instances\": " << maxInstances
+			  << ", \"draw_calls\": " << drawCalls << "}" << std::endl;
+	return 0;
+}
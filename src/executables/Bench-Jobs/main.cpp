@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmark.h"
+#include "frustumculler.h"
+#include "jobsystem.h"
+#include "meshoptimizer.h"
+#include "shadersource.h"
+
+// Runs the CPU side work of loading and drawing a scene on a JobSystem with
+// 1, 2, ... N threads and reports how each part scales:
+//   parse     generated shader files read with ShaderLibrary::parseAll
+//   optimize  scrambled grid meshes run through OptimizeMeshes
+//   cull      objects tested against a turning frustum with parallelFor
+// The checksums have to come out the same for every thread count.
+//
+// Options:
+//   --threads=N     most threads to try (default: one per core)
+//   --files=N       shader files to parse (default 400)
+//   --meshes=N      meshes to optimize (default 64)
+//   --objects=N     objects to cull (default 1000000)
+//   --iterations=M  times every workload runs per thread count (default 5)
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+using Vertex = std::array<float, 3>;
+
+struct Mesh {
+	std::vector<Vertex> vertices;
+	std::vector<std::uint32_t> indices;
+};
+
+static std::vector<std::string> GenerateShaders(const fs::path &directory,
+												unsigned long count) {
+	fs::create_directories(directory);
+	{
+		std::ofstream common(directory / "common.glsl");
+		for (int i = 0; i < 40; i++)
+			common << "float helper" << i << "(float x) { return x * " << i
+				   << ".0 + 0.5; }\n";
+	}
+
+	std::vector<std::string> paths;
+	for (unsigned long i = 0; i < count; i++) {
+		std::string path =
+			(directory / ("shader" + std::to_string(i) + ".shader")).string();
+		std::ofstream file(path);
+		file << "#shader vertex\n#version 410 core\n"
+			 << "layout(location = 0) in vec4 position;\n";
+		for (int j = 0; j < 30; j++)
+			file << "uniform vec4 u_Vertex" << j << ";\n";
+		file << "void main(){\n\tgl_Position = position;\n}\n\n"
+			 << "#shader fragment\n#version 410 core\n"
+			 << "#include \"common.glsl\"\n"
+			 << "layout(location = 0) out vec4 color;\n";
+		for (int j = 0; j < 30; j++)
+			file << "uniform vec4 u_Fragment" << j << ";\n";
+		file << "void main(){\n\tcolor = vec4(helper" << i % 40
+			 << "(1.0));\n}\n";
+		paths.push_back(path);
+	}
+	return paths;
+}
+
+// A grid of grid x grid quads with both its triangles and its vertices
+// shuffled
+static Mesh GenerateMesh(std::uint32_t grid, unsigned int seed) {
+	Mesh mesh;
+	for (std::uint32_t y = 0; y <= grid; y++) {
+		for (std::uint32_t x = 0; x <= grid; x++) {
+			mesh.vertices.push_back({static_cast<float>(x),
+									 static_cast<float>(y),
+									 std::sin(static_cast<float>(x + y))});
+		}
+	}
+
+	std::vector<std::array<std::uint32_t, 3>> triangles;
+	std::uint32_t row = grid + 1;
+	for (std::uint32_t y = 0; y < grid; y++) {
+		for (std::uint32_t x = 0; x < grid; x++) {
+			std::uint32_t a = y * row + x;
+			triangles.push_back({a, a + row, a + 1});
+			triangles.push_back({a + 1, a + row, a + row + 1});
+		}
+	}
+	std::mt19937 rng(seed);
+	std::shuffle(triangles.begin(), triangles.end(), rng);
+	std::vector<std::uint32_t> remap(mesh.vertices.size());
+	for (std::uint32_t i = 0; i < remap.size(); i++)
+		remap[i] = i;
+	std::shuffle(remap.begin(), remap.end(), rng);
+
+	std::vector<Vertex> shuffled(mesh.vertices.size());
+	for (size_t i = 0; i < mesh.vertices.size(); i++)
+		shuffled[remap[i]] = mesh.vertices[i];
+	mesh.vertices.swap(shuffled);
+	for (const std::array<std::uint32_t, 3> &triangle : triangles) {
+		for (std::uint32_t index : triangle)
+			mesh.indices.push_back(remap[index]);
+	}
+	return mesh;
+}
+
+static std::vector<CullObject> GenerateObjects(unsigned long count) {
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+	std::uniform_real_distribution<float> size(0.2f, 1.5f);
+	std::vector<CullObject> objects(count);
+	for (CullObject &object : objects) {
+		object.center = {position(rng), position(rng) * 0.25f, position(rng)};
+		object.halfExtents = {size(rng), size(rng), size(rng)};
+		const std::array<float, 3> &extents = object.halfExtents;
+		object.radius = std::sqrt(extents[0] * extents[0] +
+								  extents[1] * extents[1] +
+								  extents[2] * extents[2]);
+		object.indexCount = 36;
+		object.firstIndex = 0;
+		object.baseVertex = 0;
+		object.padding = {0, 0};
+	}
+	return objects;
+}
+
+// The projection times a view from the origin turned by yaw around y,
+// column major
+static std::array<float, 16> ViewProjection(float yaw) {
+	constexpr float kNear = 0.1f;
+	constexpr float kFar = 300.0f;
+	float f = 1.0f / std::tan(0.5f);
+	float aspect = 4.0f / 3.0f;
+	float c = std::cos(yaw);
+	float s = std::sin(yaw);
+	float a = (kFar + kNear) / (kNear - kFar);
+	float b = 2.0f * kFar * kNear / (kNear - kFar);
+	return {f / aspect * c,	 0.0f, a * s, -s,	 0.0f, f,	 0.0f, 0.0f,
+			-f / aspect * s, 0.0f, a * c, -c, 0.0f, 0.0f, b,	  0.0f};
+}
+
+template <typename F> static double MeasureMs(F &&function) {
+	auto start = Clock::now();
+	function();
+	std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+	return elapsed.count();
+}
+
+int main(int argc, char **argv) {
+	unsigned long maxThreads = std::max(
+		GetArgValue(argc, argv, "--threads=",
+					std::max(std::thread::hardware_concurrency(), 1U)),
+		1UL);
+	unsigned long fileCount = GetArgValue(argc, argv, "--files=", 400);
+	unsigned long meshCount = GetArgValue(argc, argv, "--meshes=", 64);
+	unsigned long objectCount = GetArgValue(argc, argv, "--objects=", 1000000);
+	unsigned long iterations = GetArgValue(argc, argv, "--iterations=", 5);
+
+	fs::path directory = fs::temp_directory_path() / "pr_jobs_bench";
+	std::vector<std::string> paths = GenerateShaders(directory, fileCount);
+	std::vector<Mesh> meshes(meshCount);
+	for (unsigned long i = 0; i < meshCount; i++)
+		meshes[i] = GenerateMesh(64, static_cast<unsigned int>(i));
+	std::vector<CullObject> objects = GenerateObjects(objectCount);
+
+	double baseline[3] = {0.0, 0.0, 0.0};
+	for (unsigned long threads = 1; threads <= maxThreads; threads++) {
+		JobSystem jobs(static_cast<unsigned int>(threads - 1));
+		std::size_t parseChecksum = 0;
+		std::size_t meshChecksum = 0;
+		std::atomic<std::size_t> cullChecksum{0};
+
+		FrustumPlanes planes{};
+		auto cullRange = [&](size_t begin, size_t end) {
+			size_t visible = 0;
+			for (size_t i = begin; i < end; i++)
+				visible += IsVisible(planes, objects[i]) ? 1 : 0;
+			cullChecksum += visible;
+		};
+
+		double parseMs = 0.0;
+		double optimizeMs = 0.0;
+		for (unsigned long it = 0; it < iterations; it++) {
+			// A fresh library every time, cached files would skip the work
+			ShaderLibrary library;
+			std::vector<std::optional<ShaderSource>> sources;
+			parseMs += MeasureMs([&]() {
+				sources = library.parseAll(paths, jobs);
+			});
+			for (const std::optional<ShaderSource> &source : sources) {
+				parseChecksum += source->str(ShaderStage::VERTEX).size() +
+								 source->str(ShaderStage::FRAGMENT).size();
+			}
+
+			std::vector<Mesh> scrambled = meshes;
+			std::vector<MeshToOptimize> views;
+			for (Mesh &mesh : scrambled) {
+				views.push_back({mesh.vertices.data(), mesh.vertices.size(),
+								 sizeof(Vertex), 0, mesh.indices.data(),
+								 mesh.indices.size()});
+			}
+			optimizeMs += MeasureMs([&]() { OptimizeMeshes(views, jobs); });
+			for (size_t i = 0; i < views.size(); i++)
+				meshChecksum += scrambled[i].indices[0] + views[i].vertexCount;
+		}
+		double cullMs = MeasureMs([&]() {
+			for (unsigned long it = 0; it < iterations; it++) {
+				planes = ExtractFrustumPlanes(
+					ViewProjection(static_cast<float>(it) * 0.7f));
+				jobs.parallelFor(objects.size(), 4096, cullRange);
+			}
+		});
+
+		if (threads == 1) {
+			baseline[0] = parseMs;
+			baseline[1] = optimizeMs;
+			baseline[2] = cullMs;
+		}
+		JobSystem::Stats stats = jobs.getStats();
+		unsigned long stolen = 0;
+		for (unsigned long count : stats.stolen)
+			stolen += count;
+		auto perIteration = [&](double ms) {
+			return ms / static_cast<double>(std::max(iterations, 1UL));
+		};
+		std::cout << "{\"name\": \"Bench-Jobs\", \"threads\": " << threads
+				  << ", \"ms\": {\"parse\": " << perIteration(parseMs)
+				  << ", \"optimize\": " << perIteration(optimizeMs)
+				  << ", \"cull\": " << perIteration(cullMs)
+				  << "}, \"speedup\": {\"parse\": " << baseline[0] / parseMs
+				  << ", \"optimize\": " << baseline[1] / optimizeMs
+				  << ", \"cull\": " << baseline[2] / cullMs
+				  << "}, \"stolen\": " << stolen
+				  << ", \"checksum\": [" << parseChecksum << ", "
+				  << meshChecksum << ", " << cullChecksum << "]}"
+				  << std::endl;
+	}
+
+	fs::remove_all(directory);
+	return 0;
+}
@@ -0,0 +1,172 @@
+// clang-format off
+#include <glbinding/gl/gl.h>
+#define GLFW_INCLUDE_NONE
+#include "pr_glfw.h"
+// clang-format on
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "benchcontext.h"
+#include "benchmark.h"
+#include "indexbuffer.h"
+#include "meshoptimizer.h"
+#include "renderer.h"
+#include "shader.h"
+#include "shadercompiler.h"
+#include "shadersource.h"
+#include "vertexarray.h"
+#include "vertexbuffer.h"
+
+// Draws a finely tessellated sphere whose triangles and vertices have been
+// shuffled, the way a badly exported asset might be, with and without
+// running it through the mesh optimizer first.
+//
+// Options (on top of the usual ones):
+//   --optimize   run OptimizeMesh before uploading
+//   --grid=N     N x N quads on the sphere (default 512)
+//   --draws=N    draws per frame (default 4)
+
+using namespace gl;
+
+struct Vertex {
+	std::array<float, 3> position;
+	std::array<float, 3> normal;
+};
+using Layout = VertexLayout<Attr<float, 3>, Attr<float, 3>>;
+static_assert(Layout::matches<Vertex>(
+	{offsetof(Vertex, position), offsetof(Vertex, normal)}));
+
+static void GenerateSphere(unsigned long grid, std::vector<Vertex> &vertices,
+						   std::vector<std::uint32_t> &indices) {
+	constexpr float kPi = 3.14159265f;
+	for (unsigned long y = 0; y <= grid; y++) {
+		for (unsigned long x = 0; x <= grid; x++) {
+			float u = static_cast<float>(x) / static_cast<float>(grid);
+			float v = static_cast<float>(y) / static_cast<float>(grid);
+			std::array<float, 3> p{std::sin(v * kPi) * std::cos(u * 2 * kPi),
+								   std::sin(v * kPi) * std::sin(u * 2 * kPi),
+								   std::cos(v * kPi)};
+			vertices.push_back({{p[0] * 0.9f, p[1] * 0.9f, p[2] * 0.9f}, p});
+		}
+	}
+
+	std::vector<std::array<std::uint32_t, 3>> triangles;
+	auto row = static_cast<std::uint32_t>(grid + 1);
+	for (std::uint32_t y = 0; y < grid; y++) {
+		for (std::uint32_t x = 0; x < grid; x++) {
+			std::uint32_t a = y * row + x;
+			triangles.push_back({a, a + row, a + 1});
+			triangles.push_back({a + 1, a + row, a + row + 1});
+		}
+	}
+
+	// Scramble both orders, deterministically so runs are comparable
+	std::mt19937 rng(42);
+	std::shuffle(triangles.begin(), triangles.end(), rng);
+	std::vector<std::uint32_t> remap(vertices.size());
+	for (std::uint32_t i = 0; i < remap.size(); i++)
+		remap[i] = i;
+	std::shuffle(remap.begin(), remap.end(), rng);
+
+	std::vector<Vertex> shuffled(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+		shuffled[remap[i]] = vertices[i];
+	vertices.swap(shuffled);
+	for (const auto &triangle : triangles) {
+		for (std::uint32_t index : triangle)
+			indices.push_back(remap[index]);
+	}
+}
+
+static void PrintStats(std::ostream &out, const VertexCacheStats &cache,
+					   const VertexFetchStats &fetch) {
+	out << "{\"acmr\": " << cache.acmr << ", \"atvr\": " << cache.atvr
+		<< ", \"fetched_mb\": "
+		<< static_cast<double>(fetch.bytesFetched) / (1 << 20)
+		<< ", \"overfetch\": " << fetch.overfetch << "}";
+}
+
+int main(int argc, char **argv) {
+	FrameBenchmark bench(argc, argv);
+	bool optimize = HasArg(argc, argv, "--optimize");
+	unsigned long grid = GetArgValue(argc, argv, "--grid=", 512);
+	unsigned long draws = GetArgValue(argc, argv, "--draws=", 4);
+
+	std::vector<Vertex> vertices;
+	std::vector<std::uint32_t> indices;
+	GenerateSphere(grid, vertices, indices);
+
+	std::optional<MeshOptimizerStats> meshStats;
+	if (optimize)
+		meshStats = OptimizeMesh(vertices, indices);
+
+	BenchContext context(argc, argv, bench, "Bench-MeshOptimizer", 4, 1);
+	if (!context.isValid())
+		return -1;
+	GLFWObjects::Window &window = context.getWindow();
+
+	ShaderLibrary shaderLibrary;
+	std::optional<ShaderSource> source =
+		shaderLibrary.parse("res/shaders/VertexFetch.shader");
+	if (!source)
+		return -1;
+	Shader shader(CreateProgram(source->str(ShaderStage::VERTEX),
+								source->str(ShaderStage::FRAGMENT)));
+	if (shader.GetRendererID() == 0)
+		return -1;
+
+	VertexArray va;
+	VertexBuffer vb(vertices.data(), static_cast<unsigned int>(
+										 vertices.size() * sizeof(Vertex)));
+	va.addBuffer<Layout>(vb);
+	IndexBuffer ib(indices, static_cast<unsigned int>(vertices.size()));
+	va.setIndexBuffer(ib);
+
+	GLState &state = GLState::get();
+	state.setDepthTest(true);
+	state.setDepthFunc(GL_LESS);
+	shader.bind();
+	va.bind();
+
+	while (!window.shouldClose() && !bench.isDone()) {
+		GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+		for (unsigned long i = 0; i < draws; i++) {
+			GLCall(glDrawElements(GL_TRIANGLES,
+								  static_cast<GLsizei>(ib.GetCount()),
+								  ib.GetType(), nullptr));
+		}
+
+		window.swapBuffers();
+		bench.endFrame();
+		state.endFrame();
+		glfwPollEvents();
+	}
+
+	bench.report(std::cout);
+	std::cout << "{\"optimized\": " << (optimize ? "true" : "false")
+			  << ", \"triangles\": " << indices.size() / 3
+			  << ", \"vertices\": " << vertices.size();
+	if (meshStats) {
+		std::cout << ", \"optimize_ms\": " << meshStats->optimizeMs
+				  << ", \"before\": ";
+		PrintStats(std::cout, meshStats->cacheBefore, meshStats->fetchBefore);
+		std::cout << ", \"after\": ";
+		PrintStats(std::cout, meshStats->cacheAfter, meshStats->fetchAfter);
+	} else {
+		std::cout << ", \"before\": ";
+		PrintStats(std::cout,
+				   AnalyzeVertexCache(indices.data(), indices.size(),
+									  vertices.size()),
+				   AnalyzeVertexFetch(indices.data(), indices.size(),
+									  vertices.size(), sizeof(Vertex)));
+	}
+	std::cout << "}" << std::endl;
+	return 0;
+}
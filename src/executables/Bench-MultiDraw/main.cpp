@@ -0,0 +1,175 @@
+// clang-format off
+#include <glbinding/gl/gl.h>
+#define GLFW_INCLUDE_NONE
+#include "pr_glfw.h"
+// clang-format on
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "benchcontext.h"
+#include "benchmark.h"
+#include "drawcommandbuffer.h"
+#include "indexbuffer.h"
+#include "renderer.h"
+#include "shader.h"
+#include "shadercompiler.h"
+#include "shadersource.h"
+#include "storagebuffer.h"
+#include "vertexarray.h"
+#include "vertexbuffer.h"
+#include "vertexlayout.h"
+
+// Draws thousands of small meshes that all live in one vertex and index
+// buffer, each with its own transform and color read from a storage buffer.
+// Either all of them are submitted with a single glMultiDrawElementsIndirect
+// or with one glDrawElementsInstancedBaseVertexBaseInstance per mesh, which
+// runs the same shader on the same data.
+//
+// Options (on top of the usual ones):
+//   --mode=indirect|direct  how the draws are submitted (default indirect)
+//   --draws=N               meshes per frame (default 10000)
+
+using namespace gl;
+
+constexpr unsigned int kMeshCount = 64;
+
+struct DrawData {
+	std::array<float, 4> transform;
+	std::array<float, 4> color;
+};
+
+struct Mesh {
+	unsigned int firstIndex;
+	unsigned int indexCount;
+	int baseVertex;
+};
+
+// Regular polygons with 3 to kMeshCount + 2 sides, as triangle fans around
+// their center. Indices are relative to each mesh's first vertex.
+static std::vector<Mesh> CreateMeshes(std::vector<float> &positions,
+									  std::vector<std::uint32_t> &indices) {
+	std::vector<Mesh> meshes;
+	for (unsigned int mesh = 0; mesh < kMeshCount; mesh++) {
+		unsigned int sides = mesh + 3;
+		meshes.push_back({static_cast<unsigned int>(indices.size()),
+						  sides * 3,
+						  static_cast<int>(positions.size() / 2)});
+		positions.insert(positions.end(), {0.0f, 0.0f});
+		for (unsigned int side = 0; side < sides; side++) {
+			float angle = 6.2831853f * static_cast<float>(side) /
+						  static_cast<float>(sides);
+			positions.insert(positions.end(), {std::cos(angle),
+											   std::sin(angle)});
+			indices.insert(indices.end(),
+						   {0, side + 1, (side + 1) % sides + 1});
+		}
+	}
+	return meshes;
+}
+
+int main(int argc, char **argv) {
+	FrameBenchmark bench(argc, argv);
+	bool indirect =
+		GetArgString(argc, argv, "--mode=", "indirect") != "direct";
+	unsigned long drawCount = GetArgValue(argc, argv, "--draws=", 10000);
+
+	// Multi-draw indirect and storage buffers are core since 4.3
+	BenchContext context(argc, argv, bench, "Bench-MultiDraw", 4, 3);
+	if (!context.isValid())
+		return -1;
+	GLFWObjects::Window &window = context.getWindow();
+
+	if (!DrawCommandBuffer::isSupported()) {
+		std::cerr << "glMultiDrawElementsIndirect isn't supported" << std::endl;
+		return -1;
+	}
+
+	ShaderLibrary shaderLibrary;
+	std::optional<ShaderSource> source =
+		shaderLibrary.parse("res/shaders/MultiDraw.shader");
+	if (!source)
+		return -1;
+	Shader shader(CreateProgram(source->str(ShaderStage::VERTEX),
+								source->str(ShaderStage::FRAGMENT)));
+	if (shader.GetRendererID() == 0)
+		return -1;
+
+	std::vector<float> positions;
+	std::vector<std::uint32_t> indices;
+	std::vector<Mesh> meshes = CreateMeshes(positions, indices);
+
+	VertexArray va;
+	VertexBuffer vb(positions.data(), static_cast<unsigned int>(
+										  positions.size() * sizeof(float)));
+	va.addBuffer<VertexLayout<Attr<float, 2>>>(vb);
+	IndexBuffer ib(indices, static_cast<unsigned int>(positions.size() / 2));
+	va.setIndexBuffer(ib);
+
+	DrawCommandBuffer commands(drawCount);
+	commands.addDrawIDAttribute(va);
+
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<DrawData> draws(drawCount);
+	for (unsigned long i = 0; i < drawCount; i++) {
+		const Mesh &mesh = meshes[i % kMeshCount];
+		unsigned int drawID =
+			commands.add(mesh.indexCount, mesh.firstIndex, mesh.baseVertex);
+		draws[drawID] = {{unit(rng) * 2.0f - 1.0f, unit(rng) * 2.0f - 1.0f,
+						  0.005f + unit(rng) * 0.02f, unit(rng) * 6.28f},
+						 {unit(rng), unit(rng), unit(rng), 1.0f}};
+	}
+	StorageBuffer drawData(draws.data(), draws.size() * sizeof(DrawData));
+	drawData.bindBase(0);
+
+	GLState &state = GLState::get();
+	shader.bind();
+
+	using Clock = std::chrono::steady_clock;
+	Clock::duration submitTime{};
+	unsigned long frames = 0;
+	while (!window.shouldClose() && !bench.isDone()) {
+		GLCall(glClear(GL_COLOR_BUFFER_BIT));
+		shader.setUniform("u_Time", static_cast<float>(frames) * 0.01f);
+
+		Clock::time_point start = Clock::now();
+		if (indirect) {
+			commands.submit(va, ib);
+		} else {
+			va.bind();
+			for (const DrawElementsIndirectCommand &command :
+				 commands.GetCommands()) {
+				// NOLINTNEXTLINE(performance-no-int-to-ptr)
+				const void *offset = reinterpret_cast<const void *>(
+					static_cast<std::uintptr_t>(command.firstIndex) *
+					ib.GetIndexSize());
+				GLCall(glDrawElementsInstancedBaseVertexBaseInstance(
+					GL_TRIANGLES, static_cast<GLsizei>(command.count),
+					ib.GetType(), offset, 1, command.baseVertex,
+					command.baseInstance));
+			}
+		}
+		submitTime += Clock::now() - start;
+		frames++;
+
+		window.swapBuffers();
+		bench.endFrame();
+		state.endFrame();
+		glfwPollEvents();
+	}
+
+	bench.report(std::cout);
+	std::chrono::duration<double, std::micro> submitUs = submitTime;
+	std::cout << "{\"mode\": \"" << (indirect ? "indirect" : "direct")
+			  << "\", \"draws\": " << drawCount << ", \"submit_us\": "
+			  << (frames > 0 ? submitUs.count() / static_cast<double>(frames)
+							 : 0.0)
+			  << "}" << std::endl;
+	return 0;
+}
@@ -0,0 +1,195 @@
+// clang-format off
+#include <glbinding/gl/gl.h>
+#define GLFW_INCLUDE_NONE
+#include "pr_glfw.h"
+// clang-format on
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchcontext.h"
+#include "benchmark.h"
+#include "indexbuffer.h"
+#include "renderer.h"
+#include "renderqueue.h"
+#include "shader.h"
+#include "shadercompiler.h"
+#include "shadersource.h"
+#include "vertexarray.h"
+#include "vertexbuffer.h"
+#include "vertexlayout.h"
+
+// A scene of small textured polygons with random materials, submitted in
+// scene order every frame. The RenderQueue sorts them by program, VAO and
+// texture before drawing, or draws them as they come with --no-sort.
+//
+// Options (on top of the usual ones):
+//   --draws=N     draws per frame (default 20000)
+//   --programs=N  distinct programs (default 8)
+//   --meshes=N    distinct VAOs (default 8)
+//   --textures=N  distinct textures (default 8)
+//   --no-sort     draw in submission order
+
+using namespace gl;
+
+struct Object {
+	unsigned int program;
+	unsigned int mesh;
+	unsigned int texture;
+	std::array<float, 4> transform;
+};
+
+// Checkerboards in different colors
+static std::vector<unsigned int> CreateTextures(unsigned long count) {
+	std::vector<unsigned int> textures(count);
+	GLCall(glGenTextures(static_cast<GLsizei>(count), textures.data()));
+	std::vector<std::uint32_t> pixels(8 * 8);
+	for (unsigned long i = 0; i < count; i++) {
+		auto tint = static_cast<std::uint32_t>(0xff000000U |
+											   (0x3f9fdfU * (i + 1)));
+		for (std::uint32_t p = 0; p < pixels.size(); p++)
+			pixels[p] = (p % 8 / 2 + p / 16) % 2 ? tint : 0xffffffffU;
+		GLState::get().bindTexture(0, GL_TEXTURE_2D, textures[i]);
+		GLCall(glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(GL_RGBA8), 8,
+							8, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+							   static_cast<GLint>(GL_NEAREST)));
+		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
+							   static_cast<GLint>(GL_NEAREST)));
+	}
+	return textures;
+}
+
+int main(int argc, char **argv) {
+	FrameBenchmark bench(argc, argv);
+	unsigned long drawCount = GetArgValue(argc, argv, "--draws=", 20000);
+	unsigned long programCount = GetArgValue(argc, argv, "--programs=", 8);
+	unsigned long meshCount = GetArgValue(argc, argv, "--meshes=", 8);
+	unsigned long textureCount = GetArgValue(argc, argv, "--textures=", 8);
+	bool sort = !HasArg(argc, argv, "--no-sort");
+
+	BenchContext context(argc, argv, bench, "Bench-RenderQueue");
+	if (!context.isValid())
+		return -1;
+	GLFWObjects::Window &window = context.getWindow();
+
+	ShaderLibrary shaderLibrary;
+	std::optional<ShaderSource> source =
+		shaderLibrary.parse("res/shaders/Queue.shader");
+	if (!source)
+		return -1;
+	std::vector<Shader> shaders;
+	for (unsigned long i = 0; i < programCount; i++) {
+		shaders.emplace_back(CreateProgram(
+			source->str(ShaderStage::VERTEX),
+			ApplyDefines(source->str(ShaderStage::FRAGMENT),
+						 {"VARIANT " + std::to_string(i)})));
+		if (shaders.back().GetRendererID() == 0)
+			return -1;
+	}
+
+	// Regular polygons with 3, 4, 5... sides, each in its own VAO
+	std::vector<VertexArray> vertexArrays(meshCount);
+	std::vector<VertexBuffer> vertexBuffers;
+	std::vector<IndexBuffer> indexBuffers;
+	vertexBuffers.reserve(meshCount);
+	indexBuffers.reserve(meshCount);
+	for (unsigned long mesh = 0; mesh < meshCount; mesh++) {
+		auto sides = static_cast<unsigned int>(mesh + 3);
+		std::vector<float> positions{0.0f, 0.0f};
+		std::vector<std::uint32_t> indices;
+		for (unsigned int side = 0; side < sides; side++) {
+			float angle = 6.2831853f * static_cast<float>(side) /
+						  static_cast<float>(sides);
+			positions.insert(positions.end(),
+							 {std::cos(angle), std::sin(angle)});
+			indices.insert(indices.end(),
+						   {0, side + 1, (side + 1) % sides + 1});
+		}
+		vertexBuffers.emplace_back(
+			positions.data(),
+			static_cast<unsigned int>(positions.size() * sizeof(float)));
+		indexBuffers.emplace_back(indices, sides + 1);
+		vertexArrays[mesh].addBuffer<VertexLayout<Attr<float, 2>>>(
+			vertexBuffers[mesh]);
+		vertexArrays[mesh].setIndexBuffer(indexBuffers[mesh]);
+	}
+	std::vector<unsigned int> textures = CreateTextures(textureCount);
+
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<Object> scene(drawCount);
+	for (Object &object : scene) {
+		object.program = static_cast<unsigned int>(rng() % programCount);
+		object.mesh = static_cast<unsigned int>(rng() % meshCount);
+		object.texture = static_cast<unsigned int>(rng() % textureCount);
+		object.transform = {unit(rng) * 2.0f - 1.0f, unit(rng) * 2.0f - 1.0f,
+							0.01f + unit(rng) * 0.03f, unit(rng)};
+	}
+
+	GLState &state = GLState::get();
+	state.setDepthTest(true);
+	RenderQueue queue("u_Transform");
+
+	unsigned long frames = 0;
+	while (!window.shouldClose() && !bench.isDone()) {
+		GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+
+		for (const Object &object : scene) {
+			Shader &shader = shaders[object.program];
+			const VertexArray &vertexArray = vertexArrays[object.mesh];
+			const IndexBuffer &indexBuffer = indexBuffers[object.mesh];
+			unsigned int texture = textures[object.texture];
+			std::uint64_t key = SortKey::Make(
+				0, false, shader.GetRendererID(), vertexArray.GetRendererID(),
+				texture, object.transform[3]);
+			queue.submit({key, &shader, vertexArray.GetRendererID(), texture,
+						  indexBuffer.GetType(), indexBuffer.GetCount(), 0, 0,
+						  object.transform});
+		}
+		queue.flush(sort);
+		frames++;
+
+		window.swapBuffers();
+		bench.endFrame();
+		state.endFrame();
+		glfwPollEvents();
+	}
+
+	bench.report(std::cout);
+	const RenderQueue::Stats &stats = queue.getStats();
+	auto perFrame = [&](unsigned long value) {
+		return frames > 0 ? value / frames : 0;
+	};
+	std::cout << "{\"sorted\": " << (sort ? "true" : "false")
+			  << ", \"draws\": " << perFrame(stats.draws)
+			  << ", \"program_changes_before\": "
+			  << perFrame(stats.unsorted.programs)
+			  << ", \"vao_changes_before\": "
+			  << perFrame(stats.unsorted.vertexArrays)
+			  << ", \"texture_changes_before\": "
+			  << perFrame(stats.unsorted.textures)
+			  << ", \"program_changes_after\": "
+			  << perFrame(stats.sorted.programs)
+			  << ", \"vao_changes_after\": "
+			  << perFrame(stats.sorted.vertexArrays)
+			  << ", \"texture_changes_after\": "
+			  << perFrame(stats.sorted.textures) << ", \"sort_ms\": "
+			  << (frames > 0 ? stats.sortMs / static_cast<double>(frames)
+							 : 0.0)
+			  << "}" << std::endl;
+	std::cerr << "State changes: " << state.getTotalStats().issued
+			  << " issued, " << state.getTotalStats().elided << " elided"
+			  << std::endl;
+
+	for (unsigned int texture : textures)
+		state.onTextureDeleted(texture);
+	GLCall(glDeleteTextures(static_cast<GLsizei>(textures.size()),
+							textures.data()));
+	return 0;
+}
@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "benchmark.h"
+#include "mappedfile.h"
+#include "shadersource.h"
+
+// Compares the original getline/stringstream ParseShader from the tutorials
+// with the ShaderLibrary on a few hundred generated shader files, both with a
+// fresh library (every file is loaded and split) and a warm one (cache hits).
+// It also loads the files with MappedFile both ways, read into a buffer and
+// memory mapped, which is what MappedFile::kMapThreshold is picked from.
+//
+// Options:
+//   --files=N       number of shader files to generate (default 500)
+//   --iterations=M  number of times every file set is parsed (default 20)
+//   --file-size=B   pad every file with comments to at least B bytes
+//                   (default 0, about 2 KB without padding)
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+struct ShaderProgramSource {
+	std::string vertexSource;
+	std::string fragmentSource;
+};
+
+// Verbatim copy of the tutorials' parser, kept here as the baseline
+static ShaderProgramSource ParseShader(const std::string &filePath) {
+	std::ifstream stream(filePath);
+
+	enum class ShaderType { NONE = -1, VERTEX, FRAGMENT };
+
+	std::string line;
+	std::array<std::stringstream, 2> ss;
+	ShaderType shaderType = ShaderType::NONE;
+
+	while (std::getline(stream, line)) {
+		if (line.find("#shader") != std::string::npos) {
+			if (line.find("vertex") != std::string::npos) {
+				// set mode to vertex
+				shaderType = ShaderType::VERTEX;
+			} else if (line.find("fragment") != std::string::npos) {
+				// set mode to fragment
+				shaderType = ShaderType::FRAGMENT;
+			}
+		} else {
+			ss.at(int(shaderType)) << line << std::endl;
+		}
+	}
+
+	return {ss[0].str(), ss[1].str()};
+}
+
+static std::vector<std::string> GenerateShaders(const fs::path &directory,
+												unsigned long count,
+												unsigned long fileSize) {
+	fs::create_directories(directory);
+
+	// A shared include, so the ShaderLibrary can show off its caching
+	{
+		std::ofstream common(directory / "common.glsl");
+		for (int i = 0; i < 40; i++)
+			common << "float helper" << i << "(float x) { return x * " << i
+				   << ".0 + 0.5; }\n";
+	}
+
+	std::vector<std::string> paths;
+	for (unsigned long i = 0; i < count; i++) {
+		std::string path =
+			(directory / ("shader" + std::to_string(i) + ".shader")).string();
+		std::ofstream file(path);
+		file << "#shader vertex\n#version 410 core\n"
+			 << "layout(location = 0) in vec4 position;\n";
+		for (int j = 0; j < 30; j++)
+			file << "uniform vec4 u_Vertex" << j << ";\n";
+		file << "void main(){\n\tgl_Position = position;\n}\n\n"
+			 << "#shader fragment\n#version 410 core\n"
+			 << "#include \"common.glsl\"\n"
+			 << "layout(location = 0) out vec4 color;\n";
+		for (int j = 0; j < 30; j++)
+			file << "uniform vec4 u_Fragment" << j << ";\n";
+		file << "void main(){\n\tcolor = vec4(helper" << i % 40
+			 << "(1.0));\n}\n";
+		for (auto size = static_cast<unsigned long>(file.tellp());
+			 size < fileSize; size += 64)
+			file << "// " << std::string(60, '-') << "\n";
+		paths.push_back(path);
+	}
+	return paths;
+}
+
+template <typename F> static double MeasureMs(F &&function) {
+	auto start = Clock::now();
+	function();
+	std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+	return elapsed.count();
+}
+
+int main(int argc, char **argv) {
+	unsigned long fileCount = GetArgValue(argc, argv, "--files=", 500);
+	unsigned long iterations = GetArgValue(argc, argv, "--iterations=", 20);
+	unsigned long fileSize = GetArgValue(argc, argv, "--file-size=", 0);
+	if (fileCount == 0 || iterations == 0) {
+		std::cerr << "--files and --iterations have to be at least 1"
+				  << std::endl;
+		return -1;
+	}
+
+	fs::path directory = fs::temp_directory_path() / "pr_shader_parse_bench";
+	std::vector<std::string> paths =
+		GenerateShaders(directory, fileCount, fileSize);
+	std::uintmax_t fileBytes = fs::file_size(paths.front());
+
+	// Keep the results alive so nothing gets optimized away
+	size_t checksum = 0;
+
+	double legacyMs = MeasureMs([&]() {
+		for (unsigned long it = 0; it < iterations; it++) {
+			for (const std::string &path : paths) {
+				ShaderProgramSource source = ParseShader(path);
+				checksum += source.vertexSource.size() +
+							source.fragmentSource.size();
+			}
+		}
+	});
+
+	bool failed = false;
+	auto parse = [&](ShaderLibrary &library, const std::string &path) {
+		std::optional<ShaderSource> source = library.parse(path);
+		if (!source) {
+			failed = true;
+			return;
+		}
+		checksum += source->pieces(ShaderStage::VERTEX).size() +
+					source->pieces(ShaderStage::FRAGMENT).size();
+	};
+
+	// A fresh library every iteration, so every file is loaded and split
+	double coldMs = MeasureMs([&]() {
+		for (unsigned long it = 0; it < iterations; it++) {
+			ShaderLibrary library;
+			for (const std::string &path : paths)
+				parse(library, path);
+		}
+	});
+
+	// One library, which is what a running application sees
+	ShaderLibrary library;
+	double warmMs = MeasureMs([&]() {
+		for (unsigned long it = 0; it < iterations; it++) {
+			for (const std::string &path : paths)
+				parse(library, path);
+		}
+	});
+
+	// Loading alone, both ways, counting lines so every page is touched
+	auto load = [&](std::size_t mapThreshold) {
+		return MeasureMs([&]() {
+			for (unsigned long it = 0; it < iterations; it++) {
+				for (const std::string &path : paths) {
+					MappedFile file(path, mapThreshold);
+					std::string_view text = file.view();
+					checksum += static_cast<std::size_t>(
+						std::count(text.begin(), text.end(), '\n'));
+				}
+			}
+		});
+	};
+	double readMs = load(std::numeric_limits<std::size_t>::max());
+	double mapMs = load(0);
+
+	fs::remove_all(directory);
+	if (failed) {
+		std::cerr << "Couldn't parse the generated shaders" << std::endl;
+		return -1;
+	}
+
+	auto perFileUs = [&](double totalMs) {
+		return totalMs * 1000.0 / static_cast<double>(iterations * fileCount);
+	};
+	std::cout << "{\"name\": \"Bench-ShaderParse\", \"files\": " << fileCount
+			  << ", \"iterations\": " << iterations
+			  << ", \"file_bytes\": " << fileBytes << ", \"library_maps\": "
+			  << (fileBytes >= MappedFile::kMapThreshold ? "true" : "false")
+			  << ", \"us_per_file\": {\"getline_stringstream\": "
+			  << perFileUs(legacyMs)
+			  << ", \"library_cold\": " << perFileUs(coldMs)
+			  << ", \"library_cached\": " << perFileUs(warmMs)
+			  << ", \"load_read\": " << perFileUs(readMs)
+			  << ", \"load_mmap\": " << perFileUs(mapMs)
+			  << "}, \"checksum\": " << checksum << "}" << std::endl;
+	return 0;
+}
@@ -0,0 +1,169 @@
+// clang-format off
+#include <glbinding/gl/gl.h>
+#define GLFW_INCLUDE_NONE
+#include "pr_glfw.h"
+// clang-format on
+#include <iostream>
+#include <optional>
+#include <vector>
+
+#include "benchcontext.h"
+#include "benchmark.h"
+#include "renderer.h"
+#include "shader.h"
+#include "shadercompiler.h"
+#include "shadersource.h"
+#include "streambuffer.h"
+
+// Rewrites and draws a few MB of triangles every frame, either straight into
+// a persistently mapped StreamBuffer or the classic way, by filling a vector
+// and copying it over with glBufferSubData into an orphaned buffer.
+//
+// Options (on top of the usual ones):
+//   --mode=persistent|subdata  how the vertices get to the GPU
+//   --mb=N                     megabytes of vertices per frame (default 16)
+//   --regions=N                frames the StreamBuffer can be ahead (default 3)
+
+using namespace gl;
+
+// Tiny triangles on a grid that drifts a bit every frame, so the data really
+// changes. Positions only, two floats per vertex.
+static void WriteVertices(float *out, size_t vertexCount,
+						  unsigned long frame) {
+	constexpr size_t kColumns = 512;
+	constexpr float kCell = 2.0f / kColumns;
+	float drift = static_cast<float>(frame % 64) * kCell / 64.0f;
+	size_t triangles = vertexCount / 3;
+	for (size_t i = 0; i < triangles; i++) {
+		float x = -1.0f + static_cast<float>(i % kColumns) * kCell + drift;
+		float y =
+			-1.0f + static_cast<float>((i / kColumns) % kColumns) * kCell;
+		// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+		float *v = out + i * 6;
+		v[0] = x;
+		v[1] = y;
+		v[2] = x + kCell * 0.5f;
+		v[3] = y;
+		v[4] = x;
+		v[5] = y + kCell * 0.5f;
+		// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+	}
+}
+
+int main(int argc, char **argv) {
+	FrameBenchmark bench(argc, argv);
+	bool persistent =
+		GetArgString(argc, argv, "--mode=", "persistent") != "subdata";
+	size_t frameBytes = GetArgValue(argc, argv, "--mb=", 16) << 20;
+	auto regions =
+		static_cast<unsigned int>(GetArgValue(argc, argv, "--regions=", 3));
+
+	constexpr size_t kVertexSize = 2 * sizeof(float);
+	// Whole triangles only
+	size_t vertexCount = frameBytes / kVertexSize / 3 * 3;
+	frameBytes = vertexCount * kVertexSize;
+
+	// glBufferStorage is core since 4.4
+	BenchContext context(argc, argv, bench, "Bench-Streaming", 4, 4);
+	if (!context.isValid())
+		return -1;
+	GLFWObjects::Window &window = context.getWindow();
+	// Never wait for vsync, the point is to see how far ahead the CPU gets
+	glfwSwapInterval(0);
+
+	if (persistent && !StreamBuffer::isSupported()) {
+		std::cerr << "glBufferStorage isn't supported, try --mode=subdata"
+				  << std::endl;
+		return -1;
+	}
+
+	ShaderLibrary shaderLibrary;
+	std::optional<ShaderSource> source =
+		shaderLibrary.parse("res/shaders/Basic.shader");
+	if (!source)
+		return -1;
+	Shader shader(CreateProgram(source->str(ShaderStage::VERTEX),
+								source->str(ShaderStage::FRAGMENT)));
+	if (shader.GetRendererID() == 0)
+		return -1;
+
+	GLState &state = GLState::get();
+	GLuint vao = 0;
+	GLCall(glGenVertexArrays(1, &vao));
+	state.bindVertexArray(vao);
+
+	std::optional<StreamBuffer> stream;
+	GLuint subdataBuffer = 0;
+	std::vector<float> staging;
+	if (persistent) {
+		stream.emplace(GL_ARRAY_BUFFER, frameBytes, regions);
+		stream->bind();
+	} else {
+		staging.resize(vertexCount * 2);
+		GLCall(glGenBuffers(1, &subdataBuffer));
+		state.bindBuffer(GL_ARRAY_BUFFER, subdataBuffer);
+		GLCall(glBufferData(GL_ARRAY_BUFFER,
+							static_cast<GLsizeiptr>(frameBytes), nullptr,
+							GL_STREAM_DRAW));
+	}
+	GLCall(glEnableVertexAttribArray(0));
+	GLCall(glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, kVertexSize,
+								 nullptr));
+
+	shader.bind();
+	shader.setUniform("u_Color", 0.2f, 0.8f, 0.3f, 1.0f);
+
+	unsigned long frame = 0;
+	while (!window.shouldClose() && !bench.isDone()) {
+		GLCall(glClear(GL_COLOR_BUFFER_BIT));
+
+		GLint first = 0;
+		if (persistent) {
+			StreamBuffer::Allocation vertices =
+				stream->allocate(frameBytes, kVertexSize);
+			ASSERT(vertices.data != nullptr);
+			WriteVertices(static_cast<float *>(vertices.data), vertexCount,
+						  frame);
+			first = static_cast<GLint>(vertices.offset / kVertexSize);
+		} else {
+			WriteVertices(staging.data(), vertexCount, frame);
+			// Orphan the old storage so the copy doesn't wait for the GPU
+			GLCall(glBufferData(GL_ARRAY_BUFFER,
+								static_cast<GLsizeiptr>(frameBytes), nullptr,
+								GL_STREAM_DRAW));
+			GLCall(glBufferSubData(GL_ARRAY_BUFFER, 0,
+								   static_cast<GLsizeiptr>(frameBytes),
+								   staging.data()));
+		}
+
+		GLCall(glDrawArrays(GL_TRIANGLES, first,
+							static_cast<GLsizei>(vertexCount)));
+
+		if (stream)
+			stream->endFrame();
+
+		window.swapBuffers();
+		bench.endFrame();
+		state.endFrame();
+		glfwPollEvents();
+		frame++;
+	}
+
+	bench.report(std::cout);
+	std::cout << "{\"mode\": \"" << (persistent ? "persistent" : "subdata")
+			  << "\", \"mb_per_frame\": "
+			  << static_cast<double>(frameBytes) / (1 << 20);
+	if (stream) {
+		const StreamBuffer::Stats &stats = stream->getStats();
+		std::cout << ", \"regions\": " << regions
+				  << ", \"stalls\": " << stats.stalls
+				  << ", \"stall_ms\": " << stats.stallMs;
+	}
+	std::cout << "}" << std::endl;
+
+	state.onBufferDeleted(subdataBuffer);
+	GLCall(glDeleteBuffers(1, &subdataBuffer));
+	state.onVertexArrayDeleted(vao);
+	GLCall(glDeleteVertexArrays(1, &vao));
+	return 0;
+}
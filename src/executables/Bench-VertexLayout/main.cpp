@@ -0,0 +1,203 @@
+// clang-format off
+#include <glbinding/gl/gl.h>
+#define GLFW_INCLUDE_NONE
+#include "pr_glfw.h"
+// clang-format on
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "benchcontext.h"
+#include "benchmark.h"
+#include "renderer.h"
+#include "shader.h"
+#include "shadercompiler.h"
+#include "shadersource.h"
+#include "vertexarray.h"
+#include "vertexbuffer.h"
+
+// Measures vertex fetch with the same mesh stored in different layouts. The
+// vertices are drawn as points with rasterization disabled, so the frame time
+// is dominated by fetching the attributes and running the vertex shader.
+//
+// Options (on top of the usual ones):
+//   --layout=aos|soa|packed  interleaved floats, one buffer per attribute, or
+//                            interleaved with normalized integer attributes
+//   --vertices=N             vertices per draw (default 1000000)
+//   --draws=N                draws per frame (default 8)
+
+using namespace gl;
+
+struct Vertex {
+	std::array<float, 3> position;
+	std::array<float, 3> normal;
+	std::array<float, 2> uv;
+	std::array<std::uint8_t, 4> color;
+};
+using VertexLayoutAoS =
+	VertexLayout<Attr<float, 3>, Attr<float, 3>, Attr<float, 2>,
+				 Attr<std::uint8_t, 4, true>>;
+static_assert(VertexLayoutAoS::matches<Vertex>(
+	{offsetof(Vertex, position), offsetof(Vertex, normal), offsetof(Vertex, uv),
+	 offsetof(Vertex, color)}));
+
+// The normal's w is padding, three shorts would leave the position of the
+// next vertex misaligned
+struct PackedVertex {
+	std::array<float, 3> position;
+	std::array<std::int16_t, 4> normal;
+	std::array<std::uint16_t, 2> uv;
+	std::array<std::uint8_t, 4> color;
+};
+using PackedVertexLayout =
+	VertexLayout<Attr<float, 3>, Attr<std::int16_t, 4, true>,
+				 Attr<std::uint16_t, 2, true>, Attr<std::uint8_t, 4, true>>;
+static_assert(PackedVertexLayout::matches<PackedVertex>(
+	{offsetof(PackedVertex, position), offsetof(PackedVertex, normal),
+	 offsetof(PackedVertex, uv), offsetof(PackedVertex, color)}));
+
+// A wavy grid, the values only need to be plausible
+static std::vector<Vertex> GenerateMesh(size_t count) {
+	std::vector<Vertex> vertices(count);
+	auto side = static_cast<size_t>(std::sqrt(static_cast<double>(count))) + 1;
+	for (size_t i = 0; i < count; i++) {
+		float u = static_cast<float>(i % side) / static_cast<float>(side);
+		float v = static_cast<float>(i / side) / static_cast<float>(side);
+		float height = 0.1f * std::sin(u * 20.0f) * std::cos(v * 20.0f);
+		Vertex &vertex = vertices[i];
+		vertex.position = {u * 2.0f - 1.0f, v * 2.0f - 1.0f, height};
+		vertex.normal = {-std::cos(u * 20.0f), std::sin(v * 20.0f), 1.0f};
+		vertex.uv = {u, v};
+		vertex.color = {static_cast<std::uint8_t>(u * 255.0f),
+						static_cast<std::uint8_t>(v * 255.0f), 128, 255};
+	}
+	return vertices;
+}
+
+static std::int16_t ToSnorm16(float value) {
+	return static_cast<std::int16_t>(std::lround(value * 32767.0f));
+}
+
+static std::vector<PackedVertex> Pack(const std::vector<Vertex> &vertices) {
+	std::vector<PackedVertex> packed(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++) {
+		const Vertex &vertex = vertices[i];
+		std::array<float, 3> n = vertex.normal;
+		float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		packed[i].position = vertex.position;
+		packed[i].normal = {ToSnorm16(n[0] / length),
+							ToSnorm16(n[1] / length),
+							ToSnorm16(n[2] / length), 0};
+		packed[i].uv = {
+			static_cast<std::uint16_t>(std::lround(vertex.uv[0] * 65535.0f)),
+			static_cast<std::uint16_t>(std::lround(vertex.uv[1] * 65535.0f))};
+		packed[i].color = vertex.color;
+	}
+	return packed;
+}
+
+// Splits an interleaved attribute out into its own array
+template <typename T, typename Member>
+static std::vector<T> Extract(const std::vector<Vertex> &vertices,
+							  Member Vertex::*member) {
+	std::vector<T> values;
+	values.reserve(vertices.size());
+	for (const Vertex &vertex : vertices)
+		values.push_back(vertex.*member);
+	return values;
+}
+
+template <typename T>
+static VertexBuffer MakeBuffer(const std::vector<T> &values) {
+	return {values.data(),
+			static_cast<unsigned int>(values.size() * sizeof(T))};
+}
+
+int main(int argc, char **argv) {
+	FrameBenchmark bench(argc, argv);
+	std::string_view layout = GetArgString(argc, argv, "--layout=", "aos");
+	size_t vertexCount = GetArgValue(argc, argv, "--vertices=", 1000000);
+	unsigned long draws = GetArgValue(argc, argv, "--draws=", 8);
+	if (layout != "aos" && layout != "soa" && layout != "packed") {
+		std::cerr << "Unknown layout " << layout << std::endl;
+		return -1;
+	}
+
+	BenchContext context(argc, argv, bench, "Bench-VertexLayout", 4, 1);
+	if (!context.isValid())
+		return -1;
+	GLFWObjects::Window &window = context.getWindow();
+	glfwSwapInterval(0);
+
+	ShaderLibrary shaderLibrary;
+	std::optional<ShaderSource> source =
+		shaderLibrary.parse("res/shaders/VertexFetch.shader");
+	if (!source)
+		return -1;
+	Shader shader(CreateProgram(source->str(ShaderStage::VERTEX),
+								source->str(ShaderStage::FRAGMENT)));
+	if (shader.GetRendererID() == 0)
+		return -1;
+
+	std::vector<Vertex> mesh = GenerateMesh(vertexCount);
+	VertexArray va;
+	std::vector<VertexBuffer> buffers;
+	buffers.reserve(VertexLayoutAoS::attributeCount);
+	size_t vertexSize = 0;
+	if (layout == "aos") {
+		buffers.push_back(MakeBuffer(mesh));
+		va.addBuffer<VertexLayoutAoS>(buffers[0]);
+		vertexSize = VertexLayoutAoS::stride;
+	} else if (layout == "soa") {
+		buffers.push_back(
+			MakeBuffer(Extract<std::array<float, 3>>(mesh, &Vertex::position)));
+		buffers.push_back(
+			MakeBuffer(Extract<std::array<float, 3>>(mesh, &Vertex::normal)));
+		buffers.push_back(
+			MakeBuffer(Extract<std::array<float, 2>>(mesh, &Vertex::uv)));
+		buffers.push_back(MakeBuffer(
+			Extract<std::array<std::uint8_t, 4>>(mesh, &Vertex::color)));
+		va.addBuffers<VertexLayoutAoS>(
+			{&buffers[0], &buffers[1], &buffers[2], &buffers[3]});
+		for (const VertexAttribute &attribute : VertexLayoutAoS::attributes)
+			vertexSize += attribute.size;
+	} else {
+		buffers.push_back(MakeBuffer(Pack(mesh)));
+		va.addBuffer<PackedVertexLayout>(buffers[0]);
+		vertexSize = PackedVertexLayout::stride;
+	}
+	mesh = {};
+
+	// Only the vertex stage matters here
+	GLCall(glEnable(GL_RASTERIZER_DISCARD));
+	shader.bind();
+	va.bind();
+
+	GLState &state = GLState::get();
+	while (!window.shouldClose() && !bench.isDone()) {
+		for (unsigned long i = 0; i < draws; i++) {
+			GLCall(glDrawArrays(GL_POINTS, 0,
+								static_cast<GLsizei>(vertexCount)));
+		}
+
+		window.swapBuffers();
+		bench.endFrame();
+		state.endFrame();
+		glfwPollEvents();
+	}
+
+	bench.report(std::cout);
+	std::cout << "{\"layout\": \"" << layout
+			  << "\", \"bytes_per_vertex\": " << vertexSize
+			  << ", \"vertices\": " << vertexCount << ", \"draws\": " << draws
+			  << ", \"mb_per_frame\": "
+			  << static_cast<double>(vertexSize * vertexCount * draws) /
+					 (1 << 20)
+			  << "}" << std::endl;
+	return 0;
+}
@@ -2,12 +2,16 @@
 #include <glbinding/gl/gl.h>
 #include <glbinding/glbinding.h>
 #define GLFW_INCLUDE_NONE
-#include <GLFW/glfw3.h>
+#include "pr_glfw.h"
 // clang-format on
+#include "benchmark.h"
 #include "debugbreak.h"
+#include "framebuffer.h"
+#include "profiler.h"
 #include <array>
 #include <fstream>
 #include <iostream>
+#include <optional>
 #include <sstream>
 
 #define ASSERT(x)                                                              \
@@ -182,29 +186,47 @@ static GLuint CreateProgram(const std::string &vertexShaderSrc,
 	return program;
 }
 
-int main() {
-	GLFWwindow *window = nullptr;
+int main(int argc, char **argv) {
+	GLFWObjects::LaunchOptions options =
+		GLFWObjects::LaunchOptions::parse(argc, argv);
+	FrameBenchmark bench(argc, argv);
 
 	/* Initialize the library */
-	if (!glfwInit())
+	GLFWObjects::GLFW &glfw = GLFWObjects::GLFW::getInstance();
+	if (!glfw.init(options.backend))
 		return -1;
 
 	/* Create a windowed mode window and its OpenGL context */
-	window = glfwCreateWindow(640, 480, "Hello World", nullptr, nullptr);
-	if (!window) {
-		glfwTerminate();
+	GLFWObjects::Window window(640, 480, "Hello World");
+	if (!window.isValid())
 		return -1;
-	}
+	// The benchmark decides when to stop on its own
+	window.setFrameLimit(bench.isEnabled() ? 0 : options.frameLimit);
 
 	/* Make the window's context current */
-	glfwMakeContextCurrent(window);
+	glfw.makeContextCurrent(window);
+
+	// Vsync would cap the benchmark at the monitor's refresh rate
+	if (bench.isEnabled())
+		glfwSwapInterval(0);
 
 	glbinding::initialize(glfwGetProcAddress);
 
-	std::cout << glGetString(GL_VERSION) << std::endl;
+	std::cerr << glGetString(GL_VERSION) << std::endl;
+
+	Profiler &profiler = Profiler::getInstance();
+	if (!options.tracePath.empty())
+		profiler.enable(options.tracePath);
 
 	GLCall(glViewport(0, 0, 640, 480));
-	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	window.setFramebufferSizeCallback(framebuffer_size_callback);
+
+	// There's no default framebuffer to draw into when running headless
+	std::optional<Framebuffer> offscreen;
+	if (window.isHeadless()) {
+		offscreen.emplace(640, 480);
+		offscreen->bind();
+	}
 
 	// Create a vertex buffer in the ram
 	std::array<GLfloat, 12> vertex_pos{
@@ -256,24 +278,40 @@ int main() {
 	GLCall(glUseProgram(program));
 
 	/* Loop until the user closes the window */
-	while (!glfwWindowShouldClose(window)) {
+	while (!window.shouldClose() && !bench.isDone()) {
+		PROFILE_ZONE("Frame");
+
 		/* Render here */
-		GLCall(glClear(GL_COLOR_BUFFER_BIT));
+		{
+			PROFILE_GPU_ZONE("Clear");
+			GLCall(glClear(GL_COLOR_BUFFER_BIT));
+		}
 
 		// This is for the case when using index buffers
-		GLCall(glDrawElements(
-			GL_TRIANGLES, vertex_indices.size(), GLenum::GL_INT,
-			nullptr)); // Last arguments is null since we already bound the ibo
+		{
+			PROFILE_GPU_ZONE("Draw quad");
+			// Last arguments is null since we already bound the ibo
+			GLCall(glDrawElements(
+				GL_TRIANGLES, vertex_indices.size(), GLenum::GL_INT,
+				nullptr));
+		}
 
 		/* Swap front and back buffers */
-		glfwSwapBuffers(window);
+		{
+			PROFILE_ZONE("Swap buffers");
+			window.swapBuffers();
+		}
+		bench.endFrame();
+		profiler.endFrame();
 
 		/* Poll for and process events */
 		glfwPollEvents();
 	}
 
+	bench.report(std::cout);
+	profiler.writeTrace();
+
 	// TODO: Need to cleanup shaders as well
 	GLCall(glDeleteProgram(program));
-	glfwTerminate();
 	return 0;
 }
\ No newline at end of file
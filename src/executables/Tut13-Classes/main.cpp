@@ -2,15 +2,20 @@
 #include <glbinding/gl/gl.h>
 #include <glbinding/glbinding.h>
 #define GLFW_INCLUDE_NONE
-#include <GLFW/glfw3.h>
+#include "pr_glfw.h"
 // clang-format on
 #include <array>
 #include <fstream>
 #include <iostream>
+#include <optional>
 #include <sstream>
 
+#include "benchmark.h"
+#include "framebuffer.h"
 #include "indexbuffer.h"
+#include "profiler.h"
 #include "renderer.h"
+#include "shader.h"
 #include "vertexbuffer.h"
 
 // Documentation website: docs.gl
@@ -106,11 +111,14 @@ static GLuint CreateProgram(const std::string &vertexShaderSrc,
 	return program;
 }
 
-int main() {
-	GLFWwindow *window = nullptr;
+int main(int argc, char **argv) {
+	GLFWObjects::LaunchOptions options =
+		GLFWObjects::LaunchOptions::parse(argc, argv);
+	FrameBenchmark bench(argc, argv);
 
 	/* Initialize the library */
-	if (!glfwInit())
+	GLFWObjects::GLFW &glfw = GLFWObjects::GLFW::getInstance();
+	if (!glfw.init(options.backend))
 		return -1;
 
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -119,23 +127,35 @@ int main() {
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
 	/* Create a windowed mode window and its OpenGL context */
-	window = glfwCreateWindow(640, 480, "Hello World", nullptr, nullptr);
-	if (!window) {
-		glfwTerminate();
+	GLFWObjects::Window window(640, 480, "Hello World");
+	if (!window.isValid())
 		return -1;
-	}
+	// The benchmark decides when to stop on its own
+	window.setFrameLimit(bench.isEnabled() ? 0 : options.frameLimit);
 
 	/* Make the window's context current */
-	glfwMakeContextCurrent(window);
+	glfw.makeContextCurrent(window);
 
-	glfwSwapInterval(1);
+	// Vsync would cap the benchmark at the monitor's refresh rate
+	glfwSwapInterval(bench.isEnabled() ? 0 : 1);
 
 	glbinding::initialize(glfwGetProcAddress);
 
-	std::cout << glGetString(GL_VERSION) << std::endl;
+	std::cerr << glGetString(GL_VERSION) << std::endl;
+
+	Profiler &profiler = Profiler::getInstance();
+	if (!options.tracePath.empty())
+		profiler.enable(options.tracePath);
 
 	GLCall(glViewport(0, 0, 640, 480));
-	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	window.setFramebufferSizeCallback(framebuffer_size_callback);
+
+	// There's no default framebuffer to draw into when running headless
+	std::optional<Framebuffer> offscreen;
+	if (window.isHeadless()) {
+		offscreen.emplace(640, 480);
+		offscreen->bind();
+	}
 
 	// Create a vertex buffer in the ram
 	std::array<GLfloat, 12> vertex_pos{
@@ -155,15 +175,20 @@ int main() {
 		// clang-format on
 	};
 
+	// Binds go through the state cache so the ones that don't change anything
+	// are skipped
+	GLState &state = GLState::get();
+
 	GLuint vao = 0;
 	GLCall(glGenVertexArrays(1, &vao));
-	GLCall(glBindVertexArray(vao));
+	state.bindVertexArray(vao);
 
 	VertexBuffer vb(vertex_pos.data(),
 					vertex_pos.size() *
 						sizeof(decltype(vertex_pos)::value_type));
 
 	// Set the vertex attributes for the bound buffer
+	vb.bind();
 	GLCall(glEnableVertexAttribArray(0));
 	// This is where the vertex buffer is bound to the currently bound vao
 	GLCall(glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat),
@@ -173,40 +198,47 @@ int main() {
 
 	auto [vertexShaderSrc, fragmentShaderSrc] =
 		ParseShader("res/shaders/Basic.shader");
-	GLuint program = CreateProgram(vertexShaderSrc, fragmentShaderSrc);
-	GLCall(glUseProgram(program));
-
-	// We need to have a shader that is bound to set a uniform
+	Shader shader(CreateProgram(vertexShaderSrc, fragmentShaderSrc));
 
-	// Once the shader is created every uniform gets assigned an id
-	// so we need to retrieve this id
-	int colorUniformLocation =
-		GLCallV(glGetUniformLocation(program, "u_Color"));
-	ASSERT(colorUniformLocation != -1);
+	// Once the shader is created every uniform gets assigned an id. Shader
+	// looks them all up right after linking, so setting one later only
+	// compares the name's hash, which is computed here at compile time.
+	static constexpr UniformName kColor("u_Color");
+	ASSERT(shader.getUniformLocation(kColor) != -1);
 
 	// Unbind all objects
-	GLCall(glBindVertexArray(0));
-	GLCall(glUseProgram(0));
-	GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
-	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+	state.bindVertexArray(0);
+	state.useProgram(0);
+	state.bindBuffer(GL_ARRAY_BUFFER, 0);
+	state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
 	float r = 0.0f;
 	float increment = 0.01f;
 	/* Loop until the user closes the window */
-	while (!glfwWindowShouldClose(window)) {
+	while (!window.shouldClose() && !bench.isDone()) {
+		PROFILE_ZONE("Frame");
+
 		/* Render here */
-		GLCall(glClear(GL_COLOR_BUFFER_BIT));
+		{
+			PROFILE_GPU_ZONE("Clear");
+			GLCall(glClear(GL_COLOR_BUFFER_BIT));
+		}
 
-		GLCall(glUseProgram(program));
-		GLCall(glUniform4f(colorUniformLocation, r, 0.3f, 0.8f, 1.0f));
+		// We need to have a shader that is bound to set a uniform
+		shader.bind();
+		shader.setUniform(kColor, r, 0.3f, 0.8f, 1.0f);
 
-		GLCall(glBindVertexArray(vao));
+		state.bindVertexArray(vao);
 		ib.bind();
 
 		// This is for the case when using index buffers
-		GLCall(glDrawElements(
-			GL_TRIANGLES, vertex_indices.size(), GLenum::GL_UNSIGNED_INT,
-			nullptr)); // Last arguments is null since we already bound the ibo
+		// The index buffer picks its own index type
+		{
+			PROFILE_GPU_ZONE("Draw quad");
+			// Last arguments is null since we already bound the ibo
+			GLCall(glDrawElements(GL_TRIANGLES, ib.GetCount(), ib.GetType(),
+								  nullptr));
+		}
 
 		if (r > 1.0f || r < 0.0f)
 			increment = -increment;
@@ -214,14 +246,30 @@ int main() {
 		r += increment;
 
 		/* Swap front and back buffers */
-		glfwSwapBuffers(window);
+		{
+			PROFILE_ZONE("Swap buffers");
+			window.swapBuffers();
+		}
+		bench.endFrame();
+		state.endFrame();
+		profiler.endFrame();
 
 		/* Poll for and process events */
 		glfwPollEvents();
 	}
 
-	// TODO: Need to cleanup shaders as well
-	GLCall(glDeleteProgram(program));
-	glfwTerminate();
+	bench.report(std::cout);
+	profiler.writeTrace();
+
+	const GLState::Stats &stateStats = state.getTotalStats();
+	std::cerr << "State changes: " << stateStats.issued << " issued, "
+			  << stateStats.elided << " elided, last frame "
+			  << state.getLastFrameStats().issued << " issued, "
+			  << state.getLastFrameStats().elided << " elided" << std::endl;
+	const Shader::Stats &uniformStats = shader.getStats();
+	std::cerr << "Uniform uploads: " << uniformStats.issued << " issued, "
+			  << uniformStats.skipped << " skipped" << std::endl;
+
+	// The Shader deletes its program
 	return 0;
 }
\ No newline at end of file
@@ -5,12 +5,19 @@
 #include "pr_glfw.h"
 // clang-format on
 #include <array>
-#include <fstream>
 #include <iostream>
-#include <sstream>
+#include <optional>
 
+#include "benchmark.h"
+#include "framebuffer.h"
 #include "indexbuffer.h"
+#include "profiler.h"
+#include "programcache.h"
 #include "renderer.h"
+#include "shader.h"
+#include "shaderreloader.h"
+#include "shadersource.h"
+#include "vertexarray.h"
 #include "vertexbuffer.h"
 
 // Documentation website: docs.gl
@@ -19,103 +26,28 @@
 
 using namespace gl;
 
-struct ShaderProgramSource {
-	std::string vertexSource;
-	std::string fragmentSource;
-};
-
-static ShaderProgramSource ParseShader(const std::string &filePath) {
-	std::ifstream stream(filePath);
-
-	enum class ShaderType { NONE = -1, VERTEX, FRAGMENT };
-
-	std::string line;
-	std::array<std::stringstream, 2> ss;
-	ShaderType shaderType = ShaderType::NONE;
-
-	while (std::getline(stream, line)) {
-		if (line.find("#shader") != std::string::npos) {
-			if (line.find("vertex") != std::string::npos) {
-				// set mode to vertex
-				shaderType = ShaderType::VERTEX;
-			} else if (line.find("fragment") != std::string::npos) {
-				// set mode to fragment
-				shaderType = ShaderType::FRAGMENT;
-			}
-		} else {
-			ss.at(int(shaderType)) << line << std::endl;
-		}
-	}
-
-	return {ss[0].str(), ss[1].str()};
-}
-
 void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
 	glViewport(0, 0, width, height);
 }
 
-static GLuint CompileShader(gl::GLenum type, const std::string &source) {
-	GLuint id = GLCallV(glCreateShader(type));
-	const char *const src = source.c_str();
-	GLCall(glShaderSource(id, 1, &src, nullptr));
-	GLCall(glCompileShader(id));
-
-	// Retrieve the result of the compilation
-	GLboolean result = 0;
-	GLCall(glGetShaderiv(id, GL_COMPILE_STATUS, &result));
-	if (result == GL_FALSE) {
-		// Shader didn't compile successfully
-		// Query the error message's length
-		int length = -1;
-		GLCall(glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length));
-		// NOLINTNEXTLINE
-		char *message = (char *)alloca((unsigned int)length * sizeof(char));
-		// Returns the information log for a shader object
-		GLCall(glGetShaderInfoLog(id, length, nullptr, message));
-		std::cerr << "Failed to compile "
-				  << (type == GL_VERTEX_SHADER ? "vertex" : "fragment")
-				  << " shader!" << std::endl
-				  << message << std::endl;
-		GLCall(glDeleteShader(id));
-		return 0;
-	}
-
-	return id;
-}
-
-// Compile the two shaders and link them together into a single program and
-// return its id
-static GLuint CreateProgram(const std::string &vertexShaderSrc,
-							const std::string &fragmentShaderSrc) {
-	GLuint program = GLCallV(glCreateProgram());
+int main(int argc, char **argv) {
+	GLFWObjects::LaunchOptions options =
+		GLFWObjects::LaunchOptions::parse(argc, argv);
+	FrameBenchmark bench(argc, argv);
+	GLDebugMode debugMode = GLDebugModeFromArgs(argc, argv);
 
-	// Create the two shader objects
-	GLuint vs = CompileShader(GL_VERTEX_SHADER, vertexShaderSrc);
-	GLuint fs = CompileShader(GL_FRAGMENT_SHADER, fragmentShaderSrc);
-
-	// TODO: Error handling
-
-	GLCall(glAttachShader(program, vs));
-	GLCall(glAttachShader(program, fs));
-	GLCall(glLinkProgram(program));
-	GLCall(glValidateProgram(program));
-
-	GLCall(glDeleteShader(vs));
-	GLCall(glDeleteShader(fs));
-
-	return program;
-}
-
-int main() {
 	/* Initialize glfw */
 	GLFWObjects::GLFW &glfw = GLFWObjects::GLFW::getInstance();
-	if (!glfw.init())
+	if (!glfw.init(options.backend))
 		return -1;
 
 	glfw.setWindowHint(GLFWObjects::GLFW::WindowHint::CONTEXT_VERSION_MAJOR, 3);
 	glfw.setWindowHint(GLFWObjects::GLFW::WindowHint::CONTEXT_VERSION_MINOR, 3);
 	// glfw.setWindowHint(GLFWObjects::GLFW::WindowHint::OPENGL_PROFILE,
 	// 				   GLFWObjects::GLFW::OpenGL_Profile::OPENGL_CORE_PROFILE);
+	// Most drivers only produce debug messages for debug contexts
+	glfw.setWindowHint(GLFWObjects::GLFW::WindowHint::OPENGL_DEBUG_CONTEXT,
+					   debugMode != GLDebugMode::OFF);
 
 	/* Create a windowed mode window and its OpenGL context */
 	GLFWObjects::Window window(640, 480, "Hello World");
@@ -123,19 +55,48 @@ int main() {
 		glfwTerminate();
 		return -1;
 	}
+	// The benchmark decides when to stop on its own
+	window.setFrameLimit(bench.isEnabled() ? 0 : options.frameLimit);
 
 	/* Make the window's context current */
 	glfw.makeContextCurrent(window);
 
-	glfwSwapInterval(1);
+	// Vsync would cap the benchmark at the monitor's refresh rate
+	glfwSwapInterval(bench.isEnabled() ? 0 : 1);
 
 	glbinding::initialize(glfwGetProcAddress);
 
-	std::cout << glGetString(GL_VERSION) << std::endl;
+	std::cerr << glGetString(GL_VERSION) << std::endl;
+
+	GLDebugInit(debugMode);
+
+	Profiler &profiler = Profiler::getInstance();
+	if (!options.tracePath.empty())
+		profiler.enable(options.tracePath);
 
 	GLCall(glViewport(0, 0, 640, 480));
 	window.setFramebufferSizeCallback(framebuffer_size_callback);
 
+	// There's no default framebuffer to draw into when running headless
+	std::optional<Framebuffer> offscreen;
+	if (window.isHeadless()) {
+		offscreen.emplace(640, 480);
+		offscreen->bind();
+	}
+
+	// Start building the shaders first so the driver can compile them while
+	// the buffers are being created
+	ShaderLibrary shaderLibrary;
+	std::optional<ShaderSource> shaderSource =
+		shaderLibrary.parse("res/shaders/Basic.shader");
+	if (!shaderSource)
+		return -1;
+	// Compiled programs are kept next to the executable between runs
+	ProgramCache programCache("shadercache");
+	ProgramCache::Request programRequest =
+		programCache.request(shaderSource->str(ShaderStage::VERTEX),
+							 shaderSource->str(ShaderStage::FRAGMENT));
+
 	// Create a vertex buffer in the ram
 	std::array<GLfloat, 12> vertex_pos{
 		// clang-format off
@@ -146,66 +107,83 @@ int main() {
 		// clang-format on
 	};
 
-	// CPU index buffer
-	std::array<GLuint, 6> vertex_indices{
+	// CPU index buffer, the quad as two triangle strips. The largest value
+	// of the type restarts the strip.
+	std::array<GLushort, 7> vertex_indices{
 		// clang-format off
-		0, 1, 2,
-		2, 3, 0
+		0, 1, 3,
+		0xffff,
+		1, 2, 3
 		// clang-format on
 	};
 
-	GLuint vao = 0;
-	GLCall(glGenVertexArrays(1, &vao));
-	GLCall(glBindVertexArray(vao));
+	// Binds go through the state cache so the ones that don't change anything
+	// are skipped
+	GLState &state = GLState::get();
 
+	VertexArray va;
 	VertexBuffer vb(vertex_pos.data(),
 					vertex_pos.size() *
 						sizeof(decltype(vertex_pos)::value_type));
+	// A 2D position per vertex, the strides and offsets are worked out at
+	// compile time
+	va.addBuffer<VertexLayout<Attr<float, 2>>>(vb);
+
+	// Only 4 vertices, so the indices get stored as bytes, with 0xff as the
+	// restart marker
+	IndexBuffer ib(vertex_indices, 4, true);
+	va.setIndexBuffer(ib);
+
+	GLuint program = programCache.finish(programRequest);
+	programCache.printStats(std::cerr);
+	if (program == 0)
+		return -1;
 
-	// Set the vertex attributes for the bound buffer
-	GLCall(glEnableVertexAttribArray(0));
-	// This is where the vertex buffer is bound to the currently bound vao
-	GLCall(glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat),
-								 (const void *)0)); // NOLINT
-
-	IndexBuffer ib(vertex_indices.data(), vertex_indices.size());
-
-	auto [vertexShaderSrc, fragmentShaderSrc] =
-		ParseShader("res/shaders/Basic.shader");
-	GLuint program = CreateProgram(vertexShaderSrc, fragmentShaderSrc);
-	GLCall(glUseProgram(program));
-
-	// We need to have a shader that is bound to set a uniform
-
-	// Once the shader is created every uniform gets assigned an id
-	// so we need to retrieve this id
-	int colorUniformLocation =
-		GLCallV(glGetUniformLocation(program, "u_Color"));
-	ASSERT(colorUniformLocation != -1);
+	std::optional<ShaderReloader> reloader;
+	ShaderReloader::Handle basicShader = 0;
+	if (options.hotReload) {
+		reloader.emplace(window);
+		basicShader = reloader->watch("res/shaders/Basic.shader", program);
+		reloader->start();
+	}
+	// The shader looks all its uniforms up once, so there's no need to keep
+	// their locations around, and the name is hashed at compile time
+	Shader shader(program);
+	static constexpr UniformName kColor("u_Color");
+	ASSERT(shader.getUniformLocation(kColor) != -1);
 
 	// Unbind all objects
-	GLCall(glBindVertexArray(0));
-	GLCall(glUseProgram(0));
-	GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
-	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+	state.bindVertexArray(0);
+	state.useProgram(0);
+	state.bindBuffer(GL_ARRAY_BUFFER, 0);
+	state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
 	float r = 0.0f;
 	float increment = 0.01f;
 	/* Loop until the user closes the window */
-	while (!window.shouldClose()) {
-		/* Render here */
-		GLCall(glClear(GL_COLOR_BUFFER_BIT));
+	while (!window.shouldClose() && !bench.isDone()) {
+		PROFILE_ZONE("Frame");
 
-		GLCall(glUseProgram(program));
-		GLCall(glUniform4f(colorUniformLocation, r, 0.3f, 0.8f, 1.0f));
+		// Swap in the rebuilt shaders at the start of the frame
+		if (reloader && reloader->update())
+			shader.reload(reloader->getProgram(basicShader));
 
-		GLCall(glBindVertexArray(vao));
-		ib.bind();
+		/* Render here */
+		{
+			PROFILE_GPU_ZONE("Clear");
+			GLCall(glClear(GL_COLOR_BUFFER_BIT));
+		}
+
+		shader.bind();
+		shader.setUniform(kColor, r, 0.3f, 0.8f, 1.0f);
 
 		// This is for the case when using index buffers
-		GLCall(glDrawElements(
-			GL_TRIANGLES, vertex_indices.size(), GLenum::GL_UNSIGNED_INT,
-			nullptr)); // Last arguments is null since we already bound the ibo
+		{
+			PROFILE_GPU_ZONE("Draw quad");
+			// Binds the VAO, turns primitive restart on and draws with the
+			// index buffer's own index type
+			va.draw(ib, 0, GL_TRIANGLE_STRIP);
+		}
 
 		if (r > 1.0f || r < 0.0f)
 			increment = -increment;
@@ -213,13 +191,30 @@ int main() {
 		r += increment;
 
 		/* Swap front and back buffers */
-		window.swapBuffers();
+		{
+			PROFILE_ZONE("Swap buffers");
+			window.swapBuffers();
+		}
+		bench.endFrame();
+		state.endFrame();
+		profiler.endFrame();
 
 		/* Poll for and process events */
 		glfwPollEvents();
 	}
 
-	// TODO: Need to cleanup shaders as well
-	GLCall(glDeleteProgram(program));
+	bench.report(std::cout);
+
+	const GLState::Stats &stateStats = state.getTotalStats();
+	std::cerr << "State changes: " << stateStats.issued << " issued, "
+			  << stateStats.elided << " elided, last frame "
+			  << state.getLastFrameStats().issued << " issued, "
+			  << state.getLastFrameStats().elided << " elided" << std::endl;
+	profiler.writeTrace();
+
+	const Shader::Stats &uniformStats = shader.getStats();
+	std::cerr << "Uniform uploads: " << uniformStats.issued << " issued, "
+			  << uniformStats.skipped << " skipped" << std::endl;
+
 	return 0;
 }
\ No newline at end of file
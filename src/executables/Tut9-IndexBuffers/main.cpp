@@ -2,11 +2,15 @@
 #include <glbinding/gl/gl.h>
 #include <glbinding/glbinding.h>
 #define GLFW_INCLUDE_NONE
-#include <GLFW/glfw3.h>
+#include "pr_glfw.h"
 // clang-format on
+#include "benchmark.h"
+#include "framebuffer.h"
+#include "profiler.h"
 #include <array>
 #include <fstream>
 #include <iostream>
+#include <optional>
 #include <sstream>
 
 // Documentation website: docs.gl
@@ -104,29 +108,47 @@ static GLuint CreateProgram(const std::string &vertexShaderSrc,
 	return program;
 }
 
-int main() {
-	GLFWwindow *window = nullptr;
+int main(int argc, char **argv) {
+	GLFWObjects::LaunchOptions options =
+		GLFWObjects::LaunchOptions::parse(argc, argv);
+	FrameBenchmark bench(argc, argv);
 
 	/* Initialize the library */
-	if (!glfwInit())
+	GLFWObjects::GLFW &glfw = GLFWObjects::GLFW::getInstance();
+	if (!glfw.init(options.backend))
 		return -1;
 
 	/* Create a windowed mode window and its OpenGL context */
-	window = glfwCreateWindow(640, 480, "Hello World", nullptr, nullptr);
-	if (!window) {
-		glfwTerminate();
+	GLFWObjects::Window window(640, 480, "Hello World");
+	if (!window.isValid())
 		return -1;
-	}
+	// The benchmark decides when to stop on its own
+	window.setFrameLimit(bench.isEnabled() ? 0 : options.frameLimit);
 
 	/* Make the window's context current */
-	glfwMakeContextCurrent(window);
+	glfw.makeContextCurrent(window);
+
+	// Vsync would cap the benchmark at the monitor's refresh rate
+	if (bench.isEnabled())
+		glfwSwapInterval(0);
 
 	glbinding::initialize(glfwGetProcAddress);
 
-	std::cout << glGetString(GL_VERSION) << std::endl;
+	std::cerr << glGetString(GL_VERSION) << std::endl;
+
+	Profiler &profiler = Profiler::getInstance();
+	if (!options.tracePath.empty())
+		profiler.enable(options.tracePath);
 
 	glViewport(0, 0, 640, 480);
-	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	window.setFramebufferSizeCallback(framebuffer_size_callback);
+
+	// There's no default framebuffer to draw into when running headless
+	std::optional<Framebuffer> offscreen;
+	if (window.isHeadless()) {
+		offscreen.emplace(640, 480);
+		offscreen->bind();
+	}
 
 	// Create a vertex buffer in the ram
 	std::array<GLfloat, 12> vertex_pos{
@@ -173,32 +195,48 @@ int main() {
 
 	auto [vertexShaderSrc, fragmentShaderSrc] =
 		ParseShader("res/shaders/Basic.shader");
-	std::cout << "Vertex shader: " << vertexShaderSrc << std::endl;
+	std::cerr << "Vertex shader: " << vertexShaderSrc << std::endl;
 	GLuint program = CreateProgram(vertexShaderSrc, fragmentShaderSrc);
 	glUseProgram(program);
 
 	/* Loop until the user closes the window */
-	while (!glfwWindowShouldClose(window)) {
+	while (!window.shouldClose() && !bench.isDone()) {
+		PROFILE_ZONE("Frame");
+
 		/* Render here */
-		glClear(GL_COLOR_BUFFER_BIT);
+		{
+			PROFILE_GPU_ZONE("Clear");
+			glClear(GL_COLOR_BUFFER_BIT);
+		}
 
 		// This is for the case with direct vertex data
 		// glDrawArrays(GL_TRIANGLES, 0, vertex_pos.size() / 2);
 
 		// This is for the case when using index buffers
-		glDrawElements(
-			GL_TRIANGLES, vertex_indices.size(), GLenum::GL_UNSIGNED_INT,
-			nullptr); // Last arguments is null since we already bound the ibo
+		{
+			PROFILE_GPU_ZONE("Draw quad");
+			// Last arguments is null since we already bound the ibo
+			glDrawElements(
+				GL_TRIANGLES, vertex_indices.size(), GLenum::GL_UNSIGNED_INT,
+				nullptr);
+		}
 
 		/* Swap front and back buffers */
-		glfwSwapBuffers(window);
+		{
+			PROFILE_ZONE("Swap buffers");
+			window.swapBuffers();
+		}
+		bench.endFrame();
+		profiler.endFrame();
 
 		/* Poll for and process events */
 		glfwPollEvents();
 	}
 
+	bench.report(std::cout);
+	profiler.writeTrace();
+
 	// TODO: Need to cleanup shaders as well
 	glDeleteProgram(program);
-	glfwTerminate();
 	return 0;
 }
\ No newline at end of file